@@ -1,7 +1,7 @@
 #version 430 core
 
-const float near = 0.1;
-const float far = 150.0;
+uniform vec2 u_cameraPlanes;	// Near and far.
+uniform float u_froxelFar;		// Where the slices end, at or before the far plane.
 
 out vec4 FragColour;
 
@@ -15,6 +15,8 @@ layout (std140) uniform Matrices
 
 float lineariseDepth(float depth)
 {
+	const float near = u_cameraPlanes.x, far = u_cameraPlanes.y;
+
 	// Convert depth from range [0,1] to [-1,1]:
 	float z = depth * 2.0 - 1.0;
 	return (2.0 * near * far) / (far + near - z * (far - near));
@@ -33,7 +35,7 @@ vec3 worldToNDC()
 
 float NDCtoUVz(vec3 ndc)
 {
-	const float NUM_FROXEL_SLICES = 64.0;
+	const float near = u_cameraPlanes.x, far = u_cameraPlanes.y;
 
 	float z = ndc.z * 0.5 + 0.5;
 
@@ -41,9 +43,10 @@ float NDCtoUVz(vec3 ndc)
 
 	z = 1.0 / ((1.0 - farOverNear) * z + farOverNear);
 
-	vec2 params = vec2(NUM_FROXEL_SLICES / log2(farOverNear), -(NUM_FROXEL_SLICES * log2(near) / log2(farOverNear)));
+	// Position among the exponentially distributed slices, as a fraction of them all (so whatever their number). Past
+	// the last slice this carries on above 1, so the composite can tell how far beyond them the surface is:
 	float viewZ = z * far;
-	z = max(log2(viewZ) * params.x + params.y, 0.0) / NUM_FROXEL_SLICES;
+	z = max(log2(viewZ / near) / log2(u_froxelFar / near), 0.0);
 	return z;
 }
 
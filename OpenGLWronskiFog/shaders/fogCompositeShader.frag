@@ -16,14 +16,80 @@ layout (std140) uniform Matrices
 
 uniform sampler2D u_colourTex;
 uniform sampler2D u_depthTex;
-uniform sampler3D u_fogAccumTex;
 
-uniform float u_farPlane;
+// With forward fog, the surfaces fog themselves, and this only draws over the sky (at the far plane, with nothing
+// behind it), reading neither the colour nor the depth pass:
+uniform bool  u_skyOnly;
+uniform float u_skyDepth;	// The far plane's slice coordinate.
+
+// Cubic B-spline reconstruction of the cascades, in place of a single trilinear sample, with each column of taps
+// weighted by how close the scene's depth there is to this pixel's (see sampleCascade()):
+uniform bool  u_useTricubic;
+uniform float u_depthSharpness;	// Falloff per slice of depth difference, or 0 for no depth weighting.
+
+float g_pixelDepth;		// This pixel's slice coordinate, within the slices.
 
-const float MAX_FROXEL_DEPTH = 467.5060701;		// Given by FroxelDepth(63), assuming u_fogAccumTex has a z-depth of 64.
-const int	MAX_FROXEL_SLICE_INDEX = 63;		// 
 const float LN_2 = 0.6931471806;				// ln(2).
 
+#include "fogVolumeSampling.glsl"
+
+vec3 getCascadeSize(int cascade)
+{
+	if (cascade == 0)
+		return vec3(textureSize(u_fogAccumTex[0], 0));
+	else if (cascade == 1)
+		return vec3(textureSize(u_fogAccumTex[1], 0));
+	return vec3(textureSize(u_fogAccumTex[2], 0));
+}
+
+// Neighbouring columns whose surfaces are at a different depth, across an edge from this pixel, count for less:
+float getDepthWeight(vec2 xy)
+{
+	if (u_depthSharpness <= 0.0 || u_skyOnly)
+		return 1.0;
+
+	const float difference = abs(min(textureLod(u_depthTex, xy, 0.0).r, 1.0) - g_pixelDepth) * u_totalSlices;
+	return max(exp(-u_depthSharpness * difference), 0.001);
+}
+
+// A cascade's value, either trilinearly filtered, or as a cubic B-spline over 4x4x4 texels. The B-spline's weights are
+// merged pairwise along each axis into 8 trilinear taps (Sigg and Hadwiger, GPU Gems 2, chapt. 20), and each of their
+// 4 columns is also weighted by depth, so fog from across an edge doesn't leak over it:
+vec4 sampleCascade(int cascade, vec3 uvw)
+{
+	if (!u_useTricubic)
+		return fetchCascade(cascade, uvw);
+
+	const vec3 size = getCascadeSize(cascade);
+	const vec3 coord = uvw * size - 0.5;
+	const vec3 index = floor(coord);
+	const vec3 f = coord - index;
+
+	const vec3 w0 = (1.0 - f) * (1.0 - f) * (1.0 - f) / 6.0;
+	const vec3 w1 = (4.0 - 6.0 * f * f + 3.0 * f * f * f) / 6.0;
+	const vec3 w3 = f * f * f / 6.0;
+	const vec3 w2 = 1.0 - w0 - w1 - w3;
+
+	const vec3 g0 = w0 + w1, g1 = w2 + w3;
+	const vec3 p0 = (index - 0.5 + w1 / g0) / size;
+	const vec3 p1 = (index + 1.5 + w3 / g1) / size;
+
+	vec4 result = vec4(0.0);
+	float totalWeight = 0.0;
+	for (int y = 0; y < 2; ++y)
+	{
+		for (int x = 0; x < 2; ++x)
+		{
+			const vec2 xy = vec2(x == 0 ? p0.x : p1.x, y == 0 ? p0.y : p1.y);
+			const float weight = (x == 0 ? g0.x : g1.x) * (y == 0 ? g0.y : g1.y) * getDepthWeight(xy);
+
+			result += weight * (g0.z * fetchCascade(cascade, vec3(xy, p0.z)) + g1.z * fetchCascade(cascade, vec3(xy, p1.z)));
+			totalWeight += weight;
+		}
+	}
+	return result / totalWeight;
+}
+
 float getFroxelSliceIndex(float depth)
 {
 	// Exponential distance distribution -> froxel slice index. Returns the 
@@ -32,16 +98,46 @@ float getFroxelSliceIndex(float depth)
 	return (8.0 * log((depth + 2.0) / 2.0)) / LN_2;
 }
 
+// The world position at a view depth along this pixel's ray:
+vec3 getWorldPos(float viewZ)
+{
+	const float near = u_cameraPlanes.x, far = u_cameraPlanes.y;
+	const float ndcZ = (far + near - 2.0 * far * near / viewZ) / (far - near);
+
+	vec4 world = u_matrices.invViewProj * vec4(2.0 * texCoords - 1.0, ndcZ, 1.0);
+	return world.xyz / world.w;
+}
+
+// The far field along this pixel's ray (see getRayTransmittance()). The slices' last value is integrated up to their far
+// end, so the two meet without a seam:
+float getFarFieldTransmittance(float viewZ)
+{
+	if (viewZ <= u_froxelFar)
+		return 1.0;
+
+	const vec3 start = getWorldPos(u_froxelFar);
+	const vec3 end = getWorldPos(viewZ);
+	return getRayTransmittance(normalize(end - start), distance(u_cameraPos, start), distance(u_cameraPos, end));
+}
+
 void main()
 {
-	const float froxelDepth = texture(u_depthTex, texCoords).r;			// Get linear depth value in [0,1] range.
-	vec3 fogSamplePos = vec3(texCoords, froxelDepth);
+	// Surface depths are slice coordinates, carrying on past 1 beyond the last slice:
+	const float froxelDepth = u_skyOnly ? u_skyDepth : texture(u_depthTex, texCoords).r;
+	vec3 fogSamplePos = vec3(texCoords, min(froxelDepth, 1.0));
+	g_pixelDepth = fogSamplePos.z;
 
-	vec4 sampledFog = texture(u_fogAccumTex, fogSamplePos);
+	vec4 sampledFog = sampleFroxels(fogSamplePos);
 	vec3 inScattering = sampledFog.rgb;
 	float transmittance = sampledFog.a;
 
-	vec3 sourceColour = texture(u_colourTex, texCoords).rgb;
+	if (u_useAnalyticFarFog)
+	{
+		const float near = u_cameraPlanes.x;
+		transmittance *= getFarFieldTransmittance(near * pow(u_froxelFar / near, froxelDepth));
+	}
+
+	vec3 sourceColour = u_skyOnly ? vec3(0.0) : texture(u_colourTex, texCoords).rgb;
 
 	FragColour = vec4(pow(sourceColour * transmittance + inScattering, vec3(1.0 / 2.2)), 1.0);
 }
\ No newline at end of file
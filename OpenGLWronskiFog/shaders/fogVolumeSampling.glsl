@@ -0,0 +1,126 @@
+// Sampling of the accumulated froxel volumes and the far field beyond them, shared by fogCompositeShader.frag and
+// textureShader.frag (for forward fog), which include it (see Shader::readSource()). Each defines sampleCascade(),
+// which is all that differs between them.
+#define NUM_CASCADES 3		// Froxel cascades, App::c_numFroxelCascades.
+
+uniform sampler3D	u_fogAccumTex[NUM_CASCADES];
+uniform sampler3D	u_fogAccumAlphaTex[NUM_CASCADES];	// Transmittance, when kept in volumes of its own.
+uniform bool		u_splitAlpha;
+uniform vec2		u_cascadeSlices[NUM_CASCADES];	// First slice and slice count of each cascade.
+
+// Refined bricks, where they've been allocated (see FroxelBricks.h):
+#define BRICK_RESOLUTION 8	// FroxelBricks::c_brickResolution.
+#define ATLAS_BRICKS 8		// FroxelBricks::c_atlasBricks.
+
+uniform bool		u_useBricks;
+uniform isampler3D	u_brickTable;
+uniform sampler3D	u_brickAtlas;
+uniform vec3		u_brickCellSize;	// In froxel UVW coordinates.
+uniform vec3		u_brickCellGrid;
+
+uniform vec3  u_cameraPos;
+uniform vec2  u_cameraPlanes;	// Near and far.
+uniform float u_froxelFar;		// Where the slices end, at or before the far plane.
+uniform float u_totalSlices;	// Slices in all cascades.
+
+// The far field, from the last slice to the surface or far plane (see getRayTransmittance()):
+uniform bool  u_useAnalyticFarFog;
+uniform float u_farFogExtinction;	// Extinction at full density, at the noise's mean for heterogeneous fog.
+uniform vec2  u_fogHeightRange;		// As fogScatterAbsorbShader.comp's.
+uniform bool  u_useHeightFog;
+
+// A cascade's trilinearly filtered value:
+vec4 fetchCascade(int cascade, vec3 uvw)
+{
+	vec4 result;
+	if (cascade == 0)
+	{
+		result = textureLod(u_fogAccumTex[0], uvw, 0.0);
+		if (u_splitAlpha)
+			result.a = textureLod(u_fogAccumAlphaTex[0], uvw, 0.0).r;
+	}
+	else if (cascade == 1)
+	{
+		result = textureLod(u_fogAccumTex[1], uvw, 0.0);
+		if (u_splitAlpha)
+			result.a = textureLod(u_fogAccumAlphaTex[1], uvw, 0.0).r;
+	}
+	else
+	{
+		result = textureLod(u_fogAccumTex[2], uvw, 0.0);
+		if (u_splitAlpha)
+			result.a = textureLod(u_fogAccumAlphaTex[2], uvw, 0.0).r;
+	}
+	return result;
+}
+
+// Defined by the including shader, either as fetchCascade() or filtering more widely:
+vec4 sampleCascade(int cascade, vec3 uvw);
+
+// Samples the cascaded froxel volume at UVW coordinates spanning all slices. Between the last slice of one cascade
+// and the first of the next, where neither texture can filter, the two slices are blended so there's no seam:
+vec4 sampleFroxelCascades(vec3 uvw)
+{
+	const float slice = uvw.z * u_totalSlices - 0.5;	// Slice k's centre is at k.
+
+	for (int i = 0; i < NUM_CASCADES; ++i)
+	{
+		const float first = u_cascadeSlices[i].x, count = u_cascadeSlices[i].y;
+		if (slice > first + count - 1.0 && i < NUM_CASCADES - 1)
+			continue;
+
+		if (slice >= first || i == 0)
+			return sampleCascade(i, vec3(uvw.xy, (slice - first + 0.5) / count));
+
+		// Between the previous cascade's last slice (at the far edge of its texture) and this cascade's first:
+		return mix(sampleCascade(i - 1, vec3(uvw.xy, 1.0)), sampleCascade(i, vec3(uvw.xy, 0.5 / count)), slice - (first - 1.0));
+	}
+	return vec4(0.0);
+}
+
+// The refined brick's accumulated value, if the cell has one. Its texels sit on the cell's boundaries, so the cell
+// maps onto the brick between the centres of its outermost texels:
+vec4 sampleFroxels(vec3 uvw)
+{
+	if (u_useBricks)
+	{
+		const vec3 cellPos = uvw / u_brickCellSize;
+		const ivec3 cell = ivec3(min(floor(cellPos), u_brickCellGrid - 1.0));
+		const int brick = texelFetch(u_brickTable, cell, 0).r;
+
+		if (brick >= 0)
+		{
+			const ivec3 atlasBrick = ivec3(brick % ATLAS_BRICKS, (brick / ATLAS_BRICKS) % ATLAS_BRICKS, brick / (ATLAS_BRICKS * ATLAS_BRICKS));
+			const vec3 texel = vec3(atlasBrick * BRICK_RESOLUTION) + 0.5 + clamp(cellPos - vec3(cell), 0.0, 1.0) * float(BRICK_RESOLUTION - 1);
+			return textureLod(u_brickAtlas, texel / float(ATLAS_BRICKS * BRICK_RESOLUTION), 0.0);
+		}
+	}
+	return sampleFroxelCascades(uvw);
+}
+
+// Height fog's density factor integrated along a ray from the given height, between distances t0 and t1 along it:
+float integrateHeightFactor(float height, float dirY, float t0, float t1)
+{
+	if (!u_useHeightFog)
+		return t1 - t0;
+
+	const float base = u_fogHeightRange.x, scale = u_fogHeightRange.y;
+	if (abs(dirY) < 0.0001)
+		return exp(-max(height - base, 0.0) / scale) * (t1 - t0);
+
+	// At full density below the base height, so the ray is split where it crosses it:
+	const float tBase = clamp((base - height) / dirY, t0, t1);
+	const vec2 below = dirY > 0.0 ? vec2(t0, tBase) : vec2(tBase, t1);
+	const vec2 above = dirY > 0.0 ? vec2(tBase, t1) : vec2(t0, tBase);
+
+	const vec2 aboveHeights = max(height + dirY * above - base, 0.0);
+	return (below.y - below.x) + scale / dirY * (exp(-aboveHeights.x / scale) - exp(-aboveHeights.y / scale));
+}
+
+// Past the last slice the fog is integrated analytically, as homogeneous fog (thinning with height, if height fog's
+// on). No light is scattered there, as the lights' reach ends well within the slices, so it only attenuates what's
+// behind it. This is the transmittance between distances t0 and t1 along a ray from the camera in direction dir:
+float getRayTransmittance(vec3 dir, float t0, float t1)
+{
+	return exp(-u_farFogExtinction * integrateHeightFactor(u_cameraPos.y, dir.y, t0, t1));
+}
@@ -7,6 +7,7 @@ layout (location = 3) in mat4 instanceMatrix;
 out VS_OUT
 {
 	vec2 texCoords;
+	vec3 worldPos;
 } vs_out;
 
 layout (std140) uniform Matrices
@@ -18,5 +19,6 @@ layout (std140) uniform Matrices
 void main()
 {
 	vs_out.texCoords = aTex;
-	gl_Position = u_Matrices.proj * u_Matrices.view * instanceMatrix * vec4(aPos, 1.0);
+	vs_out.worldPos = (instanceMatrix * vec4(aPos, 1.0)).xyz;
+	gl_Position = u_Matrices.proj * u_Matrices.view * vec4(vs_out.worldPos, 1.0);
 }
\ No newline at end of file
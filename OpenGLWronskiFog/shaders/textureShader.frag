@@ -3,14 +3,62 @@
 in VS_OUT
 {
 	vec2 texCoords;
+	vec3 worldPos;
 } vs_out;
 
 out vec4 FragColour;
 
 uniform sampler2D diffuse;
 
+// Forward fog, applied here rather than composited over the colour pass afterwards, sampling the volumes
+// fogCompositeShader.frag does at this fragment's own depth:
+uniform bool		u_forwardFog;
+uniform vec2		u_screenSize;
+
+#include "fogVolumeSampling.glsl"
+
+// Always trilinear, as there's no depth pass to weight fogCompositeShader.frag's tricubic upsampling against:
+vec4 sampleCascade(int cascade, vec3 uvw)
+{
+	return fetchCascade(cascade, uvw);
+}
+
+// The far field along the ray to this fragment (see getRayTransmittance()):
+float getFarFieldTransmittance(float viewZ)
+{
+	if (viewZ <= u_froxelFar)
+		return 1.0;
+
+	const vec3 dir = normalize(vs_out.worldPos - u_cameraPos);
+	const float end = distance(u_cameraPos, vs_out.worldPos);
+
+	// Distances along a ray are in proportion to view depths:
+	return getRayTransmittance(dir, end * u_froxelFar / viewZ, end);
+}
+
+vec3 applyFog(vec3 colour)
+{
+	// As depthShader.frag writes it, the fragment's depth among the exponentially distributed slices:
+	const float near = u_cameraPlanes.x, far = u_cameraPlanes.y;
+	const float viewZ = (2.0 * near * far) / (far + near - (gl_FragCoord.z * 2.0 - 1.0) * (far - near));
+	const float froxelDepth = max(log2(viewZ / near) / log2(u_froxelFar / near), 0.0);
+
+	const vec4 sampledFog = sampleFroxels(vec3(gl_FragCoord.xy / u_screenSize, min(froxelDepth, 1.0)));
+	float transmittance = sampledFog.a;
+	if (u_useAnalyticFarFog)
+		transmittance *= getFarFieldTransmittance(viewZ);
+
+	return colour * transmittance + sampledFog.rgb;
+}
+
 void main()
 {
 	// TODO: Remove gamma correction-correction and push to some final post-processing stage!
-    FragColour = vec4(pow(texture(diffuse, vs_out.texCoords).rgb, vec3(2.2)), 1.0);
+	vec3 colour = pow(texture(diffuse, vs_out.texCoords).rgb, vec3(2.2));
+
+	// Written straight to the output, so gamma corrected as the composite would:
+	if (u_forwardFog)
+		colour = pow(applyFog(colour), vec3(1.0 / 2.2));
+
+	FragColour = vec4(colour, 1.0);
 }
\ No newline at end of file
@@ -6,6 +6,7 @@ layout (location = 2) in vec2 aTex;
 out VS_OUT
 {
 	vec2 texCoords;
+	vec3 worldPos;
 } vs_out;
 
 uniform mat4 world;
@@ -19,5 +20,6 @@ layout (std140) uniform Matrices
 void main()
 {
 	vs_out.texCoords = aTex;
-	gl_Position = u_Matrices.proj * u_Matrices.view * world * vec4(aPos, 1.0);
+	vs_out.worldPos = (world * vec4(aPos, 1.0)).xyz;
+	gl_Position = u_Matrices.proj * u_Matrices.view * vec4(vs_out.worldPos, 1.0);
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "App.h"
 
+#include <iomanip>
+#include <sstream>
+
 // Define Nvidia Perfkit data:
+#ifdef NV_PERFKIT_ENABLE
 #define NVPM_INITGUID
 #include "NVidiaPerfkit/NvPmApi.Manager.h"
 #include "PerfkitCounters.h"
@@ -8,6 +12,7 @@
 static NvPmApiManager s_NVPMManager;
 NvPmApiManager* getNvPmApiManager() { return &s_NVPMManager; }
 const NvPmApi* getNvPmApi() { return s_NVPMManager.Api(); }
+#endif
 
 // Include Nvidia NSight Perf SDK:
 #ifdef NV_PERF_ENABLE_INSTRUMENTATION
@@ -28,18 +33,40 @@ NVPW_Device_ClockStatus g_clockStatus = NVPW_DEVICE_CLOCK_STATUS_UNKNOWN;	// Use
 
 App::~App()
 {
-	if (m_window)
+	// The simulation thread may be using the job system, so stop it first:
+	m_simulation.stop();
+	JobSystem::shutdown();
+
+	if (m_window || m_headlessContext.isCreated())
 	{
 		// Shutdown ImGui:
-		ImGui_ImplGlfw_Shutdown();
-		ImGui::DestroyContext();
+		if (m_window)
+		{
+			ImGui_ImplGlfw_Shutdown();
+			ImGui::DestroyContext();
+		}
+
+		// Finish writing any captures still in flight:
+		m_frameCapture.shutdown();
+
+		// Delete all OpenGL resources, then report any that were never released:
+		if (m_resourcesCreated)
+		{
+			releaseResources();
+			GPUResourceRegistry::reportLeaks();
+		}
+
+		m_gpuTimer.shutdown();
+		m_framePacer.shutdown();
 
-		// Delete buffers and VAOs:
-		glDeleteVertexArrays(1, &m_fullscreenQuadVAO);
-		glDeleteBuffers(1, &m_fullscreenQuadVBO);
-		glDeleteBuffers(1, &m_asteroidMatricesVBO);
+		// Shutdown the headless context, or GLFW:
+		if (m_headless)
+		{
+			m_headlessContext.shutdown();
+			std::cout << "Headless context destroyed!" << std::endl;
+			return;
+		}
 
-		// Shutdown GLFW:
 		glfwTerminate();
 		std::cout << "GLFW terminated!" << std::endl;
 
@@ -53,6 +80,20 @@ App::~App()
 
 bool App::init(GLuint glfwVersionMaj, GLuint glfwVersionMin)
 {
+	CPUProfiler::setThreadName("Main thread");
+	PROFILE_FUNCTION();
+
+	// Every job is a zone on its worker's track in the CPU profiler's trace:
+	JobSystem::setTimingHook([](const char* name, uint32_t /*worker*/, uint64_t startNs, uint64_t endNs) {
+		if (CPUProfiler::isEnabled())
+			CPUProfiler::recordZone(name, startNs, endNs);
+	});
+	JobSystem::init();
+
+	// Headless, there's no window, GUI or vendor profiler to set up:
+	if (m_headless)
+		return initHeadless(glfwVersionMaj, glfwVersionMin);
+
 	// Initialise GLFW:
 	std::cout << "Initialising GLFW..." << std::endl;
 	if (!glfwInit())
@@ -84,24 +125,6 @@ bool App::init(GLuint glfwVersionMaj, GLuint glfwVersionMin)
 	ImGui_ImplGlfw_InitForOpenGL(m_window, true);
 	ImGui_ImplOpenGL3_Init("#version 130");
 
-	// Initialise light data before Hoobler LUT is generated:
-	for (int i = 0; i < NUM_LIGHTS; ++i)
-	{
-		m_light[i].setPosition(m_pointLightPosition[i]);
-		m_light[i].setDiffuse(m_pointLightDiffuse[i]);
-		m_light[i].setRadius(m_pointLightRadius[i]);
-
-		// Calculate light space matrices:
-		glm::mat4 lightProj = glm::perspective(glm::radians(90.0f), 1.0f, m_lightViewPlanes.x, m_lightViewPlanes.y);
-
-		m_lightSpaceMat[6 * i + 0] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));	// Right	(+ve x)
-		m_lightSpaceMat[6 * i + 1] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));	// Left		(-ve x)
-		m_lightSpaceMat[6 * i + 2] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));	// Up		(+ve y)
-		m_lightSpaceMat[6 * i + 3] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));	// Down		(-ve y)
-		m_lightSpaceMat[6 * i + 4] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));	// Forward	(+ve z)
-		m_lightSpaceMat[6 * i + 5] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));	// Back		(-ve z)
-	}
-
 
 #ifdef NV_PERF_ENABLE_INSTRUMENTATION
 	// Initialise Nvidia NSight Perf SDK:
@@ -114,7 +137,7 @@ bool App::init(GLuint glfwVersionMaj, GLuint glfwVersionMin)
 
 	g_clockStatus = nv::perf::OpenGLGetDeviceClockState();
 	nv::perf::OpenGLSetDeviceClockState(NVPW_DEVICE_CLOCK_SETTING_LOCK_TO_RATED_TDP);
-#else
+#elif defined(NV_PERFKIT_ENABLE)
 	// Initialise Nvidia Perfkit:
 	if (m_profilerUsed == ProfilerUsed::PERFKIT)
 	{
@@ -123,50 +146,195 @@ bool App::init(GLuint glfwVersionMaj, GLuint glfwVersionMin)
 	}
 	else
 		std::cout << "No profiling tools were initialised." << std::endl;
+#else
+	std::cout << "No profiling tools were initialised." << std::endl;
 #endif
 
+	registerBenchmarkParameters();
+
 	return true;
 }
 
 void App::run()
 {
-	setupModelsAndTextures();
-	setupMatrices();
-	setupShaders();
-	setupUBOs();
-	setupFBOs();
-
-	generateLUTs();
+	{
+		PROFILE_SCOPE("Startup");
+		setupModelsAndTextures();
+		setupMatrices();
+		setupShaders();
+		setupUBOs();
+		setupFBOs();
+		updateFroxelGrid();
+
+		generateLUTs();
+		m_gpuTimer.init();
+		m_framePacer.init();
+		m_frameCapture.init();
+		m_resourcesCreated = true;
+	}
+	GPUResourceRegistry::printSummary();
 
 	m_camera.setPosition(0.0f, 1.0f, 3.0f);
 
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 
-	while (!glfwWindowShouldClose(m_window))
+	// Don't let vsync cap frame times while benchmarking unattended:
+	if (m_unattended)
+	{
+		if (!m_headless)
+			glfwSwapInterval(0);
+		m_benchmark.start();
+	}
+
+	const uint64_t runStartNs = CPUProfiler::now();
+	bool finished = false;
+
+	while (!finished && (m_headless || !glfwWindowShouldClose(m_window)))
 	{
-		float currentFrame = glfwGetTime();
+		CPUProfiler::markFrame();
+		uint64_t frameStartNs = CPUProfiler::now();
+
+		// Headless frames advance by a fixed timestep rather than real time:
+		float currentFrame = m_headless ? m_lastFrame + m_headlessSettings.timestep : (float)glfwGetTime();
 		m_dt = currentFrame - m_lastFrame;
 		m_lastFrame = currentFrame;
 
+		// Apply benchmark parameters and camera poses before this frame's update:
+		m_benchmark.beginFrame(m_camera);
+
+		// Scenarios set parameters unchecked, so keep these within the light arrays, and off dividing by zero:
+		m_numActiveLights = (GLuint)glm::clamp((int)m_numActiveLights, 1, NUM_LIGHTS);
+		m_fogHeightRange.y = std::max(m_fogHeightRange.y, 0.01f);
+
+#ifdef NV_PERF_ENABLE_INSTRUMENTATION
+		// Frames spent collecting an Nsight report are slowed by its replay passes, so don't measure them:
+		if (m_benchmark.consumeNsightReportRequest() && !m_headless)
+			g_nvPerfSDKReportGenerator.StartCollectionOnNextFrame(m_benchmark.getRunOutputDir().c_str(), nv::perf::AppendDateTime::no);
+		const bool measureFrame = !g_nvPerfSDKReportGenerator.IsCollectingReport();
+#else
+		const bool measureFrame = true;
+#endif
+		m_gpuTimer.beginFrame(measureFrame ? m_benchmark.getFrameTag() : -1);
+
+		// Wait until the GPU is done with the frame that last used this frame's ring buffer regions:
+		m_framePacer.beginFrame();
+
 		// Input:
-		processInput(m_window, m_dt);
+		if (!m_unattended && !m_headless)
+			processInput(m_window, m_dt);
+
+		// Restart the temporal and jitter sequences with each benchmark run so runs are repeatable:
+		if (m_benchmark.isRunStartFrame())
+		{
+			m_frameIndex = 0;
+			m_evenFrame = true;
+		}
+
+		// Camera tracks advance at their fixed timestep rather than real time:
+		if (const float fixedTimestep = m_benchmark.getFixedTimestep())
+			m_dt = fixedTimestep;
+		updateCameraTrack();
+
 		update(m_dt);
 
 		// Rendering:
 		render();
-		gui();
+
+		// Score the composited frame before the GUI is drawn over it, leaving the (slow) reference out of the frame time:
+		if (measureFrame && m_benchmark.isQualityCaptureFrame())
+		{
+			const uint64_t scoreStartNs = CPUProfiler::now();
+			scoreBenchmarkQuality();
+			frameStartNs += CPUProfiler::now() - scoreStartNs;
+		}
+
+		if (m_froxelFormatErrorRequested)
+		{
+			const uint64_t measureStartNs = CPUProfiler::now();
+			measureFroxelFormatError();
+			frameStartNs += CPUProfiler::now() - measureStartNs;
+			m_froxelFormatErrorRequested = false;
+		}
+
+		// Captures only queue asynchronous readbacks, so unlike scoring they stay in the frame time:
+		if (m_headless)
+			writeHeadlessFrame();
+		if (m_captureRequested || m_captureContinuous)
+		{
+			std::ostringstream prefix;
+			prefix << m_capturePrefix << "_" << std::setw(5) << std::setfill('0') << m_captureIndex++;
+			captureFrame(prefix.str());
+			m_captureRequested = false;
+		}
+		m_frameCapture.update();
+
+		if (!m_unattended && !m_headless)
+			gui();
+
+		// Fence this frame, so its ring buffer regions can be reused c_framesInFlight frames from now:
+		m_framePacer.endFrame();
 
 		// Check and call events, swap the buffers:
-		glfwSwapBuffers(m_window);
-		glfwPollEvents();
+		if (!m_headless)
+		{
+			PROFILE_SCOPE("Swap buffers and poll events");
+			glfwSwapBuffers(m_window);
+			glfwPollEvents();
+		}
+
+		const float frameMs = (CPUProfiler::now() - frameStartNs) / 1000000.0f;
+		if (measureFrame)
+			m_benchmark.endFrame(frameMs, m_gpuTimer);
+
+		if (m_headless)
+		{
+			m_headlessFrameMsTotal += frameMs;
+			++m_headlessFrame;
+		}
+
+		// Close once an unattended benchmark has written its results, or a headless batch has rendered its frames:
+		if (m_unattended)
+			finished = !m_benchmark.isRunning();
+		else if (m_headless)
+			finished = m_headlessFrame >= m_headlessSettings.frames;
+	}
+
+	// Throughput summary, for batch renders and smoke tests:
+	if (m_headless && m_headlessFrame > 0)
+	{
+		const double seconds = (CPUProfiler::now() - runStartNs) / 1000000000.0;
+		std::cout << "Headless run: " << m_headlessFrame << " frames in " << seconds << " s, "
+			<< m_headlessFrameMsTotal / m_headlessFrame << " ms per frame (including image captures), "
+			<< m_headlessFrame / seconds << " frames per second overall." << std::endl;
 	}
 }
 
+void App::setHeadless(const HeadlessSettings& settings)
+{
+	m_headless = true;
+	m_headlessSettings = settings;
+	m_headlessSettings.outputEvery = std::max(settings.outputEvery, 1);
+}
+
+bool App::loadUnattendedBenchmark(const std::string& filePath, const std::string& outputDir)
+{
+	if (!m_benchmark.load(filePath))
+		return false;
+
+	if (!outputDir.empty())
+		m_benchmark.setOutputDir(outputDir);
+
+	m_unattended = true;
+	return true;
+}
+
 void App::processInput(GLFWwindow* window, float dt)
 {
-	// Block keyboard input while running tests:
-	if (!m_currentlyTesting)
+	PROFILE_FUNCTION();
+
+	// Block keyboard input while running benchmarks:
+	if (!m_benchmark.isRunning())
 	{
 		// If ESC is pressed, close the window:
 		if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -241,232 +409,309 @@ void App::processInput(GLFWwindow* window, float dt)
 
 void App::update(float dt)
 {
-	m_planet.setPosition(m_planetPosition);
-	m_planet.scale(2.0f);
+	PROFILE_FUNCTION();
 
-	generateHooblerLUT();
+	// Benchmarks and camera tracks step the simulation once per frame, so their frames are repeatable:
+	const bool threaded = m_threadedSimulation && !m_headless && !m_benchmark.isRunning() && !m_cameraTrack.isRecording() && !m_cameraTrack.isPlaying();
+	const Simulation::Input input = makeSimulationInput();
 
-	for (int i = 0; i < m_numActiveLights; ++i)
+	// The first frame after switching to the simulation thread is stepped here, so there's a snapshot to render:
+	if (threaded && m_simulation.isThreaded())
+	{
+		m_simulation.setInput(input);
+		m_frame = &m_simulation.acquire();
+	}
+	else
 	{
-		m_light[i].setPosition(m_pointLightPosition[i]);
-		m_light[i].setDiffuse(m_pointLightDiffuse[i]);
-		m_light[i].setRadius(m_pointLightRadius[i]);
-
-		// Calculate light space matrices:
-		glm::mat4 lightProj = glm::perspective(glm::radians(90.0f), 1.0f, m_lightViewPlanes.x, m_lightViewPlanes.y);
-
-		m_lightSpaceMat[6 * i + 0] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));	// Right	(+ve x)
-		m_lightSpaceMat[6 * i + 1] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));	// Left		(-ve x)
-		m_lightSpaceMat[6 * i + 2] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));	// Up		(+ve y)
-		m_lightSpaceMat[6 * i + 3] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));	// Down		(-ve y)
-		m_lightSpaceMat[6 * i + 4] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));	// Forward	(+ve z)
-		m_lightSpaceMat[6 * i + 5] = lightProj * glm::lookAt(m_pointLightPosition[i], m_pointLightPosition[i] + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));	// Back		(-ve z)
+		m_simulation.stop();
+		m_frame = &m_simulation.step(input, dt);
+		if (threaded)
+			m_simulation.start(input);
 	}
+	const FrameState& frame = *m_frame;
+
+	// Show the simulated noise offset, remembering it so edits can be told apart from the simulation's:
+	m_noiseOffset = m_simulatedNoiseOffset = frame.noiseOffset;
+
+	m_planet.setPosition(frame.planetPosition);
+	m_planet.scale(2.0f);
+
+	// Cull lights whose radius doesn't reach the view frustum, the renderer only handles the visible ones:
+	{
+		PROFILE_SCOPE("Light culling");
+
+		// The clipmap keeps cells lit by lights outside the view, so it needs them all (and their shadowmaps):
+		if (m_cullLights && !m_useFogClipmap)
+			m_numVisibleLights = frame.lights.cull(m_proj * m_camera.getViewMat(), m_visibleLights);
+		else
+		{
+			m_numVisibleLights = frame.lights.getNumActive();
+			for (int i = 0; i < m_numVisibleLights; ++i)
+				m_visibleLights[i] = i;
+		}
+	}
+
+	m_gpuTimer.begin("Hoobler LUT generation");
+	generateHooblerLUT();
+	m_gpuTimer.end();
+
+	updateFroxelGrid();
 
 	// Set shader uniforms:
 	Renderer::pushDebugGroup(m_uniformUpdateText);
 	{
-		// Set camera data:
+		PROFILE_SCOPE("Shader uniforms update");
+
+		// Set camera data (the camera stays on this thread, so looking around isn't a simulation step behind):
+		for (const Shader* froxelShader : { &m_fogScatterAbsorbShader, &m_fogDensityShader })
+		{
+			froxelShader->use();
+			froxelShader->setVec3("u_cameraPos", m_camera.getPosition());
+			froxelShader->setVec3("u_cameraForward", m_camera.getForward());
+			froxelShader->setVec3("u_cameraUp", m_camera.getUp());
+			froxelShader->setVec3("u_cameraRight", m_camera.getRight());
+			froxelShader->setVec2("u_cameraPlanes", glm::vec2(m_nearPlane, m_farPlane));
+			froxelShader->setFloat("u_froxelFar", getFroxelFarPlane());
+		}
+
+		// Fog and light data are shared with the density, clipmap update, brick classification and visibility shaders:
+		for (const Shader* fogShader : { &m_fogScatterAbsorbShader, &m_fogDensityShader, &m_fogClipmapUpdateShader, &m_froxelBrickClassifyShader, &m_lightVisibilityShader })
+		{
+			fogShader->use();
+
+			// Set fog data:
+			fogShader->setVec3("u_albedo", frame.fogAlbedo);
+			fogShader->setFloat("u_scatteringCoefficient", frame.fogScattering);
+			fogShader->setFloat("u_absorptionCoefficient", frame.fogAbsorption);
+			fogShader->setFloat("u_phaseGParam", frame.fogPhaseGParam);
+			fogShader->setFloat("u_fogDensity", frame.fogDensity);
+			fogShader->setFloat("u_lightIntensity", frame.lightIntensity);
+			fogShader->setBool("u_useHeightFog", frame.useHeightFog);
+			fogShader->setVec2("u_fogHeightRange", frame.fogHeightRange);
+
+			fogShader->setBool("u_useHetFog", frame.useHeterogeneousFog);
+			fogShader->setBool("u_useJitter", frame.useJitter);
+			fogShader->setBool("u_useScreenspaceJitter", frame.useScreenspaceJitter);
+			fogShader->setBool("u_useTemporal", frame.useTemporal);
+			fogShader->setBool("u_useLUT", frame.useLUT);
+			fogShader->setBool("u_KorH", frame.hooblerOrKovalovs);
+			fogShader->setInt("u_shadowMapTechnique", frame.shadowMapTechnique);
+			fogShader->setBool("u_linOrExp", frame.linearOrExpFroxels);
+
+			// Set noise data:
+			fogShader->setFloat("u_noiseFreq", frame.noiseFreq);
+			fogShader->setVec3("u_noiseOffset", frame.noiseOffset);
+			fogShader->setBool("u_useShadows", frame.useShadows);
+
+			// Set light data:
+			for (int i = 0; i < m_numVisibleLights; ++i)
+			{
+				const int index = m_visibleLights[i];
+				PointLight light(frame.lights.getPosition(index), glm::vec3(0.1f), frame.lights.getDiffuse(index), glm::vec3(1.0f), m_pointLightConstant, m_pointLightLinear, m_pointLightQuadratic);
+				light.setRadius(frame.lights.getRadius(index));
+				fogShader->setPointLight(SceneUtils::getArrayUniformName("u_pointLights", i), light);
+			}
+			fogShader->setInt("u_numActiveLights", m_numVisibleLights);
+			fogShader->setVec2("u_lightPlanes", frame.lights.getViewPlanes());
+		}
+
 		m_fogScatterAbsorbShader.use();
-		m_fogScatterAbsorbShader.setVec3("u_cameraPos", m_camera.getPosition());
-		m_fogScatterAbsorbShader.setVec3("u_cameraForward", m_camera.getForward());
-		m_fogScatterAbsorbShader.setVec3("u_cameraUp", m_camera.getUp());
-		m_fogScatterAbsorbShader.setVec3("u_cameraRight", m_camera.getRight());
-		m_fogScatterAbsorbShader.setVec2("u_cameraPlanes", glm::vec2(m_nearPlane, m_farPlane));
-
-		// Set fog data:
-		m_fogScatterAbsorbShader.setVec3("u_albedo", m_fogAlbedo);
-		m_fogScatterAbsorbShader.setFloat("u_scatteringCoefficient", m_fogScattering);
-		m_fogScatterAbsorbShader.setFloat("u_absorptionCoefficient", m_fogAbsorption);
-		m_fogScatterAbsorbShader.setFloat("u_phaseGParam", m_fogPhaseGParam);
-		m_fogScatterAbsorbShader.setFloat("u_fogDensity", m_fogDensity);
-		m_fogScatterAbsorbShader.setFloat("u_lightIntensity", m_lightIntensity);
-
-		m_fogScatterAbsorbShader.setBool("u_useHetFog", m_useHeterogeneousFog);
-		m_fogScatterAbsorbShader.setBool("u_useJitter", m_useJitter);
-		m_fogScatterAbsorbShader.setBool("u_useScreenspaceJitter", m_useScreenspaceJitter);
-		m_fogScatterAbsorbShader.setBool("u_useTemporal", m_useTemporal);
-		m_fogScatterAbsorbShader.setBool("u_useLUT", m_useLUT);
-		m_fogScatterAbsorbShader.setBool("u_KorH", m_hooblerOrKovalovs);
-		m_fogScatterAbsorbShader.setInt("u_shadowMapTechnique", m_shadowMapTechnique);
-		m_fogScatterAbsorbShader.setBool("u_linOrExp", m_linearOrExpFroxels);
-
-		// Set noise data:
-		m_fogScatterAbsorbShader.setFloat("u_noiseFreq", m_noiseFreq);
-
-		m_noiseOffset += m_windDirection * dt;
-		m_fogScatterAbsorbShader.setVec3("u_noiseOffset", m_noiseOffset);
-		m_fogScatterAbsorbShader.setBool("u_useShadows", m_useShadows);
-
-		// Set light data:
-		for (int i = 0; i < m_numActiveLights; ++i)
-			m_fogScatterAbsorbShader.setPointLight("u_pointLights[" + std::to_string(i) + "]", m_light[i]);
-		m_fogScatterAbsorbShader.setInt("u_numActiveLights", m_numActiveLights);
-		m_fogScatterAbsorbShader.setVec2("u_lightPlanes", m_lightViewPlanes);
-		for (int i = 0; i < 6 * m_numActiveLights; ++i)
-			m_fogScatterAbsorbShader.setMat4("u_lightMatrices[" + std::to_string(i) + "]", m_lightSpaceMat[i]);
 		m_fogScatterAbsorbShader.setInt("u_frameIndex", m_frameIndex);
+		m_fogScatterAbsorbShader.setBool("u_historyValid", m_froxelHistoryValid);
+		m_fogScatterAbsorbShader.setInt("u_amortisation", glm::clamp(m_froxelAmortisation, 1, c_maxFroxelAmortisation));
+		m_fogScatterAbsorbShader.setInt("u_amortisationPattern", m_froxelAmortisationPattern);
+		m_fogScatterAbsorbShader.setInt("u_lightSamples", glm::clamp(m_lightSamplesPerFroxel, 0, c_maxLightSamples));
+
+		// The composite and the forward fogged surface shaders sample the accumulated volumes alike:
+		for (const Shader* fogApplyShader : { &m_fogCompositeShader, &m_shader, &m_instanceShader })
+		{
+			fogApplyShader->use();
+			fogApplyShader->setVec3("u_cameraPos", m_camera.getPosition());
+			fogApplyShader->setVec2("u_cameraPlanes", glm::vec2(m_nearPlane, m_farPlane));
+			fogApplyShader->setFloat("u_froxelFar", getFroxelFarPlane());
+			fogApplyShader->setFloat("u_totalSlices", (float)m_fogTexSize.z);
+			fogApplyShader->setBool("u_useBricks", useFroxelBricks());
+			fogApplyShader->setVec2("u_screenSize", glm::vec2(m_windowDim));
+
+			// The far field is homogeneous, at the noise's mean where the fog is heterogeneous:
+			fogApplyShader->setBool("u_useAnalyticFarFog", m_useAnalyticFarFog);
+			fogApplyShader->setFloat("u_farFogExtinction", (frame.fogScattering + frame.fogAbsorption) * frame.fogDensity * (frame.useHeterogeneousFog ? 0.5f : 1.0f));
+			fogApplyShader->setBool("u_useHeightFog", frame.useHeightFog);
+			fogApplyShader->setVec2("u_fogHeightRange", frame.fogHeightRange);
+		}
 
+		// Only the composite has the scene's depth to weight the upsampling by:
 		m_fogCompositeShader.use();
-		m_fogCompositeShader.setFloat("u_farPlane", m_farPlane);
+		m_fogCompositeShader.setBool("u_useTricubic", m_useTricubicFog);
+		m_fogCompositeShader.setFloat("u_depthSharpness", m_fogUpsampleDepthSharpness);
+
+		m_froxelBrickClassifyShader.use();
+		m_froxelBrickClassifyShader.setVec2("u_cameraPlanes", glm::vec2(m_nearPlane, m_farPlane));
+		m_froxelBrickClassifyShader.setFloat("u_froxelFar", getFroxelFarPlane());
+		m_froxelBrickClassifyShader.setFloat("u_densityGradientThreshold", m_brickDensityThreshold);
+
+		m_froxelBrickAccumShader.use();
+		m_froxelBrickAccumShader.setVec2("u_cameraPlanes", glm::vec2(m_nearPlane, m_farPlane));
+		m_froxelBrickAccumShader.setFloat("u_froxelFar", getFroxelFarPlane());
+		m_froxelBrickAccumShader.setFloat("u_totalSlices", (float)m_fogTexSize.z);
+
+		m_fogAccumShader.use();
+		m_fogAccumShader.setVec2("u_cameraPlanes", glm::vec2(m_nearPlane, m_farPlane));
+		m_fogAccumShader.setFloat("u_froxelFar", getFroxelFarPlane());
+		m_fogAccumShader.setInt("u_totalSlices", m_fogTexSize.z);
+
+		// Surface depths are written as froxel slice coordinates:
+		for (const Shader* depthShader : { &m_depthShader, &m_instanceDepthShader })
+		{
+			depthShader->use();
+			depthShader->setVec2("u_cameraPlanes", glm::vec2(m_nearPlane, m_farPlane));
+			depthShader->setFloat("u_froxelFar", getFroxelFarPlane());
+		}
+
+		m_fogClipmapSampleShader.use();
+		m_fogClipmapSampleShader.setVec3("u_cameraPos", m_camera.getPosition());
+		m_fogClipmapSampleShader.setVec3("u_cameraForward", m_camera.getForward());
+		m_fogClipmapSampleShader.setVec3("u_cameraUp", m_camera.getUp());
+		m_fogClipmapSampleShader.setVec3("u_cameraRight", m_camera.getRight());
+		m_fogClipmapSampleShader.setVec2("u_cameraPlanes", glm::vec2(m_nearPlane, m_farPlane));
+		m_fogClipmapSampleShader.setFloat("u_froxelFar", getFroxelFarPlane());
+		m_fogClipmapSampleShader.setBool("u_linOrExp", frame.linearOrExpFroxels);
 
-		// Set fog data:
+		// Set shadow data:
 		m_varianceShadowmapLayeredShader.use();
-		m_varianceShadowmapLayeredShader.setVec2("u_lightPlanes", m_lightViewPlanes);
-		for (int i = 0; i < 6 * m_numActiveLights; ++i)
-			m_varianceShadowmapLayeredShader.setMat4("u_lightMatrices[" + std::to_string(i) + "]", m_lightSpaceMat[i]);
+		m_varianceShadowmapLayeredShader.setVec2("u_lightPlanes", frame.lights.getViewPlanes());
 
 		m_instanceVarianceShadowmapLayeredShader.use();
-		m_instanceVarianceShadowmapLayeredShader.setVec2("u_lightPlanes", m_lightViewPlanes);
-		for (int i = 0; i < 6 * m_numActiveLights; ++i)
-			m_instanceVarianceShadowmapLayeredShader.setMat4("u_lightMatrices[" + std::to_string(i) + "]", m_lightSpaceMat[i]);
+		m_instanceVarianceShadowmapLayeredShader.setVec2("u_lightPlanes", frame.lights.getViewPlanes());
+
+		// Light matrices are shared by the shadow and fog shaders through a uniform block, in visible light order:
+		LightMatricesBlock lightMatrices;
+		for (int i = 0; i < m_numVisibleLights; ++i)
+			memcpy(&lightMatrices.lightMatrices[6 * i], frame.lights.getMatrices(m_visibleLights[i]), 6 * sizeof(glm::mat4));
+		m_lightMatricesRing.write(m_framePacer.getSlot(), &lightMatrices);
+		m_lightMatricesRing.bind(m_framePacer.getSlot(), 1);
 	}
 	Renderer::popDebugGroup();
 
+	// Work out which clipmap cells need recomputing, with the lights in the same order as the uniforms:
+	if (m_useFogClipmap)
+	{
+		PROFILE_SCOPE("Fog clipmap planning");
+
+		FogClipmap::Medium medium;
+		medium.scattering = frame.fogScattering;
+		medium.absorption = frame.fogAbsorption;
+		medium.density = frame.fogDensity;
+		medium.lightIntensity = frame.lightIntensity;
+		medium.attenuation = glm::vec3(m_pointLightConstant, m_pointLightLinear, m_pointLightQuadratic);
+		medium.lightPlanes = frame.lights.getViewPlanes();
+		medium.shadowMapTechnique = frame.shadowMapTechnique;
+		medium.heterogeneous = frame.useHeterogeneousFog;
+		medium.noiseFreq = frame.noiseFreq;
+		medium.noiseOffset = frame.noiseOffset;
+		medium.heightFog = frame.useHeightFog;
+		medium.heightRange = frame.fogHeightRange;
+
+		LightManager::Light lights[NUM_LIGHTS];
+		for (int i = 0; i < m_numVisibleLights; ++i)
+		{
+			const int index = m_visibleLights[i];
+			lights[i] = { frame.lights.getPosition(index), frame.lights.getDiffuse(index), frame.lights.getRadius(index) };
+		}
+		m_fogClipmap.plan(m_camera.getPosition(), medium, lights, m_numVisibleLights);
+	}
+	// Nothing keeps the clipmap up to date while it's unused:
+	else
+		m_fogClipmap.invalidate();
+
 	// Set which buffer to output:
 	m_currentOutputBuffer = m_outputDepth ? &m_FBODepthBuffer : &m_FBOColourBuffer;
 
 	// Toggle which fog texture to write to and which to blend with:
 	m_evenFrame = !m_evenFrame;
 
-	// Update frame index for Halton sequences, wrap round to zero after 60 frames:
-	m_frameIndex <= 60 ? ++m_frameIndex : m_frameIndex = 0;
+	// Update frame index for Halton sequences and amortisation:
+	m_frameIndex = (m_frameIndex + 1) % c_frameIndexPeriod;
+}
 
-	// If testing is enabled and not collecting performance stats, update testing variables and start collecting data:
-	if (m_currentlyTesting)
-	{
-#ifdef NV_PERF_ENABLE_INSTRUMENTATION
-		if (!g_nvPerfSDKReportGenerator.IsCollectingReport())
-		{
-			++m_currentIteration;
-			if (m_currentIteration >= m_numTestIterations)
-			{
-				// Increment testing setup variable, end testing if last setup has been tested:
-				switch (m_testingSetup)
-				{
-				case START_VAL:
-					m_testingSetup = NO_LUT_STANDARD_SHADOW;
-
-					// Set standard testing environment variables:
-					m_applyFog = true;
-					m_useShadows = true;
-					m_useTemporal = true;
-					m_useJitter = true;
-					m_useHeterogeneousFog = true;
-					m_noiseOffset = glm::vec3(0.0f);
-					m_windDirection = glm::vec3(0.0f);
-					m_noiseFreq = 0.15f;
-					m_fogDensity = 0.03f;
-					m_fogPhaseGParam = -0.5f;
-					m_fogScattering = 1.0f;
-					m_fogAbsorption = 0.0f;
-					m_fogAlbedo = glm::vec3(1.0f);
-
-					// Set camera data:
-					m_camera.setPosition(65.0f, 2.7f, 1.7f);
-					m_camera.setPitch(1.3f);
-					m_camera.setYaw(-189.7f);
-					m_camera.findForward();
-
-					// Set light data:
-					m_numActiveLights = 4;
-
-					m_pointLightPosition[0] = glm::vec3(0.0f, 3.0f, 10.0f);
-					m_pointLightPosition[1] = glm::vec3(0.0f, 3.0f, 50.0f);
-					m_pointLightPosition[2] = glm::vec3(50.0f, 1.0f, 10.0f);
-					m_pointLightPosition[3] = glm::vec3(-5.0f, 0.0f, -50.0f);
-
-					m_pointLightDiffuse[0] = glm::vec3(1.0f);
-					m_pointLightDiffuse[1] = glm::vec3(1.0f);
-					m_pointLightDiffuse[2] = glm::vec3(1.0f);
-					m_pointLightDiffuse[3] = glm::vec3(1.0f);
-
-					m_pointLightRadius[0] = 20.0f;
-					m_pointLightRadius[1] = 20.0f;
-					m_pointLightRadius[2] = 20.0f;
-					m_pointLightRadius[3] = 20.0f;
-
-					m_useLUT = false;
-					m_shadowMapTechnique = ShadowMapTechnique::STANDARD;
-					m_linearOrExpFroxels = false;	// Use exponential froxel distribution.
-
-					break;
-				case NO_LUT_STANDARD_SHADOW:
-					m_testingSetup = KOVALOVS_LUT_STANDARD_SHADOW;
-					m_useLUT = true;
-					m_hooblerOrKovalovs = true;		// Use Kovalovs' LUT.
-
-					break;
-				case KOVALOVS_LUT_STANDARD_SHADOW:
-					m_testingSetup = HOOBLER_LUT_STANDARD_SHADOW;
-					m_hooblerOrKovalovs = false;	// Use Hoobler's LUT.
-
-					break;
-				case HOOBLER_LUT_STANDARD_SHADOW:
-					m_testingSetup = NO_LUT_VSM;
-					m_useLUT = false;
-					m_shadowMapTechnique = ShadowMapTechnique::VSM;
-
-					break;
-				case NO_LUT_VSM:
-					m_testingSetup = NO_LUT_ESM;
-					m_shadowMapTechnique = ShadowMapTechnique::ESM;
-
-					break;
-				case NO_LUT_ESM:
-					m_testingSetup = NO_LUT_LIN_DIST;
-					m_shadowMapTechnique = ShadowMapTechnique::STANDARD;
-					m_linearOrExpFroxels = true;	// Use linear froxel distribution.
-
-					break;
-				case NO_LUT_LIN_DIST:
-					m_testingSetup = START_VAL;
-
-					// Reset test variables to default:
-					m_linearOrExpFroxels = false;
-					m_shadowMapTechnique = ShadowMapTechnique::STANDARD;
-
-					m_currentlyTesting = false;
-					m_currentIteration = m_numTestIterations;
-					return;
-				}
-				m_currentIteration = 0;
-			}
-			const std::string filePath = m_filePaths[(int)m_testingSetup];
-			g_nvPerfSDKReportGenerator.StartCollectionOnNextFrame(std::string(filePath + std::to_string(m_currentIteration)).c_str(), nv::perf::AppendDateTime::no);
-		}
-#endif
-	}
+Simulation::Input App::makeSimulationInput()
+{
+	Simulation::Input input;
+	FrameState& settings = input.settings;
+
+	settings.planetPosition = m_planetPosition;
+
+	settings.fogScattering = m_fogScattering;
+	settings.fogAbsorption = m_fogAbsorption;
+	settings.fogAlbedo = m_fogAlbedo;
+	settings.fogPhaseGParam = m_fogPhaseGParam;
+	settings.fogDensity = m_fogDensity;
+	settings.useHeterogeneousFog = m_useHeterogeneousFog;
+	settings.useHeightFog = m_useHeightFog;
+	settings.fogHeightRange = m_fogHeightRange;
+	settings.useShadows = m_useShadows;
+	settings.useTemporal = m_useTemporal;
+	settings.useJitter = m_useJitter;
+	settings.useScreenspaceJitter = m_useScreenspaceJitter;
+	settings.useLUT = m_useLUT;
+	settings.hooblerOrKovalovs = m_hooblerOrKovalovs;
+	settings.linearOrExpFroxels = m_linearOrExpFroxels;
+	settings.shadowMapTechnique = m_shadowMapTechnique;
+
+	settings.noiseFreq = m_noiseFreq;
+	settings.noiseOffset = m_noiseOffset;
+	input.windDirection = m_windDirection;
+
+	// The GUI, a benchmark or a camera track changed the noise offset since the last snapshot:
+	if (m_noiseOffset != m_simulatedNoiseOffset)
+		++m_noiseOffsetVersion;
+	input.noiseOffsetVersion = m_noiseOffsetVersion;
+
+	settings.lightIntensity = m_lightIntensity;
+	settings.lights.setNumActive(m_numActiveLights);
+	settings.lights.setViewPlanes(m_lightViewPlanes);
+	for (int i = 0; i < NUM_LIGHTS; ++i)
+		settings.lights.setLight(i, m_lightSettings[i]);
+
+	return input;
 }
 
 void App::render()
 {
+	PROFILE_FUNCTION();
+
 #ifdef NV_PERF_ENABLE_INSTRUMENTATION
-	g_nvPerfSDKReportGenerator.OnFrameStart();
+	if (!m_headless)
+		g_nvPerfSDKReportGenerator.OnFrameStart();
 #endif
 
 	const glm::mat4 view = m_camera.getViewMat();
 
-	// Set view matrix in UBO:
-	glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(m_camera.getViewMat()));
-
-	// Set inverse view * proj matrix in UBO:
-	glBufferSubData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(glm::inverse(m_proj * m_camera.getViewMat())));
-	glBufferSubData(GL_UNIFORM_BUFFER, 4 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(m_proj * m_camera.getViewMat()));
+	// Write this frame's matrices to its own region of the matrices ring buffer:
+	MatricesBlock matrices;
+	matrices.proj = m_proj;
+	matrices.view = view;
+	matrices.currentViewProj = m_proj * view;
+	matrices.invViewProj = glm::inverse(matrices.currentViewProj);
+	matrices.prevViewProj = m_prevViewProj;
+	m_matricesRing.write(m_framePacer.getSlot(), &matrices);
+	m_matricesRing.bind(m_framePacer.getSlot(), 0);
 
 	// SHADOWMAP PASS --------------------------------------------------------------------------------------------
 	Renderer::pushDebugGroup(m_shadowmapPassText);
 	{
+		m_gpuTimer.begin(m_shadowmapPassText.c_str());
+
 		Renderer::setViewport(c_shadowmapDim);
 
 		// Render to shadowmap texture array:
 		Renderer::setTarget(m_pointShadowmapArrayFBO);
 		Renderer::clear(m_lightViewPlanes.y, m_lightViewPlanes.y * m_lightViewPlanes.y, 0.0f, 1.0f, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		for (int i = 0; i < m_numActiveLights; ++i)
+		for (int i = 0; i < m_numVisibleLights; ++i)
 		{
 			m_varianceShadowmapLayeredShader.use();
-			m_varianceShadowmapLayeredShader.setVec3("u_lightPos", m_pointLightPosition[i]);
+			m_varianceShadowmapLayeredShader.setVec3("u_lightPos", m_frame->lights.getPosition(m_visibleLights[i]));
 			m_varianceShadowmapLayeredShader.setInt("u_currentLight", i);
 
 			// Render planet:
@@ -477,7 +722,7 @@ void App::render()
 			Renderer::popDebugGroup();
 
 			m_instanceVarianceShadowmapLayeredShader.use();
-			m_instanceVarianceShadowmapLayeredShader.setVec3("u_lightPos", m_pointLightPosition[i]);
+			m_instanceVarianceShadowmapLayeredShader.setVec3("u_lightPos", m_frame->lights.getPosition(m_visibleLights[i]));
 			m_instanceVarianceShadowmapLayeredShader.setInt("u_currentLight", i);
 
 			// Render asteroids:
@@ -496,38 +741,52 @@ void App::render()
 			}
 			Renderer::popDebugGroup();
 		}
+
+		m_gpuTimer.end();
 	}
 	Renderer::popDebugGroup();
 
 	// HORIZONTAL SHADOWMAP BLUR PASS ----------------------------------------------------------------------------
 	Renderer::pushDebugGroup(m_horiBlurPassText);
 	{
+		m_gpuTimer.begin(m_horiBlurPassText.c_str());
+
 		Renderer::setTarget(m_horiBlurShadowmapArrayFBO);
 		Renderer::clear(GL_COLOR_BUFFER_BIT);
 
 		Renderer::drawFBO(m_fullscreenQuadVAO, m_horiBlurLayeredShader, m_pointShadowmapArrayColour, GL_TEXTURE_2D_ARRAY);
+
+		m_gpuTimer.end();
 	}
 	Renderer::popDebugGroup();
 
 	// VERTICAL SHADOWMAP BLUR PASS ------------------------------------------------------------------------------
 	Renderer::pushDebugGroup(m_vertBlurPassText);
 	{
+		m_gpuTimer.begin(m_vertBlurPassText.c_str());
+
 		Renderer::setTarget(m_vertBlurShadowmapArrayFBO);
 		Renderer::clear(GL_COLOR_BUFFER_BIT);
 
 		Renderer::drawFBO(m_fullscreenQuadVAO, m_vertBlurLayeredShader, m_horiBlurShadowmapArrayColour, GL_TEXTURE_2D_ARRAY);
+
+		m_gpuTimer.end();
 	}
 	Renderer::popDebugGroup();
 
 	// Dispatch fog scattering and absorption evaluation compute shader ------------------------------------------
 #ifdef NV_PERF_ENABLE_INSTRUMENTATION
-	g_nvPerfSDKReportGenerator.PushRange("Fog scatter/absorb eval");
+	if (!m_headless)
+		g_nvPerfSDKReportGenerator.PushRange("Fog scatter/absorb eval");
 #endif
 
 	Renderer::pushDebugGroup(m_fogScatterAbsorbText);
 	{
+		m_gpuTimer.begin(m_fogScatterAbsorbText.c_str());
+
+#ifdef NV_PERFKIT_ENABLE
 		// If testing with Perfkit, instrument dispatch call:
-		if (m_currentlyTesting && m_profilerUsed == ProfilerUsed::PERFKIT)
+		if (m_benchmark.isRunning() && m_profilerUsed == ProfilerUsed::PERFKIT)
 		{
 			GLuint nCount;
 			NVPMRESULT nvResult;
@@ -566,33 +825,128 @@ void App::render()
 		}
 		else
 			runFogScatterAbsorb();
+#else
+		runFogScatterAbsorb();
+#endif
+
+		m_gpuTimer.end();
 	}
 	Renderer::popDebugGroup();
 #ifdef NV_PERF_ENABLE_INSTRUMENTATION
-	g_nvPerfSDKReportGenerator.PopRange();
+	if (!m_headless)
+		g_nvPerfSDKReportGenerator.PopRange();
 #endif
 
-	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	// The accumulation shader fetches the scattering volumes as textures:
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
 
 	// Dispatch fog accumulation compute shader ------------------------------------------------------------------
 	Renderer::pushDebugGroup(m_fogAccumText);
 	{
-		if (m_evenFrame)
-			FogRenderer::bindImage(2, m_evenFogScatterAbsorbTex, GL_READ_ONLY, GL_RGBA32F);
+		m_gpuTimer.begin(m_fogAccumText.c_str());
+		accumulateFroxelCascades();
+		m_gpuTimer.end();
+	}
+	Renderer::popDebugGroup();
+
+	// Refine the froxels around lights and density gradients ----------------------------------------------------
+	if (useFroxelBricks())
+	{
+		Renderer::pushDebugGroup(m_froxelBrickText);
+		m_gpuTimer.begin(m_froxelBrickText.c_str());
+		refineFroxelBricks();
+		m_gpuTimer.end();
+		Renderer::popDebugGroup();
+	}
+
+	// Forward fog is applied by the surface shaders as they draw into the output, so the composite's inputs are skipped:
+	const bool forwardFog = useForwardFog();
+	if (forwardFog)
+	{
+		// The surface shaders sample the accumulated volumes (and bricks) next:
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+	else
+	{
+		// DEPTH PASS --------------------------------------------------------------------------------------------
+		m_gpuTimer.begin(m_depthPassText.c_str());
+		renderDepthPass();
+		m_gpuTimer.end();
+	}
+
+	// COLOUR PASS -----------------------------------------------------------------------------------------------
+	m_gpuTimer.begin(m_colourPassText.c_str());
+	renderColourPass(forwardFog);
+	m_gpuTimer.end();
+
+	// Block image read/write operations:
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	// Force wireframe mode off for FBO render if wireframe is on:
+	if (m_wireframe)
+		Renderer::setWireframe(false);
+
+	// Composite fog onto final render (fragment shader) ---------------------------------------------------------
+	Renderer::pushDebugGroup(m_fogCompositionText);
+	{
+		m_gpuTimer.begin(m_fogCompositionText.c_str());
+
+		// Render fullscreen quad, applying accumulated fog (and any refined bricks) if desired:
+		if (m_applyFog && useFroxelBricks())
+			m_froxelBricks.bind(m_fogCompositeShader, 2 + 2 * c_numFroxelCascades);
+
+		if (forwardFog)
+		{
+			// Only the sky is left, where the surfaces left the depth buffer clear. The quad is pinned to the far plane
+			// so it fails the depth test everywhere else:
+			m_fogCompositeShader.use();
+			m_fogCompositeShader.setBool("u_skyOnly", true);
+			m_fogCompositeShader.setFloat("u_skyDepth", getSkyFroxelDepth());
+
+			glDepthRange(1.0, 1.0);
+			glDepthFunc(GL_LEQUAL);
+			FogRenderer::compositeFog(m_fullscreenQuadVAO, 0, 0, m_fogAccumTex, m_fogAccumAlphaTex, c_numFroxelCascades, m_fogCompositeShader);
+			glDepthFunc(GL_LESS);
+			glDepthRange(0.0, 1.0);
+
+			m_fogCompositeShader.setBool("u_skyOnly", false);
+		}
 		else
-			FogRenderer::bindImage(2, m_oddFogScatterAbsorbTex, GL_READ_ONLY, GL_RGBA32F);
+		{
+			Renderer::setTarget(m_outputFBO);
+			Renderer::clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		FogRenderer::bindImage(3, m_fogAccumTex, GL_WRITE_ONLY, GL_RGBA32F);
-		FogRenderer::dispatch(c_fogNumWorkGroups.x, c_fogNumWorkGroups.y, 1, m_fogAccumShader);
+			m_applyFog ? FogRenderer::compositeFog(m_fullscreenQuadVAO, m_FBOColourBuffer, m_FBODepthBuffer, m_fogAccumTex, m_fogAccumAlphaTex, c_numFroxelCascades, m_fogCompositeShader)
+				: Renderer::drawFBO(m_fullscreenQuadVAO, m_fullscreenShader, *m_currentOutputBuffer, GL_TEXTURE_2D);
+		}
+
+		m_gpuTimer.end();
 	}
 	Renderer::popDebugGroup();
 
-	// DEPTH PASS ------------------------------------------------------------------------------------------------
+	// Restore wireframe mode to on:
+	if (m_wireframe)
+		Renderer::setWireframe(true);
+
+#ifdef NV_PERF_ENABLE_INSTRUMENTATION
+	if (!m_headless)
+		g_nvPerfSDKReportGenerator.OnFrameEnd();
+#endif
+
+	// Keep this frame's view * proj matrix to be used in the next frame for temporal reprojection:
+	m_prevViewProj = m_proj * view;
+}
+
+void App::renderDepthPass()
+{
 	Renderer::pushDebugGroup(m_depthPassText);
 	{
 		Renderer::setViewport(m_windowDim);
 		Renderer::setTarget(m_fullscreenDepthFBO);
-		Renderer::clear(1.0, 1.0, 1.0, 1.0, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// Where nothing's drawn, the fog reaches the far plane (past the last slice, if they end before it):
+		const float skyDepth = getSkyFroxelDepth();
+		Renderer::clear(skyDepth, skyDepth, skyDepth, 1.0, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		Renderer::pushDebugGroup(m_planetRenderText);
 		{
 			Renderer::draw(m_planet, m_depthShader);
@@ -616,9 +970,9 @@ void App::render()
 		Renderer::pushDebugGroup(m_debugRenderText);
 		{
 			glDisable(GL_CULL_FACE);
-			for (int i = 0; i < m_numActiveLights; ++i)
+			for (int i = 0; i < m_numVisibleLights; ++i)
 			{
-				m_lightCubeWorld = glm::translate(glm::mat4(1.0f), m_pointLightPosition[i]);
+				m_lightCubeWorld = glm::translate(glm::mat4(1.0f), m_frame->lights.getPosition(m_visibleLights[i]));
 				m_lightCubeWorld = glm::scale(m_lightCubeWorld, glm::vec3(0.25f));
 
 				m_depthShader.use();
@@ -630,11 +984,25 @@ void App::render()
 		Renderer::popDebugGroup();
 	}
 	Renderer::popDebugGroup();
+}
 
-	// COLOUR PASS -----------------------------------------------------------------------------------------------
+void App::renderColourPass(bool forwardFog)
+{
 	Renderer::pushDebugGroup(m_colourPassText);
 	{
-		Renderer::setTarget(m_fullscreenColourFBO);
+		// Forward fogged surfaces go straight to the output, with the accumulated volumes on units past their own textures:
+		for (const Shader* surfaceShader : { &m_shader, &m_instanceShader })
+		{
+			surfaceShader->use();
+			surfaceShader->setBool("u_forwardFog", forwardFog);
+			if (forwardFog && useFroxelBricks())
+				m_froxelBricks.bind(*surfaceShader, c_forwardFogFirstUnit + 2 * c_numFroxelCascades);
+		}
+		if (forwardFog)
+			FogRenderer::bindFogVolumes(c_forwardFogFirstUnit, m_fogAccumTex, m_fogAccumAlphaTex, c_numFroxelCascades);
+
+		Renderer::setViewport(m_windowDim);
+		Renderer::setTarget(forwardFog ? m_outputFBO : m_fullscreenColourFBO);
 		Renderer::clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		Renderer::pushDebugGroup(m_planetRenderText);
 		{
@@ -642,207 +1010,1058 @@ void App::render()
 		}
 		Renderer::popDebugGroup();
 
-		Renderer::pushDebugGroup(m_asteroidRenderText);
-		{
-			Renderer::drawInstanced(m_rock, m_instanceShader, c_asteroidsCount);
-		}
-		Renderer::popDebugGroup();
+		Renderer::pushDebugGroup(m_asteroidRenderText);
+		{
+			Renderer::drawInstanced(m_rock, m_instanceShader, c_asteroidsCount);
+		}
+		Renderer::popDebugGroup();
+
+		Renderer::pushDebugGroup(m_planeRenderText);
+		{
+			m_shader.use();
+			m_shader.setMat4("world", m_planeWorld);
+			//Renderer::draw(m_planeVAO, 6, m_shader);
+		}
+		Renderer::popDebugGroup();
+
+		Renderer::pushDebugGroup(m_debugRenderText);
+		{
+			glDisable(GL_CULL_FACE);
+			for (int i = 0; i < m_numVisibleLights; ++i)
+			{
+				m_lightCubeWorld = glm::translate(glm::mat4(1.0f), m_frame->lights.getPosition(m_visibleLights[i]));
+				m_lightCubeWorld = glm::scale(m_lightCubeWorld, glm::vec3(0.25f));
+
+				m_singleColourShader.use();
+				m_singleColourShader.setMat4("world", m_lightCubeWorld);
+				Renderer::draw(m_lightCubeVAO, 36, m_singleColourShader);
+			}
+			glEnable(GL_CULL_FACE);
+		}
+		Renderer::popDebugGroup();
+	}
+	Renderer::popDebugGroup();
+}
+
+void App::redrawCompositeInputs()
+{
+	if (!useForwardFog())
+		return;
+
+	renderDepthPass();
+	renderColourPass(false);
+}
+
+void App::gui()
+{
+	PROFILE_FUNCTION();
+
+	Renderer::pushDebugGroup(m_uiRenderText);
+	{
+		// Start new ImGui frame:
+		ImGui_ImplGlfw_NewFrame();
+		ImGui_ImplOpenGL3_NewFrame();
+		ImGui::NewFrame();
+
+		ImGui::Begin("ImGui");
+		{
+			ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+			ImGui::Text("Waited on GPU: %.3f ms (%i frames in flight)", m_framePacer.getStallMs(), (int)FramePacer::c_framesInFlight);
+			ImGui::Text("Camera position: (%f, %f, %f)", m_camera.getPosition().x, m_camera.getPosition().y, m_camera.getPosition().z);
+
+			if (!m_benchmark.isRunning())
+			{
+				ImGui::Checkbox("Output depth", &m_outputDepth);
+				ImGui::Checkbox("Apply fog", &m_applyFog);
+
+				if (ImGui::CollapsingHeader("Benchmark"))
+				{
+					ImGui::InputText("Scenario file", m_benchmarkFilePath, sizeof(m_benchmarkFilePath));
+					if (ImGui::Button("Start benchmark"))
+						startBenchmark(m_benchmarkFilePath);
+				}
+
+				if (ImGui::CollapsingHeader("Camera track"))
+				{
+					ImGui::InputText("Track file", m_cameraTrackFilePath, sizeof(m_cameraTrackFilePath));
+					if (m_cameraTrack.isRecording())
+					{
+						if (ImGui::Button("Stop recording"))
+						{
+							m_cameraTrack.stopRecording();
+							m_cameraTrack.save(m_cameraTrackFilePath);
+						}
+						ImGui::Text("Recorded samples: %i", (int)m_cameraTrack.getNumSamples());
+					}
+					else if (m_cameraTrack.isPlaying())
+					{
+						if (ImGui::Button("Stop playback"))
+							m_cameraTrack.stopPlayback();
+						ImGui::Text("Playing sample %i out of %i", (int)m_cameraTrack.getPlayhead(), (int)m_cameraTrack.getNumSamples());
+					}
+					else
+					{
+						if (ImGui::Button("Record"))
+							m_cameraTrack.startRecording();
+						ImGui::SameLine();
+						if (ImGui::Button("Play") && m_cameraTrack.load(m_cameraTrackFilePath))
+						{
+							// Restart the temporal and jitter sequences so playback is repeatable:
+							m_frameIndex = 0;
+							m_evenFrame = true;
+							m_cameraTrack.startPlayback(m_loopCameraTrack);
+						}
+						ImGui::Checkbox("Loop playback", &m_loopCameraTrack);
+					}
+				}
+
+				if (ImGui::CollapsingHeader("Simulation"))
+				{
+					ImGui::Checkbox("Threaded simulation", &m_threadedSimulation);
+					if (m_simulation.isThreaded())
+						ImGui::Text("Fixed timestep: %.2f ms (%.1f steps/s)", Simulation::c_timestep * 1000.0, m_simulation.getStepsPerSecond());
+					else
+						ImGui::Text("Stepped once per frame on the render thread.");
+					ImGui::Text("Snapshot: step %llu, %.2f s", (unsigned long long)m_frame->step, m_frame->time);
+				}
+
+				if (ImGui::CollapsingHeader("CPU profiler"))
+				{
+					bool profilerEnabled = CPUProfiler::isEnabled();
+					if (ImGui::Checkbox("Record CPU zones", &profilerEnabled))
+						CPUProfiler::setEnabled(profilerEnabled);
+
+					// Write all buffered zones as Chrome/Perfetto trace JSON:
+					if (ImGui::Button("Dump CPU trace"))
+						CPUProfiler::dumpChromeTrace("CPUTrace_frame" + std::to_string(CPUProfiler::getFrameIndex()) + ".json");
+				}
+
+				if (ImGui::CollapsingHeader("Frame capture"))
+				{
+					ImGui::InputText("Capture prefix", m_capturePrefix, sizeof(m_capturePrefix));
+					ImGui::Checkbox("Include intermediates", &m_captureIntermediates);
+					if (m_captureIntermediates)
+						ImGui::SliderInt("Fog slice", &m_captureFogSlice, 0, (int)m_fogTexSize.z - 1);
+					if (ImGui::Button("Capture frame"))
+						m_captureRequested = true;
+					ImGui::SameLine();
+					ImGui::Checkbox("Capture every frame", &m_captureContinuous);
+
+					const float captureMs = m_frameCapture.getFrameCostMs();
+					ImGui::Text("Pending: %i, written: %i", m_frameCapture.getPending(), m_frameCapture.getWritten());
+					ImGui::Text("Frame loop cost: %.3f ms (%.2f%% of the frame)", captureMs, m_dt > 0.0f ? 100.0f * captureMs / (m_dt * 1000.0f) : 0.0f);
+					ImGui::Text("Stalled waiting for a free slot: %.2f ms total", m_frameCapture.getStallMs());
+				}
+
+				if (ImGui::CollapsingHeader("Reference renderer"))
+				{
+					ImGui::InputText("Output prefix", m_referenceOutputPrefix, sizeof(m_referenceOutputPrefix));
+					ImGui::SliderInt("Samples per pixel", &m_referenceSettings.samplesPerPixel, 1, 256);
+					ImGui::SliderInt("Steps per sample", &m_referenceSettings.stepsPerSample, 8, 512);
+					ImGui::Checkbox("Light transmittance", &m_referenceSettings.lightTransmittance);
+
+					// Blocks until finished (usually seconds to minutes):
+					if (ImGui::Button("Render reference"))
+						renderReference(m_referenceOutputPrefix);
+				}
+
+				if (ImGui::CollapsingHeader("GPU memory"))
+				{
+					const float MB = 1024.0f * 1024.0f;
+					ImGui::Text("Total: %.2f MB", GPUResourceRegistry::getTotalBytes() / MB);
+
+					// Usage against budget for each subsystem, with budgets editable in MB:
+					for (int i = 0; i < GPUResourceRegistry::NUM_TAGS; ++i)
+					{
+						const GPUResourceRegistry::Tag tag = (GPUResourceRegistry::Tag)i;
+						const float usedMB = GPUResourceRegistry::getTagBytes(tag) / MB;
+						float budgetMB = GPUResourceRegistry::getBudget(tag) / MB;
+
+						ImGui::PushID(i);
+						const std::string overlay = std::to_string((int)usedMB) + " / " + std::to_string((int)budgetMB) + " MB";
+						if (GPUResourceRegistry::isOverBudget(tag))
+							ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(0.9f, 0.2f, 0.2f, 1.0f));
+						ImGui::ProgressBar(budgetMB > 0.0f ? usedMB / budgetMB : 1.0f, ImVec2(160.0f, 0.0f), overlay.c_str());
+						if (GPUResourceRegistry::isOverBudget(tag))
+							ImGui::PopStyleColor();
+
+						ImGui::SameLine();
+						ImGui::SetNextItemWidth(80.0f);
+						if (ImGui::InputFloat(GPUResourceRegistry::getTagName(tag), &budgetMB, 0.0f, 0.0f, "%.0f"))
+							GPUResourceRegistry::setBudget(tag, (uint64_t)(glm::max(budgetMB, 0.0f) * MB));
+						ImGui::PopID();
+					}
+
+					// Every live resource, by type then handle:
+					if (ImGui::TreeNode("Resources", "Resources (%i)", (int)GPUResourceRegistry::getResources().size()))
+					{
+						for (const auto& entry : GPUResourceRegistry::getResources())
+						{
+							const GPUResourceRegistry::Resource& resource = entry.second;
+							ImGui::Text("%s: %s %ux%ux%u, %.2f MB", GPUResourceRegistry::getTagName(resource.tag), resource.name.c_str(),
+								resource.dim.x, resource.dim.y, resource.dim.z, resource.bytes / MB);
+						}
+						ImGui::TreePop();
+					}
+
+					if (ImGui::Button("Print summary"))
+						GPUResourceRegistry::printSummary();
+				}
+
+				if (ImGui::CollapsingHeader("Fog parameters"))
+				{
+					if (ImGui::Button("Regenerate LUTs"))
+						generateLUTs();
+
+					ImGui::SliderFloat("Noise frequency", &m_noiseFreq, 0.001f, 1.0f);
+					ImGui::SliderFloat3("Wind direction", &m_windDirection.x, -1.0, 1.0f);
+					ImGui::SliderFloat3("Fog albedo", &m_fogAlbedo.x, 0.0f, 1.0f);
+					ImGui::SliderFloat("Fog scattering", &m_fogScattering, 0.0f, 10.0f);
+					ImGui::SliderFloat("Fog absorption", &m_fogAbsorption, 0.0f, 10.0f);
+					ImGui::SliderFloat("Fog phase g-parameter", &m_fogPhaseGParam, -0.999f, 0.999f);
+
+					ImGui::Checkbox("Use heterogenous density?", &m_useHeterogeneousFog);
+					ImGui::SliderFloat("Fog density scalar", &m_fogDensity, 0.0f, 1.0f);
+					ImGui::Checkbox("Use height fog?", &m_useHeightFog);
+					if (m_useHeightFog)
+					{
+						ImGui::SliderFloat("Height fog base", &m_fogHeightRange.x, -50.0f, 50.0f);
+						ImGui::SliderFloat("Height fog scale height", &m_fogHeightRange.y, 0.5f, 100.0f);
+					}
+					ImGui::Checkbox("Use temporal filtering?", &m_useTemporal);
+					ImGui::Checkbox("Use sample jittering?", &m_useJitter);
+					ImGui::Checkbox("Use screenspace jitter?", &m_useScreenspaceJitter);
+					ImGui::Checkbox("Use LUT?", &m_useLUT);
+					if (m_useLUT)
+					{
+						ImGui::Checkbox("Hoobler or Kovalovs?", &m_hooblerOrKovalovs);
+						if (m_hooblerOrKovalovs)
+							ImGui::Text("Current LUT: Kovalovs");
+						else
+							ImGui::Text("Current LUT: Hoobler");
+					}
+
+					ImGui::SliderInt("Shadow Map Technique", (int*)&m_shadowMapTechnique, 0, 2);
+					switch (m_shadowMapTechnique)
+					{
+					case STANDARD:
+						ImGui::Text("Current technique: Standard shadow mapping");
+						break;
+					case VSM:
+						ImGui::Text("Current technique: Variance shadow mapping");
+						break;
+					case ESM:
+						ImGui::Text("Current technique: Exponential shadow mapping");
+						break;
+					}
+
+					ImGui::Checkbox("Exponential or linear froxels?", &m_linearOrExpFroxels);
+					if (m_linearOrExpFroxels)
+						ImGui::Text("Froxel depth distribution: linear");
+					else
+						ImGui::Text("Froxel depth distribution: exponential");
+
+					// Applied on enter, so typing doesn't reallocate the volumes on every keystroke:
+					glm::ivec3 froxelGrid = m_froxelGrid;
+					if (ImGui::InputInt3("Froxel grid (XY, slices)", &froxelGrid.x, ImGuiInputTextFlags_EnterReturnsTrue))
+						m_froxelGrid = froxelGrid;
+					if (ImGui::Button("Match window aspect"))
+						m_froxelGrid.y = (int)glm::round(m_froxelGrid.x * (float)m_windowDim.y / (float)m_windowDim.x);
+
+					// Smoother than trilinear, so coarser grids hold up, at 8 taps (and 4 of the depth) per cascade:
+					ImGui::Checkbox("Tricubic fog upsampling?", &m_useTricubicFog);
+					if (m_useTricubicFog)
+						ImGui::SliderFloat("Upsampling depth sharpness (per slice)", &m_fogUpsampleDepthSharpness, 0.0f, 4.0f);
+
+					// Surfaces fog themselves as they're shaded, leaving the composite only the sky:
+					ImGui::Checkbox("Apply fog in surface shaders?", &m_useForwardFog);
+
+					// Froxels spent on the near range, with the fog past it integrated per pixel instead:
+					ImGui::Checkbox("Analytic fog past the froxels?", &m_useAnalyticFarFog);
+					if (m_useAnalyticFarFog)
+						ImGui::SliderFloat("Froxel range", &m_froxelFarPlane, 10.0f, m_farPlane);
+
+					ImGui::SliderInt("Froxel amortisation (1/N per frame)", &m_froxelAmortisation, 1, c_maxFroxelAmortisation);
+					if (m_froxelAmortisation > 1)
+					{
+						ImGui::RadioButton("Interleaved slices", (int*)&m_froxelAmortisationPattern, INTERLEAVED_SLICES);
+						ImGui::SameLine();
+						ImGui::RadioButton("Checkerboard", (int*)&m_froxelAmortisationPattern, CHECKERBOARD);
+					}
+
+					// Picking lights stochastically leaves noise that the temporal blend converges:
+					ImGui::SliderInt("Lights sampled per froxel (0 = all)", &m_lightSamplesPerFroxel, 0, c_maxLightSamples);
+					if (m_lightSamplesPerFroxel > 0 && !m_useTemporal)
+						ImGui::Text("Light sampling needs temporal filtering to converge.");
+
+					// Scattering volumes are read back filtered next frame, accumulated ones by the composite:
+					ImGui::Combo("Scattering volume format", (int*)&m_scatterVolumeFormat, [](void*, int i, const char** name) { *name = getFroxelFormatName(i); return true; }, nullptr, 3);
+					ImGui::Combo("Accumulation volume format", (int*)&m_accumVolumeFormat, [](void*, int i, const char** name) { *name = getFroxelFormatName(i); return true; }, nullptr, 3);
+					if (ImGui::Button("Measure format error against FP32"))
+						m_froxelFormatErrorRequested = true;
+					if (!m_froxelFormatErrors.empty() && ImGui::BeginTable("Froxel format error", 5))
+					{
+						ImGui::TableSetupColumn("Scattering / accumulation");
+						ImGui::TableSetupColumn("MB");
+						ImGui::TableSetupColumn("Max in-scattering error");
+						ImGui::TableSetupColumn("Max transmittance error");
+						ImGui::TableSetupColumn("Composite FLIP");
+						ImGui::TableHeadersRow();
+						for (const FroxelFormatError& error : m_froxelFormatErrors)
+						{
+							ImGui::TableNextRow();
+							ImGui::TableNextColumn(); ImGui::Text("%s / %s", getFroxelFormatName(error.scatterFormat), getFroxelFormatName(error.accumFormat));
+							ImGui::TableNextColumn(); ImGui::Text("%.1f", error.bytes / (1024.0 * 1024.0));
+							ImGui::TableNextColumn(); ImGui::Text("%.5f", error.maxInScatteringError);
+							ImGui::TableNextColumn(); ImGui::Text("%.5f", error.maxTransmittanceError);
+							ImGui::TableNextColumn(); ImGui::Text("%.4f", error.composite.flip);
+						}
+						ImGui::EndTable();
+					}
+
+					ImGui::Checkbox("Scale froxel grid to GPU budget?", &m_useFroxelBudget);
+					if (m_useFroxelBudget)
+					{
+						ImGui::SliderFloat("Fog pass budget (ms)", &m_froxelBudgetMs, 0.1f, 10.0f);
+						ImGui::Text("Fog passes: %.2f ms, XY scale %.2f", m_froxelBudget.getSmoothedMs(), m_froxelGridScale);
+					}
+
+					GLuint numFroxels = 0;
+					for (const FroxelCascade& cascade : m_froxelCascades)
+						numFroxels += cascade.dim.x * cascade.dim.y * cascade.dim.z;
+					ImGui::Text("Froxels: %u in %i cascades (%.0f%% of uncascaded %ux%ux%u)", numFroxels, c_numFroxelCascades, 100.0f * numFroxels / (m_fogTexSize.x * m_fogTexSize.y * m_fogTexSize.z),
+						m_fogTexSize.x, m_fogTexSize.y, m_fogTexSize.z);
+
+					ImGui::Checkbox("Cache light visibility volumes?", &m_useLightVisibilityVolumes);
+					if (m_useLightVisibilityVolumes)
+						ImGui::Text("Visibility volumes baked this frame: %i (%i^3 texels each)", m_lightVisibility.getVolumesUpdated(), LightVisibilityVolumes::c_resolution);
+
+					ImGui::Checkbox("Cache density between frames?", &m_cacheFogDensity);
+					if (m_cacheFogDensity)
+						ImGui::Text("Density volumes injected: %i times", m_fogDensityInjections);
+
+					ImGui::Checkbox("Refine froxels around lights and density gradients?", &m_useFroxelBricks);
+					if (m_useFroxelBricks)
+					{
+						ImGui::SliderFloat("Brick density range threshold", &m_brickDensityThreshold, 0.01f, 1.0f);
+						const glm::uvec3 cellGrid = m_froxelBricks.getCellGrid();
+						ImGui::Text("Bricks in use: %i of %i (%ux%ux%u cells of %i froxels)", m_froxelBricks.getBricksInUse(), FroxelBricks::c_maxBricks,
+							cellGrid.x, cellGrid.y, cellGrid.z, FroxelBricks::c_brickFootprint);
+						if (m_linearOrExpFroxels)
+							ImGui::Text("Bricks need the exponential froxel distribution.");
+					}
+
+					ImGui::Checkbox("Use world-space clipmap?", &m_useFogClipmap);
+					if (m_useFogClipmap)
+					{
+						ImGui::Text("Clipmap cells updated: %i of %i", m_fogClipmap.getCellsUpdated(), m_fogClipmap.getNumCells());
+						ImGui::Text("Finest cascade: %.2f m cells, %.0f m across", m_fogClipmap.getCellSize(0), m_fogClipmap.getCellSize(0) * FogClipmap::c_resolution);
+					}
+				}
+				if (ImGui::CollapsingHeader("Light parameters"))
+				{
+					ImGui::SliderInt("Num active lights", (int*)&m_numActiveLights, 1, NUM_LIGHTS);
+					ImGui::SliderInt("Current light", (int*)&m_currentLight, 0, NUM_LIGHTS - 1);
+					ImGui::SliderFloat3("Light position", &m_lightSettings[m_currentLight].position.x, -50.0f, 50.0f);
+					ImGui::SliderFloat3("Light diffuse", &m_lightSettings[m_currentLight].diffuse.r, 0.0f, 1.0f);
+					ImGui::SliderFloat("Light radius", &m_lightSettings[m_currentLight].radius, 1.0f, 100.0f);
+					ImGui::DragFloat("Light intensity", &m_lightIntensity, 0.2f, 0.0f);
+					ImGui::SliderFloat("Light constant", &m_pointLightConstant, 0.0f, 1.0f);
+					ImGui::SliderFloat("Light linear", &m_pointLightLinear, 0.0f, 1.0f);
+					ImGui::SliderFloat("Light quadratic", &m_pointLightQuadratic, 0.0f, 1.0f);
+
+					ImGui::Checkbox("Cull lights outside view", &m_cullLights);
+					ImGui::Text("Visible lights: %i of %i", m_numVisibleLights, m_frame->lights.getNumActive());
+					ImGui::Text("Light matrices rebuilt last step: %i", m_frame->lights.getMatricesRebuilt());
+				}
+			}
+			else
+			{
+				if (ImGui::Button("Stop benchmark"))
+					m_benchmark.stop();
+
+				ImGui::Text("Benchmark run: %i out of %i", (int)m_benchmark.getCurrentRun() + 1, (int)m_benchmark.getNumRuns());
+				ImGui::Text("Current run: %s", m_benchmark.getCurrentRunName().c_str());
+			}
+		}
+		ImGui::End();
+
+		ImGui::Render();
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	}
+	Renderer::popDebugGroup();
+}
+
+void App::bindScatterLightingTextures()
+{
+	// Bind unblurred shadowmaps if using standard shadowmapping:
+	if (m_frame->shadowMapTechnique == STANDARD)
+		Renderer::bindTex(0, GL_TEXTURE_2D_ARRAY, m_pointShadowmapArrayColour);
+	// Otherwise, bind blurred shadowmaps:
+	else
+		Renderer::bindTex(0, GL_TEXTURE_2D_ARRAY, m_vertBlurShadowmapArrayColour);
+
+	if (m_frame->hooblerOrKovalovs)
+		Renderer::bindTex(2, GL_TEXTURE_2D, m_kovalovsLUT);		// Use Kovalovs' LUT (true).
+	else
+		for (int i = 0; i < m_numVisibleLights; ++i)
+			Renderer::bindTex(2 + i, GL_TEXTURE_2D, m_hooblerSumLUT[i]);	// Use Hoobler's LUT (false).
+}
+
+void App::runFogScatterAbsorb()
+{
+	bindScatterLightingTextures();
+
+	// Recompute the clipmap cells that changed, then resample the clipmap into this frame's froxels:
+	if (m_useFogClipmap)
+	{
+		m_fogClipmap.dispatchUpdates(m_fogClipmapUpdateShader);
+
+		m_fogClipmap.bindCascades(m_fogClipmapSampleShader, 1);
+		dispatchFroxelCascades(m_fogClipmapSampleShader, m_evenFrame ? m_evenFogScatterAbsorbTex : m_oddFogScatterAbsorbTex, getFroxelInternalFormat(m_allocatedScatterFormat),
+			m_evenFrame ? m_evenFogScatterAlphaTex : m_oddFogScatterAlphaTex);
+		m_froxelHistoryValid = true;
+		return;
+	}
+
+	// Last frame's results, for temporal reprojection, from units 6 up (and their alpha, if it's separate, from 9):
+	for (int i = 0; i < c_numFroxelCascades; ++i)
+	{
+		Renderer::bindTex(6 + i, GL_TEXTURE_3D, m_evenFrame ? m_oddFogScatterAbsorbTex[i] : m_evenFogScatterAbsorbTex[i]);
+		Renderer::bindTex(9 + i, GL_TEXTURE_3D, m_evenFrame ? m_oddFogScatterAlphaTex[i] : m_evenFogScatterAlphaTex[i]);
+	}
+
+	// Lights' visibility is only baked again when they or the scene changed, then sampled from units 15 up:
+	if (m_useLightVisibilityVolumes)
+	{
+		LightVisibilityVolumes::Scene scene;
+		scene.planetPosition = m_frame->planetPosition;
+		scene.lightPlanes = m_frame->lights.getViewPlanes();
+		scene.shadowMapTechnique = m_frame->shadowMapTechnique;
+
+		m_lightVisibility.update(m_lightVisibilityShader, scene, m_frame->lights, m_visibleLights, m_numVisibleLights);
+		m_lightVisibility.bind(m_fogScatterAbsorbShader, 15, m_visibleLights, m_numVisibleLights);
+	}
+	m_fogScatterAbsorbShader.use();
+	m_fogScatterAbsorbShader.setBool("u_useVisibilityVolumes", m_useLightVisibilityVolumes);
+
+	// Density is only injected again when it's changed, then lit from units 12 up:
+	if (m_cacheFogDensity)
+	{
+		injectFogDensity();
+		for (int i = 0; i < c_numFroxelCascades; ++i)
+			Renderer::bindTex(12 + i, GL_TEXTURE_3D, m_fogDensityTex[i]);
+	}
+	m_fogScatterAbsorbShader.use();
+	m_fogScatterAbsorbShader.setBool("u_useDensityVolume", m_cacheFogDensity);
+
+	dispatchFroxelCascades(m_fogScatterAbsorbShader, m_evenFrame ? m_evenFogScatterAbsorbTex : m_oddFogScatterAbsorbTex, getFroxelInternalFormat(m_allocatedScatterFormat),
+		m_evenFrame ? m_evenFogScatterAlphaTex : m_oddFogScatterAlphaTex);
+	m_froxelHistoryValid = true;
+}
+
+void App::injectFogDensity()
+{
+	const FrameState& frame = *m_frame;
+
+	FogDensityKey key;
+	key.viewProj = m_proj * m_camera.getViewMat();
+	key.noiseOffset = frame.noiseOffset;
+	key.noiseFreq = frame.noiseFreq;
+	key.fogDensity = frame.fogDensity;
+	key.scattering = frame.fogScattering;
+	key.absorption = frame.fogAbsorption;
+	key.useHeterogeneousFog = frame.useHeterogeneousFog;
+	key.linearOrExpFroxels = frame.linearOrExpFroxels;
+	key.useHeightFog = frame.useHeightFog;
+	key.fogHeightRange = frame.fogHeightRange;
+	key.froxelFarPlane = getFroxelFarPlane();
+
+	if (m_fogDensityValid && key == m_fogDensityKey)
+		return;
+
+	Renderer::pushDebugGroup(m_fogDensityText);
+	dispatchFroxelCascades(m_fogDensityShader, m_fogDensityTex, GL_RG16F);
+	Renderer::popDebugGroup();
+
+	// The S&A shader filters the volumes next:
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	m_fogDensityKey = key;
+	m_fogDensityValid = true;
+	++m_fogDensityInjections;
+}
+
+bool App::FogDensityKey::operator==(const FogDensityKey& other) const
+{
+	// As FogClipmap::Medium's, the noise only matters to heterogeneous fog:
+	return viewProj == other.viewProj && fogDensity == other.fogDensity
+		&& scattering == other.scattering && absorption == other.absorption && useHeterogeneousFog == other.useHeterogeneousFog
+		&& linearOrExpFroxels == other.linearOrExpFroxels && useHeightFog == other.useHeightFog && (!useHeightFog || fogHeightRange == other.fogHeightRange)
+		&& froxelFarPlane == other.froxelFarPlane
+		&& (!useHeterogeneousFog || (noiseFreq == other.noiseFreq && noiseOffset == other.noiseOffset));
+}
+
+void App::dispatchFroxelCascades(const Shader& shader, const GLuint* outputTextures, GLenum outputFormat, const GLuint* outputAlphaTextures)
+{
+	for (int i = 0; i < c_numFroxelCascades; ++i)
+	{
+		const FroxelCascade& cascade = m_froxelCascades[i];
+
+		shader.use();
+		shader.setVec3("u_fogTexSize", glm::vec3(cascade.dim.x, cascade.dim.y, m_fogTexSize.z));
+		shader.setInt("u_firstSlice", cascade.firstSlice);
+
+		// Cascades needn't be multiples of the local size, the shaders skip froxels past the edge:
+		const glm::uvec2 numGroups = (glm::uvec2(cascade.dim) + c_fogLocalSize - glm::uvec2(1)) / c_fogLocalSize;
+		FogRenderer::bindImage(1, outputTextures[i], GL_WRITE_ONLY, outputFormat);
+		if (outputAlphaTextures && outputAlphaTextures[i])
+			FogRenderer::bindImage(4, outputAlphaTextures[i], GL_WRITE_ONLY, GL_R16F);
+		FogRenderer::dispatch(glm::uvec3(numGroups, cascade.dim.z), shader);
+	}
+}
+
+void App::accumulateFroxelCascades()
+{
+	const GLuint* scatterTextures = m_evenFrame ? m_evenFogScatterAbsorbTex : m_oddFogScatterAbsorbTex;
+	const GLuint* scatterAlphaTextures = m_evenFrame ? m_evenFogScatterAlphaTex : m_oddFogScatterAlphaTex;
+
+	// Near to far, each cascade carrying on from the last slice of the one in front of it:
+	for (int i = 0; i < c_numFroxelCascades; ++i)
+	{
+		const FroxelCascade& cascade = m_froxelCascades[i];
+
+		Renderer::bindTex(1, GL_TEXTURE_3D, scatterTextures[i]);
+		Renderer::bindTex(2, GL_TEXTURE_3D, scatterAlphaTextures[i]);
+
+		FogRenderer::bindImage(3, m_fogAccumTex[i], GL_WRITE_ONLY, getFroxelInternalFormat(m_allocatedAccumFormat));
+		if (m_fogAccumAlphaTex[i])
+			FogRenderer::bindImage(4, m_fogAccumAlphaTex[i], GL_WRITE_ONLY, GL_R16F);
+		if (i > 0)
+		{
+			Renderer::bindTex(0, GL_TEXTURE_3D, m_fogAccumTex[i - 1]);
+			Renderer::bindTex(3, GL_TEXTURE_3D, m_fogAccumAlphaTex[i - 1]);
+		}
+
+		m_fogAccumShader.use();
+		m_fogAccumShader.setInt("u_firstSlice", cascade.firstSlice);
+		m_fogAccumShader.setInt("u_numSlices", cascade.dim.z);
+		m_fogAccumShader.setVec2("u_cascadeSize", glm::vec2(cascade.dim));
+		FogRenderer::dispatch((cascade.dim.x + c_fogLocalSize.x - 1) / c_fogLocalSize.x, (cascade.dim.y + c_fogLocalSize.y - 1) / c_fogLocalSize.y, 1, m_fogAccumShader);
+
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+}
+
+void App::refineFroxelBricks()
+{
+	m_froxelBricks.classify(m_froxelBrickClassifyShader);
+
+	// Bricks are lit as the scatter shader lights the froxels, with the clipmap's cascades (if it's in use) off its units:
+	bindScatterLightingTextures();
+	m_fogScatterAbsorbShader.use();
+	m_fogScatterAbsorbShader.setVec3("u_fogTexSize", glm::vec3(m_fogTexSize));
+	m_froxelBricks.dispatchFill(m_fogScatterAbsorbShader);
+
+	for (int i = 0; i < c_numFroxelCascades; ++i)
+	{
+		Renderer::bindTex(2 + i, GL_TEXTURE_3D, m_fogAccumTex[i]);
+		Renderer::bindTex(2 + c_numFroxelCascades + i, GL_TEXTURE_3D, m_fogAccumAlphaTex[i]);
+	}
+	m_froxelBricks.dispatchAccumulation(m_froxelBrickAccumShader);
+}
+
+void App::updateFroxelGrid()
+{
+	PROFILE_FUNCTION();
+
+	// Scale the grid to the budget, from the fog passes' time a few frames ago:
+	if (m_useFroxelBudget)
+	{
+		const float scatterMs = m_gpuTimer.getLatestMs(m_fogScatterAbsorbText.c_str());
+		const float accumMs = m_gpuTimer.getLatestMs(m_fogAccumText.c_str());
+		if (scatterMs >= 0.0f && accumMs >= 0.0f)
+			m_froxelBudget.update(scatterMs + accumMs, m_froxelBudgetMs, m_froxelGridScale);
+	}
+	else
+	{
+		// Starts over from fresh timings when it's switched back on:
+		m_froxelGridScale = 1.0f;
+		m_froxelBudget.reset();
+	}
+
+	// Keep the grid within what a cascade can be split into, and what 3D textures allow:
+	m_froxelGrid = glm::clamp(m_froxelGrid, glm::ivec3(16, 9, 8), glm::ivec3(1024, 1024, 256));
+
+	m_scatterVolumeFormat = (FroxelVolumeFormat)glm::clamp((int)m_scatterVolumeFormat, 0, (int)FROXEL_R11G11B10F_R16F);
+	m_accumVolumeFormat = (FroxelVolumeFormat)glm::clamp((int)m_accumVolumeFormat, 0, (int)FROXEL_R11G11B10F_R16F);
+
+	const glm::uvec3 gridSize(glm::max(glm::uvec2(glm::round(glm::vec2(m_froxelGrid) * m_froxelGridScale)), glm::uvec2(1)), m_froxelGrid.z);
+	if (gridSize != m_fogTexSize || m_scatterVolumeFormat != m_allocatedScatterFormat || m_accumVolumeFormat != m_allocatedAccumFormat)
+		allocateFroxelVolumes(gridSize);
+
+	// Last frame's slices can't be reprojected into ones spread over a different depth range:
+	if (getFroxelFarPlane() != m_historyFroxelFarPlane)
+	{
+		m_historyFroxelFarPlane = getFroxelFarPlane();
+		m_froxelHistoryValid = false;
+	}
+}
+
+void App::allocateFroxelVolumes(glm::uvec3 gridSize)
+{
+	PROFILE_FUNCTION();
+	releaseFroxelVolumes();
+
+	// Timings of the old grid or formats say nothing about the new ones (the controller's own changes reset it already):
+	m_froxelBudget.reset();
+
+	// Split the slices between the cascades, near to far, each at a fraction of the grid's XY resolution:
+	GLuint firstSlice = 0;
+	for (int i = 0; i < c_numFroxelCascades; ++i)
+	{
+		FroxelCascade& cascade = m_froxelCascades[i];
+		const GLuint numSlices = i < c_numFroxelCascades - 1 ? std::max((GLuint)(gridSize.z * c_froxelCascadeSliceShare[i] + 0.5f), 2u) : gridSize.z - firstSlice;
+		const glm::uvec2 xy = glm::max(glm::uvec2(glm::round(glm::vec2(gridSize) * c_froxelCascadeXYScale[i])), glm::uvec2(1));
+
+		cascade.dim = glm::uvec3(xy, numSlices);
+		cascade.firstSlice = firstSlice;
+		firstSlice += numSlices;
+
+		const std::string name = " (cascade " + std::to_string(i) + ")";
+		const GLenum scatterFormat = getFroxelInternalFormat(m_scatterVolumeFormat), accumFormat = getFroxelInternalFormat(m_accumVolumeFormat);
+		m_oddFogScatterAbsorbTex[i] = createTexture(cascade.dim, scatterFormat, GPUResourceRegistry::FROXELS, ("Odd fog scatter/absorb volume" + name).c_str());
+		m_evenFogScatterAbsorbTex[i] = createTexture(cascade.dim, scatterFormat, GPUResourceRegistry::FROXELS, ("Even fog scatter/absorb volume" + name).c_str());
+		m_fogAccumTex[i] = createTexture(cascade.dim, accumFormat, GPUResourceRegistry::FROXELS, ("Fog accumulation volume" + name).c_str());
+		m_fogDensityTex[i] = createTexture(cascade.dim, GL_RG16F, GPUResourceRegistry::FROXELS, ("Fog density volume" + name).c_str());
+
+		if (m_scatterVolumeFormat == FROXEL_R11G11B10F_R16F)
+		{
+			m_oddFogScatterAlphaTex[i] = createTexture(cascade.dim, GL_R16F, GPUResourceRegistry::FROXELS, ("Odd fog extinction volume" + name).c_str());
+			m_evenFogScatterAlphaTex[i] = createTexture(cascade.dim, GL_R16F, GPUResourceRegistry::FROXELS, ("Even fog extinction volume" + name).c_str());
+		}
+		if (m_accumVolumeFormat == FROXEL_R11G11B10F_R16F)
+			m_fogAccumAlphaTex[i] = createTexture(cascade.dim, GL_R16F, GPUResourceRegistry::FROXELS, ("Fog transmittance volume" + name).c_str());
+	}
+	m_fogTexSize = gridSize;
+	m_allocatedScatterFormat = m_scatterVolumeFormat;
+	m_allocatedAccumFormat = m_accumVolumeFormat;
+
+	// Bricks are laid out over the whole grid, so they go with it:
+	m_froxelBricks.release();
+	m_froxelBricks.init(gridSize);
+
+	// The shaders that sample across cascades need to know where each one's slices are:
+	for (const Shader* shader : { &m_fogCompositeShader, &m_shader, &m_instanceShader, &m_fogScatterAbsorbShader, &m_froxelBrickAccumShader })
+	{
+		shader->use();
+		for (int i = 0; i < c_numFroxelCascades; ++i)
+			shader->setVec2(SceneUtils::getArrayUniformName("u_cascadeSlices", i), glm::vec2(m_froxelCascades[i].firstSlice, m_froxelCascades[i].dim.z));
+	}
+
+	// And whether alpha is in volumes of its own:
+	const bool scatterSplitAlpha = m_scatterVolumeFormat == FROXEL_R11G11B10F_R16F, accumSplitAlpha = m_accumVolumeFormat == FROXEL_R11G11B10F_R16F;
+	for (const Shader* shader : { &m_fogScatterAbsorbShader, &m_fogClipmapSampleShader })
+	{
+		shader->use();
+		shader->setBool("u_splitAlpha", scatterSplitAlpha);
+	}
+	m_fogAccumShader.use();
+	m_fogAccumShader.setBool("u_scatterSplitAlpha", scatterSplitAlpha);
+	m_fogAccumShader.setBool("u_splitAlpha", accumSplitAlpha);
+	for (const Shader* shader : { &m_fogCompositeShader, &m_shader, &m_instanceShader, &m_froxelBrickAccumShader })
+	{
+		shader->use();
+		shader->setBool("u_splitAlpha", accumSplitAlpha);
+	}
+
+	// New volumes hold nothing to reproject, or to light:
+	m_froxelHistoryValid = false;
+	m_fogDensityValid = false;
+	m_captureFogSlice = std::min(m_captureFogSlice, (int)gridSize.z - 1);
+}
+
+void App::releaseFroxelVolumes()
+{
+	if (m_fogTexSize == glm::uvec3(0))
+		return;
+
+	for (int i = 0; i < c_numFroxelCascades; ++i)
+	{
+		GPUResourceRegistry::deleteTexture(m_evenFogScatterAbsorbTex[i]);
+		GPUResourceRegistry::deleteTexture(m_oddFogScatterAbsorbTex[i]);
+		GPUResourceRegistry::deleteTexture(m_fogAccumTex[i]);
+		GPUResourceRegistry::deleteTexture(m_fogDensityTex[i]);
+		GPUResourceRegistry::deleteTexture(m_evenFogScatterAlphaTex[i]);
+		GPUResourceRegistry::deleteTexture(m_oddFogScatterAlphaTex[i]);
+		GPUResourceRegistry::deleteTexture(m_fogAccumAlphaTex[i]);
+	}
+	m_froxelBricks.release();
+	m_fogTexSize = glm::uvec3(0);
+}
+
+GLenum App::getFroxelInternalFormat(FroxelVolumeFormat format)
+{
+	switch (format)
+	{
+	case FROXEL_RGBA16F:
+		return GL_RGBA16F;
+	case FROXEL_R11G11B10F_R16F:
+		return GL_R11F_G11F_B10F;
+	case FROXEL_RGBA32F:
+	default:
+		return GL_RGBA32F;
+	}
+}
+
+const char* App::getFroxelFormatName(int format)
+{
+	static const char* const names[] = { "RGBA32F", "RGBA16F", "R11G11B10F + R16F" };
+	return names[glm::clamp(format, 0, 2)];
+}
+
+void App::measureFroxelFormatError()
+{
+	PROFILE_FUNCTION();
+	redrawCompositeInputs();
+
+	// Reads the accumulated volumes back as RGBA, near cascade first:
+	auto readAccumulated = [this]() {
+		std::vector<glm::vec4> texels;
+		for (int i = 0; i < c_numFroxelCascades; ++i)
+		{
+			const glm::uvec3 dim = m_froxelCascades[i].dim;
+			std::vector<glm::vec4> cascade((size_t)dim.x * dim.y * dim.z);
+			glBindTexture(GL_TEXTURE_3D, m_fogAccumTex[i]);
+			glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_FLOAT, cascade.data());
+
+			if (m_fogAccumAlphaTex[i])
+			{
+				std::vector<float> alpha(cascade.size());
+				glBindTexture(GL_TEXTURE_3D, m_fogAccumAlphaTex[i]);
+				glGetTexImage(GL_TEXTURE_3D, 0, GL_RED, GL_FLOAT, alpha.data());
+				for (size_t t = 0; t < cascade.size(); ++t)
+					cascade[t].a = alpha[t];
+			}
+			texels.insert(texels.end(), cascade.begin(), cascade.end());
+		}
+		glBindTexture(GL_TEXTURE_3D, 0);
+		return texels;
+	};
+
+	// Reruns this frame's fog passes into freshly allocated volumes (so without temporal history), and composites them:
+	auto renderFog = [this](FroxelVolumeFormat scatterFormat, FroxelVolumeFormat accumFormat) {
+		m_scatterVolumeFormat = scatterFormat;
+		m_accumVolumeFormat = accumFormat;
+		allocateFroxelVolumes(m_fogTexSize);
+
+		// The scatter shader's history flag was set for this frame, before the reallocation:
+		m_fogScatterAbsorbShader.use();
+		m_fogScatterAbsorbShader.setBool("u_historyValid", false);
+		runFogScatterAbsorb();
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+		accumulateFroxelCascades();
+
+		Renderer::setViewport(m_windowDim);
+		Renderer::setTarget(m_outputFBO);
+		m_froxelBricks.bind(m_fogCompositeShader, 2 + 2 * c_numFroxelCascades);	// Reallocated, so without any bricks.
+		FogRenderer::compositeFog(m_fullscreenQuadVAO, m_FBOColourBuffer, m_FBODepthBuffer, m_fogAccumTex, m_fogAccumAlphaTex, c_numFroxelCascades, m_fogCompositeShader);
+
+		std::vector<glm::vec3> frame((size_t)m_windowDim.x * m_windowDim.y);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_outputFBO);
+		glReadBuffer(m_outputFBO ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+		glReadPixels(0, 0, m_windowDim.x, m_windowDim.y, GL_RGB, GL_FLOAT, frame.data());
+		return frame;
+	};
+
+	const FroxelVolumeFormat scatterFormat = m_scatterVolumeFormat, accumFormat = m_accumVolumeFormat;
 
-		Renderer::pushDebugGroup(m_planeRenderText);
-		{
-			m_shader.use();
-			m_shader.setMat4("world", m_planeWorld);
-			//Renderer::draw(m_planeVAO, 6, m_shader);
-		}
-		Renderer::popDebugGroup();
+	const std::vector<glm::vec3> referenceFrame = renderFog(FROXEL_RGBA32F, FROXEL_RGBA32F);
+	const std::vector<glm::vec4> reference = readAccumulated();
 
-		Renderer::pushDebugGroup(m_debugRenderText);
+	m_froxelFormatErrors.clear();
+	for (int s = FROXEL_RGBA32F; s <= FROXEL_R11G11B10F_R16F; ++s)
+	{
+		for (int a = FROXEL_RGBA32F; a <= FROXEL_R11G11B10F_R16F; ++a)
 		{
-			glDisable(GL_CULL_FACE);
-			for (int i = 0; i < m_numActiveLights; ++i)
+			FroxelFormatError error{};
+			error.scatterFormat = (FroxelVolumeFormat)s;
+			error.accumFormat = (FroxelVolumeFormat)a;
+			error.composite = ImageMetrics::compare(renderFog(error.scatterFormat, error.accumFormat), referenceFrame, m_windowDim);
+
+			// Two scattering volumes (this frame's and last frame's), the accumulated one and the RG16F density one per cascade:
+			const int bytesPerTexel[] = { 16, 8, 4 + 2 };
+			const int densityBytesPerTexel = 4;
+			for (const FroxelCascade& cascade : m_froxelCascades)
+				error.bytes += (uint64_t)cascade.dim.x * cascade.dim.y * cascade.dim.z * (2 * bytesPerTexel[s] + bytesPerTexel[a] + densityBytesPerTexel);
+
+			const std::vector<glm::vec4> accumulated = readAccumulated();
+			for (size_t t = 0; t < accumulated.size(); ++t)
 			{
-				m_lightCubeWorld = glm::translate(glm::mat4(1.0f), m_pointLightPosition[i]);
-				m_lightCubeWorld = glm::scale(m_lightCubeWorld, glm::vec3(0.25f));
-
-				m_singleColourShader.use();
-				m_singleColourShader.setMat4("world", m_lightCubeWorld);
-				Renderer::draw(m_lightCubeVAO, 36, m_singleColourShader);
+				const glm::vec3 inScatteringError = glm::abs(glm::vec3(accumulated[t]) - glm::vec3(reference[t]));
+				error.maxInScatteringError = std::max({ error.maxInScatteringError, inScatteringError.r, inScatteringError.g, inScatteringError.b });
+				error.maxTransmittanceError = std::max(error.maxTransmittanceError, std::abs(accumulated[t].a - reference[t].a));
 			}
-			glEnable(GL_CULL_FACE);
+			m_froxelFormatErrors.push_back(error);
 		}
-		Renderer::popDebugGroup();
 	}
-	Renderer::popDebugGroup();
 
-	// Block image read/write operations:
-	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-
-	// Force wireframe mode off for FBO render if wireframe is on:
-	if (m_wireframe)
-		Renderer::setWireframe(false);
+	// Leave the volumes (and the frame on screen) as they were chosen:
+	renderFog(scatterFormat, accumFormat);
+	m_fogScatterAbsorbShader.use();
+	m_fogScatterAbsorbShader.setBool("u_historyValid", m_froxelHistoryValid);
+
+	std::cout << "Froxel volume format error against FP32 (" << m_fogTexSize.x << "x" << m_fogTexSize.y << "x" << m_fogTexSize.z << " grid):" << std::endl;
+	for (const FroxelFormatError& error : m_froxelFormatErrors)
+		std::cout << "  Scattering " << getFroxelFormatName(error.scatterFormat) << ", accumulation " << getFroxelFormatName(error.accumFormat)
+			<< ": " << error.bytes / (1024.0 * 1024.0) << " MB, max in-scattering error " << error.maxInScatteringError
+			<< ", max transmittance error " << error.maxTransmittanceError << ", composite RMSE " << error.composite.rmse
+			<< ", SSIM " << error.composite.ssim << ", FLIP " << error.composite.flip << std::endl;
+}
 
-	// Composite fog onto final render (fragment shader) ---------------------------------------------------------
-	Renderer::pushDebugGroup(m_fogCompositionText);
+void App::registerBenchmarkParameters()
+{
+	// Fog parameters:
+	m_benchmark.bindBool("applyFog", &m_applyFog);
+	m_benchmark.bindFloat("fogScattering", &m_fogScattering);
+	m_benchmark.bindFloat("fogAbsorption", &m_fogAbsorption);
+	m_benchmark.bindVec3("fogAlbedo", &m_fogAlbedo);
+	m_benchmark.bindFloat("fogPhaseGParam", &m_fogPhaseGParam);
+	m_benchmark.bindFloat("fogDensity", &m_fogDensity);
+	m_benchmark.bindBool("useHeterogeneousFog", &m_useHeterogeneousFog);
+	m_benchmark.bindBool("useHeightFog", &m_useHeightFog);
+	m_benchmark.bindFloat("fogHeightBase", &m_fogHeightRange.x);
+	m_benchmark.bindFloat("fogHeightScale", &m_fogHeightRange.y);
+	m_benchmark.bindFloat("noiseFreq", &m_noiseFreq);
+	m_benchmark.bindVec3("noiseOffset", &m_noiseOffset);
+	m_benchmark.bindVec3("windDirection", &m_windDirection);
+
+	// Technique toggles:
+	m_benchmark.bindBool("useShadows", &m_useShadows);
+	m_benchmark.bindBool("useTemporal", &m_useTemporal);
+	m_benchmark.bindBool("useJitter", &m_useJitter);
+	m_benchmark.bindBool("useScreenspaceJitter", &m_useScreenspaceJitter);
+	m_benchmark.bindBool("useLUT", &m_useLUT);
+	m_benchmark.bindBool("hooblerOrKovalovs", &m_hooblerOrKovalovs);
+	m_benchmark.bindBool("linearOrExpFroxels", &m_linearOrExpFroxels);
+	m_benchmark.bindBool("useFogClipmap", &m_useFogClipmap);
+	m_benchmark.bindBool("useFroxelBricks", &m_useFroxelBricks);
+	m_benchmark.bindBool("cacheFogDensity", &m_cacheFogDensity);
+	m_benchmark.bindBool("useLightVisibilityVolumes", &m_useLightVisibilityVolumes);
+	m_benchmark.bindBool("useForwardFog", &m_useForwardFog);
+	m_benchmark.bindBool("useTricubicFog", &m_useTricubicFog);
+	m_benchmark.bindFloat("fogUpsampleDepthSharpness", &m_fogUpsampleDepthSharpness);
+	m_benchmark.bindBool("useAnalyticFarFog", &m_useAnalyticFarFog);
+	m_benchmark.bindFloat("froxelFarPlane", &m_froxelFarPlane);
+	m_benchmark.bindFloat("brickDensityThreshold", &m_brickDensityThreshold);
+	m_benchmark.bindInt("froxelGridWidth", &m_froxelGrid.x);
+	m_benchmark.bindInt("froxelGridHeight", &m_froxelGrid.y);
+	m_benchmark.bindInt("froxelGridSlices", &m_froxelGrid.z);
+	m_benchmark.bindBool("useFroxelBudget", &m_useFroxelBudget);
+	m_benchmark.bindFloat("froxelBudgetMs", &m_froxelBudgetMs);
+	m_benchmark.bindInt("shadowMapTechnique", (int*)&m_shadowMapTechnique);
+	m_benchmark.bindInt("froxelAmortisation", &m_froxelAmortisation);
+	m_benchmark.bindInt("froxelAmortisationPattern", (int*)&m_froxelAmortisationPattern);
+	m_benchmark.bindInt("lightSamplesPerFroxel", &m_lightSamplesPerFroxel);
+	m_benchmark.bindInt("scatterVolumeFormat", (int*)&m_scatterVolumeFormat);
+	m_benchmark.bindInt("accumVolumeFormat", (int*)&m_accumVolumeFormat);
+
+	// Light parameters:
+	m_benchmark.bindInt("numActiveLights", (int*)&m_numActiveLights);
+	m_benchmark.bindFloat("lightIntensity", &m_lightIntensity);
+	for (int i = 0; i < NUM_LIGHTS; ++i)
 	{
-		Renderer::resetTarget();
-		Renderer::clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Render fullscreen quad, applying accumulated fog if desired:
-		m_applyFog ? FogRenderer::compositeFog(m_fullscreenQuadVAO, m_FBOColourBuffer, m_FBODepthBuffer, m_fogAccumTex, m_fogCompositeShader)
-			: Renderer::drawFBO(m_fullscreenQuadVAO, m_fullscreenShader, *m_currentOutputBuffer, GL_TEXTURE_2D);
+		m_benchmark.bindVec3("lightPosition" + std::to_string(i), &m_lightSettings[i].position);
+		m_benchmark.bindVec3("lightDiffuse" + std::to_string(i), &m_lightSettings[i].diffuse);
+		m_benchmark.bindFloat("lightRadius" + std::to_string(i), &m_lightSettings[i].radius);
 	}
-	Renderer::popDebugGroup();
-
-	// Restore wireframe mode to on:
-	if (m_wireframe)
-		Renderer::setWireframe(true);
+}
 
-#ifdef NV_PERF_ENABLE_INSTRUMENTATION
-	g_nvPerfSDKReportGenerator.OnFrameEnd();
-#endif
+bool App::startBenchmark(const std::string& filePath)
+{
+	if (!m_benchmark.load(filePath))
+		return false;
 
-	// Setup this frame's view * proj matrix to be used in the next frame for temporal reprojection:
-	glBufferSubData(GL_UNIFORM_BUFFER, 3 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(m_proj * m_camera.getViewMat()));
+	m_benchmark.start();
+	return true;
 }
 
-void App::gui()
+void App::updateCameraTrack()
 {
-	Renderer::pushDebugGroup(m_uiRenderText);
+	if (m_cameraTrack.isRecording())
+		m_cameraTrack.record(m_dt, makeCameraTrackSample());
+	else if (m_cameraTrack.isPlaying())
 	{
-		// Start new ImGui frame:
-		ImGui_ImplGlfw_NewFrame();
-		ImGui_ImplOpenGL3_NewFrame();
-		ImGui::NewFrame();
+		CameraTrack::Sample sample;
+		if (m_cameraTrack.advance(sample))
+		{
+			applyCameraTrackSample(sample);
+			m_dt = m_cameraTrack.getTimestep();
+		}
+	}
+}
 
-		ImGui::Begin("ImGui");
+CameraTrack::Sample App::makeCameraTrackSample()
+{
+	CameraTrack::Sample sample;
+	sample.position = m_camera.getPosition();
+	sample.pitch = m_camera.getPitch();
+	sample.yaw = m_camera.getYaw();
+	sample.fogDensity = m_fogDensity;
+	sample.fogScattering = m_fogScattering;
+	sample.fogAbsorption = m_fogAbsorption;
+	sample.fogPhaseGParam = m_fogPhaseGParam;
+	sample.noiseOffset = m_noiseOffset;
+	return sample;
+}
+
+void App::applyCameraTrackSample(const CameraTrack::Sample& sample)
+{
+	CameraTrack::applyToCamera(sample, m_camera);
+	m_fogDensity = sample.fogDensity;
+	m_fogScattering = sample.fogScattering;
+	m_fogAbsorption = sample.fogAbsorption;
+	m_fogPhaseGParam = sample.fogPhaseGParam;
+	m_noiseOffset = sample.noiseOffset;
+}
+
+void App::buildReferenceScene()
+{
+	PROFILE_FUNCTION();
+
+	// Add each model's meshes once (in object space), then an instance per placement:
+	auto addModel = [&](const Model& model) {
+		std::vector<int> meshes;
+		for (const Mesh& mesh : model.m_meshes)
 		{
-			ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-			ImGui::Text("Camera position: (%f, %f, %f)", m_camera.getPosition().x, m_camera.getPosition().y, m_camera.getPosition().z);
-			ImGui::Text("Number of test iterations per scenario (max 500):");
-			ImGui::DragInt("", (int*)&m_numTestIterations, 1.0f, 1, 500);
+			std::vector<glm::vec3> positions;
+			positions.reserve(mesh.m_vertices.size());
+			for (const VAO::Vertex& vertex : mesh.m_vertices)
+				positions.push_back(vertex.position);
+			meshes.push_back(m_referenceRenderer.addMesh(positions, mesh.m_indices));
+		}
+		return meshes;
+	};
 
-			if (!m_currentlyTesting)
-			{
-				ImGui::Checkbox("Output depth", &m_outputDepth);
-				ImGui::Checkbox("Apply fog", &m_applyFog);
+	m_referenceRenderer.clear();
+	for (int mesh : addModel(m_planet))
+		m_referenceRenderer.addInstance(mesh, m_planet.getWorldMat());
+	for (int mesh : addModel(m_rock))
+		for (const glm::mat4& world : m_asteroidMatrices)
+			m_referenceRenderer.addInstance(mesh, world);
 
-				if (ImGui::Button("Start testing"))
-				{
-					m_currentlyTesting = true;
-					m_testingSetup = TestingSetup::START_VAL;
-					m_currentIteration = m_numTestIterations;
-				}
+	m_referenceRenderer.build();
+	m_referenceSceneBuilt = true;
+}
 
-				if (ImGui::CollapsingHeader("Fog parameters"))
-				{
-					if (ImGui::Button("Regenerate LUTs"))
-						generateLUTs();
+bool App::renderReference(const std::string& outputPrefix)
+{
+	PROFILE_FUNCTION();
 
-					ImGui::SliderFloat("Noise frequency", &m_noiseFreq, 0.001f, 1.0f);
-					ImGui::SliderFloat3("Wind direction", &m_windDirection.x, -1.0, 1.0f);
-					ImGui::SliderFloat3("Fog albedo", &m_fogAlbedo.x, 0.0f, 1.0f);
-					ImGui::SliderFloat("Fog scattering", &m_fogScattering, 0.0f, 10.0f);
-					ImGui::SliderFloat("Fog absorption", &m_fogAbsorption, 0.0f, 10.0f);
-					ImGui::SliderFloat("Fog phase g-parameter", &m_fogPhaseGParam, -0.999f, 0.999f);
+	m_referenceSettings.resolution = m_windowDim;
+	const ReferenceRenderer::Image image = renderReferenceFog(m_referenceSettings);
 
-					ImGui::Checkbox("Use heterogenous density?", &m_useHeterogeneousFog);
-					ImGui::SliderFloat("Fog density scalar", &m_fogDensity, 0.0f, 1.0f);
-					ImGui::Checkbox("Use temporal filtering?", &m_useTemporal);
-					ImGui::Checkbox("Use sample jittering?", &m_useJitter);
-					ImGui::Checkbox("Use screenspace jitter?", &m_useScreenspaceJitter);
-					ImGui::Checkbox("Use LUT?", &m_useLUT);
-					if (m_useLUT)
-					{
-						ImGui::Checkbox("Hoobler or Kovalovs?", &m_hooblerOrKovalovs);
-						if (m_hooblerOrKovalovs)
-							ImGui::Text("Current LUT: Kovalovs");
-						else
-							ImGui::Text("Current LUT: Hoobler");
-					}
+	// Composite over the colour pass exactly as the fog composite shader does:
+	const std::vector<glm::vec3> composited = ReferenceRenderer::composite(image, readSurfaceColour());
 
-					ImGui::SliderInt("Shadow Map Technique", (int*)&m_shadowMapTechnique, 0, 2);
-					switch (m_shadowMapTechnique)
-					{
-					case STANDARD:
-						ImGui::Text("Current technique: Standard shadow mapping");
-						break;
-					case VSM:
-						ImGui::Text("Current technique: Variance shadow mapping");
-						break;
-					case ESM:
-						ImGui::Text("Current technique: Exponential shadow mapping");
-						break;
-					}
+	if (!ReferenceRenderer::writePFM(outputPrefix + "_inscattering.pfm", image.dim, &image.inScattering[0].x, 3)
+		|| !ReferenceRenderer::writePFM(outputPrefix + "_transmittance.pfm", image.dim, image.transmittance.data(), 1)
+		|| !ReferenceRenderer::writePFM(outputPrefix + ".pfm", image.dim, &composited[0].x, 3))
+		return false;
 
-					ImGui::Checkbox("Exponential or linear froxels?", &m_linearOrExpFroxels);
-					if (m_linearOrExpFroxels)
-						ImGui::Text("Froxel depth distribution: linear");
-					else
-						ImGui::Text("Froxel depth distribution: exponential");
-				}
-				if (ImGui::CollapsingHeader("Light parameters"))
-				{
-					ImGui::SliderInt("Num active lights", (int*)&m_numActiveLights, 1, NUM_LIGHTS);
-					ImGui::SliderInt("Current light", (int*)&m_currentLight, 0, NUM_LIGHTS - 1);
-					ImGui::SliderFloat3("Light position", &m_pointLightPosition[m_currentLight].x, -50.0f, 50.0f);
-					ImGui::SliderFloat3("Light diffuse", &m_pointLightDiffuse[m_currentLight].r, 0.0f, 1.0f);
-					ImGui::SliderFloat("Light radius", &m_pointLightRadius[m_currentLight], 1.0f, 100.0f);
-					ImGui::DragFloat("Light intensity", &m_lightIntensity, 0.2f, 0.0f);
-					ImGui::SliderFloat("Light constant", &m_pointLightConstant, 0.0f, 1.0f);
-					ImGui::SliderFloat("Light linear", &m_pointLightLinear, 0.0f, 1.0f);
-					ImGui::SliderFloat("Light quadratic", &m_pointLightQuadratic, 0.0f, 1.0f);
-				}
-			}
-			else
-			{
-				if (ImGui::Button("Stop testing"))
-				{
-					m_currentlyTesting = false;
-					m_testingSetup = TestingSetup::START_VAL;
-				}
+	std::cout << "Wrote reference fog to " << outputPrefix << ".pfm, _inscattering.pfm and _transmittance.pfm" << std::endl;
+	return true;
+}
 
-				ImGui::Text("Test iteration: %i out of %i", m_currentIteration + 1, m_numTestIterations);
-				ImGui::Text("Testing scenario: %i out of 6", (int)m_testingSetup + 1);
-			}
-		}
-		ImGui::End();
+ReferenceRenderer::Image App::renderReferenceFog(const ReferenceRenderer::Settings& settings)
+{
+	PROFILE_FUNCTION();
 
-		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-	}
-	Renderer::popDebugGroup();
+	if (!m_referenceSceneBuilt)
+		buildReferenceScene();
+
+	// Lights and fog as currently set, so the reference matches the last rendered frame:
+	m_referenceRenderer.clearLights();
+	for (int i = 0; i < m_numActiveLights; ++i)
+		m_referenceRenderer.addLight({ m_lightSettings[i].position, m_lightSettings[i].diffuse * m_lightIntensity, m_pointLightConstant, m_pointLightLinear, m_pointLightQuadratic,
+			m_lightSettings[i].radius });
+
+	ReferenceRenderer::Medium medium;
+	medium.density = m_fogDensity;
+	medium.scattering = m_fogScattering;
+	medium.absorption = m_fogAbsorption;
+	medium.phaseG = m_fogPhaseGParam;
+	medium.albedo = m_fogAlbedo;
+	medium.heterogeneous = m_useHeterogeneousFog;
+	medium.noiseFreq = m_noiseFreq;
+	medium.noiseOffset = m_noiseOffset;
+	medium.heightFog = m_useHeightFog;
+	medium.heightRange = m_fogHeightRange;
+
+	return m_referenceRenderer.render(m_camera.getViewMat(), m_proj, m_farPlane, medium, settings);
 }
 
-void App::runFogScatterAbsorb()
+std::vector<glm::vec3> App::readSurfaceColour()
 {
-	// Bind unblurred shadowmaps if using standard shadowmapping:
-	if (m_shadowMapTechnique == STANDARD)
-		Renderer::bindTex(0, GL_TEXTURE_2D_ARRAY, m_pointShadowmapArrayColour);
-	// Otherwise, bind blurred shadowmaps:
-	else
-		Renderer::bindTex(0, GL_TEXTURE_2D_ARRAY, m_vertBlurShadowmapArrayColour);
+	redrawCompositeInputs();
 
-	if (m_evenFrame)
-	{
-		FogRenderer::bindImage(1, m_evenFogScatterAbsorbTex, GL_WRITE_ONLY, GL_RGBA32F);
-		Renderer::bindTex(1, GL_TEXTURE_3D, m_oddFogScatterAbsorbTex);
-	}
-	else
+	std::vector<glm::vec3> surfaceColour((size_t)m_windowDim.x * m_windowDim.y);
+	glBindTexture(GL_TEXTURE_2D, m_FBOColourBuffer);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_FLOAT, surfaceColour.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return surfaceColour;
+}
+
+void App::scoreBenchmarkQuality()
+{
+	PROFILE_FUNCTION();
+
+	// The composited frame, still in the back buffer (or headless output FBO):
+	std::vector<glm::vec3> frame((size_t)m_windowDim.x * m_windowDim.y);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_outputFBO);
+	glReadBuffer(m_outputFBO ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+	glReadPixels(0, 0, m_windowDim.x, m_windowDim.y, GL_RGB, GL_FLOAT, frame.data());
+
+	// The reference only depends on the camera, fog and lights, so runs comparing techniques share one:
+	std::ostringstream key;
+	key << std::setprecision(9);
+	const glm::mat4 view = m_camera.getViewMat();
+	for (int i = 0; i < 16; ++i)
+		key << view[i / 4][i % 4] << " ";
+	key << m_applyFog << " " << m_fogDensity << " " << m_fogScattering << " " << m_fogAbsorption << " " << m_fogPhaseGParam << " "
+		<< m_fogAlbedo.x << " " << m_fogAlbedo.y << " " << m_fogAlbedo.z << " " << m_useHeterogeneousFog << " " << m_noiseFreq << " "
+		<< m_noiseOffset.x << " " << m_noiseOffset.y << " " << m_noiseOffset.z << " " << m_lightIntensity << " " << m_useHeightFog << " "
+		<< m_fogHeightRange.x << " " << m_fogHeightRange.y << " " << m_pointLightConstant << " " << m_pointLightLinear << " "
+		<< m_pointLightQuadratic << " " << m_lightViewPlanes.x << " " << m_lightViewPlanes.y;
+	for (int i = 0; i < m_numActiveLights; ++i)
+		key << " " << m_lightSettings[i].position.x << " " << m_lightSettings[i].position.y << " " << m_lightSettings[i].position.z << " "
+			<< m_lightSettings[i].diffuse.x << " " << m_lightSettings[i].diffuse.y << " " << m_lightSettings[i].diffuse.z << " " << m_lightSettings[i].radius;
+
+	auto it = m_qualityReferences.find(key.str());
+	if (it == m_qualityReferences.end())
 	{
-		FogRenderer::bindImage(1, m_oddFogScatterAbsorbTex, GL_WRITE_ONLY, GL_RGBA32F);
-		Renderer::bindTex(1, GL_TEXTURE_3D, m_evenFogScatterAbsorbTex);
+		ReferenceRenderer::Settings settings = m_referenceSettings;
+		settings.resolution = m_windowDim;
+		settings.samplesPerPixel = m_benchmark.getReferenceSamplesPerPixel();
+		settings.stepsPerSample = m_benchmark.getReferenceStepsPerSample();
+		settings.lightTransmittance = true;
+
+		std::cout << "Rendering quality reference for " << m_benchmark.getCurrentRunName() << "..." << std::endl;
+		it = m_qualityReferences.emplace(key.str(), renderReferenceFog(settings)).first;
 	}
-	if (m_hooblerOrKovalovs)
-		Renderer::bindTex(2, GL_TEXTURE_2D, m_kovalovsLUT);		// Use Kovalovs' LUT (true).
-	else
-		for (int i = 0; i < m_numActiveLights; ++i)
-			Renderer::bindTex(2 + i, GL_TEXTURE_2D, m_hooblerSumLUT[i]);	// Use Hoobler's LUT (false).
 
-	FogRenderer::dispatch(c_fogNumWorkGroups, m_fogScatterAbsorbShader);
+	// Without fog the fullscreen shader shows the colour pass as it is:
+	std::vector<glm::vec3> reference = readSurfaceColour();
+	if (m_applyFog)
+		reference = ReferenceRenderer::composite(it->second, reference);
+
+	m_benchmark.addQualityScores(ImageMetrics::compare(frame, reference, m_windowDim));
 }
 
 void App::setupMatrices()
 {
+	PROFILE_FUNCTION();
+
 	m_planeWorld = glm::mat4(1.0f);
 	m_planeWorld = glm::translate(m_planeWorld, glm::vec3(0.0f, -10.0f, 0.0f));
 	m_planeWorld = glm::scale(m_planeWorld, glm::vec3(20.0f, 1.0f, 20.0f));
@@ -850,40 +2069,22 @@ void App::setupMatrices()
 	// Setup projection matrix:
 	m_proj = glm::perspective(glm::radians(45.0f), (float)m_windowDim.x / (float)m_windowDim.y, m_nearPlane, m_farPlane);
 
-	// Setup instanced asteroid matrices:
+	// Setup instanced asteroid matrices (kept on the CPU for the reference renderer):
 	const float radius = 50.0f, offset = 2.5f;
-	glm::mat4* worldMatrices = new glm::mat4[c_asteroidsCount];
-
-	// Build array of world matrices for asteroids/rocks:
-	for (size_t i = 0; i < c_asteroidsCount; i++)
-	{
-		// Randomise distance to planet in range (-offset, offset):
-		float angle = (float)i / (float)c_asteroidsCount * 360.0f;
-		float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-		float x = sin(angle) * radius + displacement;
-
-		displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-		float y = displacement * 0.4f;
-
-		displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-		float z = cos(angle) * radius + displacement;
+	m_asteroidMatrices.resize(c_asteroidsCount);
 
-		glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
+	// Build array of world matrices for asteroids/rocks (random numbers are drawn in order, matrices in parallel):
+	std::vector<SceneUtils::AsteroidRandoms> asteroidRandoms(c_asteroidsCount);
+	SceneUtils::drawAsteroidRandoms(asteroidRandoms.data(), c_asteroidsCount);
+	JobSystem::parallelFor("Asteroid matrices", c_asteroidsCount, 256, [&](size_t begin, size_t end) {
+		SceneUtils::buildAsteroidMatrices(m_asteroidMatrices.data(), asteroidRandoms.data(), begin, end, c_asteroidsCount, radius, offset);
+	});
 
-		// Randomise scale in the range (0.05, 0.25):
-		float scale = (rand() % 20) / 100.0f + 0.05f;
-		world = glm::scale(world, glm::vec3(scale));
-
-		// Randomise rotation around an arbitrary axis:
-		float rotAngle = (rand() % 360);
-		world = glm::rotate(world, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-		worldMatrices[i] = world;
-	}
 	// Setup instanced array of world matrices:
 	glGenBuffers(1, &m_asteroidMatricesVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_asteroidMatricesVBO);
-	glBufferData(GL_ARRAY_BUFFER, c_asteroidsCount * sizeof(glm::mat4), &worldMatrices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, c_asteroidsCount * sizeof(glm::mat4), m_asteroidMatrices.data(), GL_STATIC_DRAW);
+	GPUResourceRegistry::registerBuffer(m_asteroidMatricesVBO, GPUResourceRegistry::MESHES, "Asteroid matrices VBO", c_asteroidsCount * sizeof(glm::mat4));
 
 	// Bind instanced asteroid matrices to asteroid mesh's VAO:
 	for (size_t i = 0; i < m_rock.m_meshes.size(); i++)
@@ -907,12 +2108,12 @@ void App::setupMatrices()
 		glVertexAttribDivisor(6, 1);
 		glBindVertexArray(0);
 	}
-
-	delete[] worldMatrices;
 }
 
 void App::setupShaders()
 {
+	PROFILE_FUNCTION();
+
 	// Load and compile shader files:
 	m_shader.loadShader("shaders/textureShader.vert", "shaders/textureShader.frag");
 	m_singleColourShader.loadShader("shaders/textureShader.vert", "shaders/singleColourShader.frag");
@@ -922,8 +2123,14 @@ void App::setupShaders()
 	m_fullscreenShader.loadShader("shaders/fullscreenShader.vert", "shaders/fullscreenShader.frag");
 
 	m_fogScatterAbsorbShader.loadShader("shaders/fogScatterAbsorbShader.comp");
+	m_fogDensityShader.loadShader("shaders/fogDensityShader.comp");
 	m_fogAccumShader.loadShader("shaders/fogAccumulationShader.comp");
 	m_fogCompositeShader.loadShader("shaders/fullscreenShader.vert", "shaders/fogCompositeShader.frag");
+	m_fogClipmapUpdateShader.loadShader("shaders/fogClipmapUpdateShader.comp");
+	m_fogClipmapSampleShader.loadShader("shaders/fogClipmapSampleShader.comp");
+	m_froxelBrickClassifyShader.loadShader("shaders/froxelBrickClassifyShader.comp");
+	m_froxelBrickAccumShader.loadShader("shaders/froxelBrickAccumShader.comp");
+	m_lightVisibilityShader.loadShader("shaders/lightVisibilityShader.comp");
 
 	m_varianceShadowmapLayeredShader.loadShader("shaders/worldSpaceShader.vert", "shaders/varianceShadowShader.frag", "shaders/layeredShadowShader.geom");
 	m_instanceVarianceShadowmapLayeredShader.loadShader("shaders/instancedShadowShader.vert", "shaders/varianceShadowShader.frag", "shaders/layeredShadowShader.geom");
@@ -938,7 +2145,40 @@ void App::setupShaders()
 	m_fogCompositeShader.use();
 	m_fogCompositeShader.setInt("u_colourTex", 0);
 	m_fogCompositeShader.setInt("u_depthTex", 1);
-	m_fogCompositeShader.setInt("u_fogAccumTex", 2);
+	for (int i = 0; i < c_numFroxelCascades; ++i)
+	{
+		m_fogCompositeShader.setInt(SceneUtils::getArrayUniformName("u_fogAccumTex", i), 2 + i);
+		m_fogCompositeShader.setInt(SceneUtils::getArrayUniformName("u_fogAccumAlphaTex", i), 2 + c_numFroxelCascades + i);
+	}
+	m_fogCompositeShader.setInt("u_brickTable", 2 + 2 * c_numFroxelCascades);
+	m_fogCompositeShader.setInt("u_brickAtlas", 3 + 2 * c_numFroxelCascades);
+
+	// The surface shaders, for forward fog, sample them past the meshes' textures:
+	for (const Shader* surfaceShader : { &m_shader, &m_instanceShader })
+	{
+		surfaceShader->use();
+		for (int i = 0; i < c_numFroxelCascades; ++i)
+		{
+			surfaceShader->setInt(SceneUtils::getArrayUniformName("u_fogAccumTex", i), c_forwardFogFirstUnit + i);
+			surfaceShader->setInt(SceneUtils::getArrayUniformName("u_fogAccumAlphaTex", i), c_forwardFogFirstUnit + c_numFroxelCascades + i);
+		}
+		surfaceShader->setInt("u_brickTable", c_forwardFogFirstUnit + 2 * c_numFroxelCascades);
+		surfaceShader->setInt("u_brickAtlas", c_forwardFogFirstUnit + 1 + 2 * c_numFroxelCascades);
+	}
+
+	// The brick accumulation shader samples the accumulated cascades on the same units as the composite:
+	m_froxelBrickAccumShader.use();
+	for (int i = 0; i < c_numFroxelCascades; ++i)
+	{
+		m_froxelBrickAccumShader.setInt(SceneUtils::getArrayUniformName("u_fogAccumTex", i), 2 + i);
+		m_froxelBrickAccumShader.setInt(SceneUtils::getArrayUniformName("u_fogAccumAlphaTex", i), 2 + c_numFroxelCascades + i);
+	}
+
+	m_fogAccumShader.use();
+	m_fogAccumShader.setInt("u_previousCascade", 0);
+	m_fogAccumShader.setInt("u_scatterVolume", 1);
+	m_fogAccumShader.setInt("u_scatterAlpha", 2);
+	m_fogAccumShader.setInt("u_previousCascadeAlpha", 3);
 
 	m_horiBlurLayeredShader.use();
 	m_horiBlurLayeredShader.setInt("u_screenTex", 0);
@@ -947,35 +2187,60 @@ void App::setupShaders()
 
 	m_fogScatterAbsorbShader.use();
 	m_fogScatterAbsorbShader.setInt("u_pointShadowmapArray", 0);
-	m_fogScatterAbsorbShader.setInt("u_previousFrameFog", 1);
 	for (int i = 0; i < NUM_LIGHTS; ++i)
-		m_fogScatterAbsorbShader.setInt("u_LUT[" + std::to_string(i) + "]", 2 + i);
-	m_fogScatterAbsorbShader.setVec3("u_fogTexSize", c_fogTexSize);
+		m_fogScatterAbsorbShader.setInt(SceneUtils::getArrayUniformName("u_LUT", i), 2 + i);
+	for (int i = 0; i < c_numFroxelCascades; ++i)
+	{
+		m_fogScatterAbsorbShader.setInt(SceneUtils::getArrayUniformName("u_previousFrameFog", i), 6 + i);
+		m_fogScatterAbsorbShader.setInt(SceneUtils::getArrayUniformName("u_previousFrameAlpha", i), 6 + c_numFroxelCascades + i);
+		m_fogScatterAbsorbShader.setInt(SceneUtils::getArrayUniformName("u_densityVolume", i), 12 + i);
+	}
+	for (int i = 0; i < NUM_LIGHTS; ++i)
+		m_fogScatterAbsorbShader.setInt(SceneUtils::getArrayUniformName("u_visibilityVolume", i), 15 + i);
+
+	m_lightVisibilityShader.use();
+	m_lightVisibilityShader.setInt("u_pointShadowmapArray", 0);
+
+	m_fogClipmapUpdateShader.use();
+	m_fogClipmapUpdateShader.setInt("u_pointShadowmapArray", 0);
+
+	m_fogClipmapSampleShader.use();
+	for (int i = 0; i < FogClipmap::c_numCascades; ++i)
+		m_fogClipmapSampleShader.setInt(SceneUtils::getArrayUniformName("u_cascades", i), 1 + i);
 }
 
 void App::setupUBOs()
 {
-	m_matricesUBO = createUBO(5 * sizeof(glm::mat4), 0, 0);
+	m_matricesRing.init(sizeof(MatricesBlock), GPUResourceRegistry::MISC, "Matrices UBO ring");
+	m_lightMatricesRing.init(sizeof(LightMatricesBlock), GPUResourceRegistry::SHADOWS, "Light matrices UBO ring");
 	unsigned int uniformBlockIndex = glGetUniformBlockIndex(m_shader.m_ID, "Matrices");
 	glUniformBlockBinding(m_shader.m_ID, uniformBlockIndex, 0);
 
-	// Set projection matrix in UBO for rendering:
-	glBindBuffer(GL_UNIFORM_BUFFER, m_matricesUBO);
-	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(m_proj));
+	// No previous frame to reproject from yet:
+	m_prevViewProj = m_proj * m_camera.getViewMat();
 }
 
 void App::setupFBOs()
 {
-	m_fullscreenColourFBO = createFBO(m_windowDim, m_FBOColourBuffer);
-	m_fullscreenDepthFBO = createFBO(m_windowDim, m_FBODepthBuffer);
+	PROFILE_FUNCTION();
+
+	m_fullscreenColourFBO = createFBO(m_windowDim, m_FBOColourBuffer, m_fullscreenColourRBO, "Fullscreen colour FBO");
+	// Float, so surfaces past the last slice keep their depth for the analytic far field:
+	m_fullscreenDepthFBO = createFBO(m_windowDim, m_FBODepthBuffer, m_fullscreenDepthRBO, "Fullscreen depth FBO", GL_R32F);
+
+	m_pointShadowmapArrayFBO = createShadowmapArray(glm::uvec3(c_shadowmapDim.x, c_shadowmapDim.y, 6 * NUM_LIGHTS), m_pointShadowmapArrayColour, m_pointShadowmapArrayDepth, "Point shadowmap array");
+	m_horiBlurShadowmapArrayFBO = createShadowmapArray(glm::uvec3(c_shadowmapDim.x, c_shadowmapDim.y, 6 * NUM_LIGHTS), m_horiBlurShadowmapArrayColour, "Horizontal blur shadowmap array");
+	m_vertBlurShadowmapArrayFBO = createShadowmapArray(glm::uvec3(c_shadowmapDim.x, c_shadowmapDim.y, 6 * NUM_LIGHTS), m_vertBlurShadowmapArrayColour, "Vertical blur shadowmap array");
 
-	m_pointShadowmapArrayFBO = createShadowmapArray(glm::uvec3(c_shadowmapDim.x, c_shadowmapDim.y, 6 * NUM_LIGHTS), m_pointShadowmapArrayColour, m_pointShadowmapArrayDepth);
-	m_horiBlurShadowmapArrayFBO = createShadowmapArray(glm::uvec3(c_shadowmapDim.x, c_shadowmapDim.y, 6 * NUM_LIGHTS), m_horiBlurShadowmapArrayColour);
-	m_vertBlurShadowmapArrayFBO = createShadowmapArray(glm::uvec3(c_shadowmapDim.x, c_shadowmapDim.y, 6 * NUM_LIGHTS), m_vertBlurShadowmapArrayColour);
+	// Headless, there's no back buffer to composite into:
+	if (m_headless)
+		m_outputFBO = createFBO(m_windowDim, m_outputColour, m_outputRBO, "Headless output FBO");
 }
 
 void App::generateLUTs()
 {
+	PROFILE_FUNCTION();
+
 	generateHooblerLUT();
 	generateKovalovsLUT();
 	std::cout << "Generated LUTs!" << std::endl;
@@ -983,14 +2248,14 @@ void App::generateLUTs()
 
 void App::generateHooblerLUT()
 {
-	// Generate Hoobler's scattering LUT:
-	for (int i = 0; i < NUM_LIGHTS; ++i)
+	// Generate Hoobler's scattering LUT for each visible light, in its shader light slot:
+	for (int i = 0; i < m_numVisibleLights; ++i)
 	{
 		Renderer::pushDebugGroup(std::string("Hoobler LUT generation"));
 
 		m_hooblerAccumLUTShader.use();
 		m_hooblerAccumLUTShader.setVec3("u_camPos", m_camera.getPosition());
-		m_hooblerAccumLUTShader.setVec3("u_lightPos", m_light[i].getPosition());
+		m_hooblerAccumLUTShader.setVec3("u_lightPos", m_frame->lights.getPosition(m_visibleLights[i]));
 
 		const float vecLength = 15.0f;
 		const float lightZFar = 50.0f;
@@ -1000,9 +2265,9 @@ void App::generateHooblerLUT()
 		m_hooblerAccumLUTShader.setFloat("u_vecLength", vecLength);
 		m_hooblerAccumLUTShader.setFloat("u_lightZFar", lightZFar);
 
-		m_hooblerAccumLUTShader.setFloat("u_constant", m_light[0].getConstant());
-		m_hooblerAccumLUTShader.setFloat("u_linear", m_light[0].getLinear());
-		m_hooblerAccumLUTShader.setFloat("u_quadratic", m_light[0].getQuadratic());
+		m_hooblerAccumLUTShader.setFloat("u_constant", m_pointLightConstant);
+		m_hooblerAccumLUTShader.setFloat("u_linear", m_pointLightLinear);
+		m_hooblerAccumLUTShader.setFloat("u_quadratic", m_pointLightQuadratic);
 
 		glBindImageTexture(4, m_hooblerAccumLUT[i], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 		glDispatchCompute(4, 64, 1);
@@ -1024,9 +2289,9 @@ void App::generateKovalovsLUT()
 
 	m_kovalovsLUTShader.setFloat("u_gParam", m_fogPhaseGParam);
 
-	m_kovalovsLUTShader.setFloat("u_constant", m_light[0].getConstant());
-	m_kovalovsLUTShader.setFloat("u_linear", m_light[0].getLinear());
-	m_kovalovsLUTShader.setFloat("u_quadratic", m_light[0].getQuadratic());
+	m_kovalovsLUTShader.setFloat("u_constant", m_pointLightConstant);
+	m_kovalovsLUTShader.setFloat("u_linear", m_pointLightLinear);
+	m_kovalovsLUTShader.setFloat("u_quadratic", m_pointLightQuadratic);
 
 	glBindImageTexture(6, m_kovalovsLUT, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
 	glDispatchCompute(1, 1024, 1);
@@ -1034,6 +2299,8 @@ void App::generateKovalovsLUT()
 
 void App::setupModelsAndTextures()
 {
+	PROFILE_FUNCTION();
+
 	// Load models:
 	m_planet.loadModel("models/planet/planet.obj");
 	m_rock.loadModel("models/rock/rock.obj");
@@ -1102,6 +2369,7 @@ void App::setupModelsAndTextures()
 	glGenBuffers(1, &m_fullscreenQuadVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_fullscreenQuadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(fullscreenCoords), fullscreenCoords, GL_STATIC_DRAW);
+	GPUResourceRegistry::registerBuffer(m_fullscreenQuadVBO, GPUResourceRegistry::MESHES, "Fullscreen quad VBO", sizeof(fullscreenCoords));
 
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);					// aPos
 	glEnableVertexAttribArray(0);
@@ -1124,6 +2392,7 @@ void App::setupModelsAndTextures()
 	glGenBuffers(1, &m_planeVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_planeVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
+	GPUResourceRegistry::registerBuffer(m_planeVBO, GPUResourceRegistry::MESHES, "Plane VBO", sizeof(planeVertices));
 
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);					// aPos
 	glEnableVertexAttribArray(0);
@@ -1136,6 +2405,7 @@ void App::setupModelsAndTextures()
 	glGenBuffers(1, &m_lightCubeVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_lightCubeVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
+	GPUResourceRegistry::registerBuffer(m_lightCubeVBO, GPUResourceRegistry::MESHES, "Light cube VBO", sizeof(cubeVertices));
 
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);					// aPos
 	glEnableVertexAttribArray(0);
@@ -1144,21 +2414,69 @@ void App::setupModelsAndTextures()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));	// aTexCoords
 	glEnableVertexAttribArray(2);
 
-	m_testQuadVAO.setData(fullscreenCoords, sizeof(fullscreenCoords), VAO::Format::POS2_TEX2);
-
 	// Load/create textures:
-	m_rockTex = loadTexture("models/rock/rock.png");
-	m_oddFogScatterAbsorbTex = createTexture(c_fogTexSize, GL_RGBA32F);
-	m_evenFogScatterAbsorbTex = createTexture(c_fogTexSize, GL_RGBA32F);
-	m_fogAccumTex = createTexture(c_fogTexSize, GL_RGBA32F);
+	m_rockTex = loadTexture("models/rock/rock.png", GPUResourceRegistry::MESHES);
+	m_fogClipmap.init(c_fogClipmapCellSize);
+	m_lightVisibility.init();
 
 	// Create LUTs:
-	m_kovalovsLUT = createTexture(c_LUTDim, GL_R32F);
+	m_kovalovsLUT = createTexture(c_LUTDim, GL_R32F, GPUResourceRegistry::LUTS, "Kovalovs LUT");
+	for (int i = 0; i < NUM_LIGHTS; ++i)
+	{
+		m_hooblerAccumLUT[i] = createTexture(glm::uvec2(128, 512), GL_RGBA32F, GPUResourceRegistry::LUTS, "Hoobler accumulation LUT");
+		m_hooblerSumLUT[i] = createTexture(glm::uvec2(128, 512), GL_RGBA32F, GPUResourceRegistry::LUTS, "Hoobler sum LUT");
+	}
+}
+
+void App::releaseResources()
+{
+	// Models (mesh buffers and their textures):
+	m_planet.release();
+	m_rock.release();
+
+	// VAOs and buffers:
+	glDeleteVertexArrays(1, &m_fullscreenQuadVAO);
+	glDeleteVertexArrays(1, &m_planeVAO);
+	glDeleteVertexArrays(1, &m_lightCubeVAO);
+	GPUResourceRegistry::deleteBuffer(m_fullscreenQuadVBO);
+	GPUResourceRegistry::deleteBuffer(m_planeVBO);
+	GPUResourceRegistry::deleteBuffer(m_lightCubeVBO);
+	GPUResourceRegistry::deleteBuffer(m_asteroidMatricesVBO);
+	m_matricesRing.release();
+	m_lightMatricesRing.release();
+
+	// Textures:
+	GPUResourceRegistry::deleteTexture(m_rockTex);
+	releaseFroxelVolumes();
+	m_fogClipmap.release();
+	m_lightVisibility.release();
+	GPUResourceRegistry::deleteTexture(m_kovalovsLUT);
 	for (int i = 0; i < NUM_LIGHTS; ++i)
 	{
-		m_hooblerAccumLUT[i] = createTexture(glm::uvec2(128, 512), GL_RGBA32F);
-		m_hooblerSumLUT[i] = createTexture(glm::uvec2(128, 512), GL_RGBA32F);
+		GPUResourceRegistry::deleteTexture(m_hooblerAccumLUT[i]);
+		GPUResourceRegistry::deleteTexture(m_hooblerSumLUT[i]);
+	}
+
+	// FBOs and their attachments:
+	glDeleteFramebuffers(1, &m_fullscreenColourFBO);
+	glDeleteFramebuffers(1, &m_fullscreenDepthFBO);
+	glDeleteFramebuffers(1, &m_pointShadowmapArrayFBO);
+	glDeleteFramebuffers(1, &m_horiBlurShadowmapArrayFBO);
+	glDeleteFramebuffers(1, &m_vertBlurShadowmapArrayFBO);
+	GPUResourceRegistry::deleteTexture(m_FBOColourBuffer);
+	GPUResourceRegistry::deleteTexture(m_FBODepthBuffer);
+	GPUResourceRegistry::deleteRenderbuffer(m_fullscreenColourRBO);
+	GPUResourceRegistry::deleteRenderbuffer(m_fullscreenDepthRBO);
+	if (m_headless)
+	{
+		glDeleteFramebuffers(1, &m_outputFBO);
+		GPUResourceRegistry::deleteTexture(m_outputColour);
+		GPUResourceRegistry::deleteRenderbuffer(m_outputRBO);
 	}
+	GPUResourceRegistry::deleteTexture(m_pointShadowmapArrayColour);
+	GPUResourceRegistry::deleteTexture(m_pointShadowmapArrayDepth);
+	GPUResourceRegistry::deleteTexture(m_horiBlurShadowmapArrayColour);
+	GPUResourceRegistry::deleteTexture(m_vertBlurShadowmapArrayColour);
 }
 
 GLFWwindow* App::initWindow()
@@ -1188,6 +2506,58 @@ GLFWwindow* App::initWindow()
 	return newWindow;
 }
 
+bool App::initHeadless(GLuint glVersionMaj, GLuint glVersionMin)
+{
+	if (!m_headlessContext.init(glVersionMaj, glVersionMin))
+		return false;
+
+	glViewport(0, 0, m_windowDim.x, m_windowDim.y);
+	registerBenchmarkParameters();
+
+	// Camera tracks loop for as many frames as the batch asks for:
+	if (!m_headlessSettings.cameraTrackPath.empty())
+	{
+		if (!m_cameraTrack.load(m_headlessSettings.cameraTrackPath))
+			return false;
+		m_cameraTrack.startPlayback(true);
+	}
+
+	return true;
+}
+
+void App::writeHeadlessFrame()
+{
+	PROFILE_FUNCTION();
+
+	if (m_headlessSettings.outputPrefix.empty() || m_headlessFrame % m_headlessSettings.outputEvery != 0)
+		return;
+
+	std::ostringstream filePath;
+	filePath << m_headlessSettings.outputPrefix << "_" << std::setw(5) << std::setfill('0') << m_headlessFrame << ".ppm";
+	m_frameCapture.captureFramebuffer(m_outputFBO, GL_COLOR_ATTACHMENT0, m_windowDim, FrameCapture::PPM, filePath.str());
+}
+
+void App::captureFrame(const std::string& prefix)
+{
+	PROFILE_FUNCTION();
+
+	m_frameCapture.captureFramebuffer(m_outputFBO, m_outputFBO ? GL_COLOR_ATTACHMENT0 : GL_BACK, m_windowDim, FrameCapture::PPM, prefix + ".ppm");
+
+	// The surface colour before fog is composited, and one depth slice of the accumulated in-scattering and transmittance:
+	if (m_captureIntermediates)
+	{
+		redrawCompositeInputs();
+		m_frameCapture.captureFramebuffer(m_fullscreenColourFBO, GL_COLOR_ATTACHMENT0, m_windowDim, FrameCapture::PPM, prefix + "_colour.ppm");
+		// The slice is read from whichever cascade covers it, at that cascade's resolution:
+		int cascade = c_numFroxelCascades - 1;
+		while (cascade > 0 && (GLuint)m_captureFogSlice < m_froxelCascades[cascade].firstSlice)
+			--cascade;
+		m_frameCapture.captureTextureLayer(m_fogAccumTex[cascade], m_captureFogSlice - m_froxelCascades[cascade].firstSlice, glm::uvec2(m_froxelCascades[cascade].dim), FrameCapture::PFM,
+			prefix + "_fogSlice" + std::to_string(m_captureFogSlice) + ".pfm");
+	}
+}
+
+#ifdef NV_PERFKIT_ENABLE
 bool App::initPerfkit()
 {
 	// If dynamic library file couldn't be found, return false:
@@ -1235,8 +2605,9 @@ bool App::initPerfkit()
 
 	return true;
 }
+#endif
 
-GLuint App::loadTexture(const char* filepath, bool flipY)
+GLuint App::loadTexture(const char* filepath, GPUResourceRegistry::Tag tag, bool flipY)
 {
 	GLuint newTex{};
 	glGenTextures(1, &newTex);
@@ -1277,11 +2648,15 @@ GLuint App::loadTexture(const char* filepath, bool flipY)
 
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);	// Generate all required mipmaps for the currently bound texture.
+		GPUResourceRegistry::registerTexture(newTex, tag, filepath, format, glm::uvec3(width, height, 1), true);
 		std::cout << "Successfully loaded " << filepath << "! (" << nrChannels << " channels)" << std::endl;
 	}
-	// Otherwise, print error message:
+	// Otherwise, print error message (the empty texture is still tracked, since it's deleted like any other):
 	else
+	{
 		std::cout << "TEXTURE LOAD ERROR: " << filepath << std::endl;
+		GPUResourceRegistry::registerTexture(newTex, tag, std::string(filepath) + " (failed to load)", GL_RGBA, glm::uvec3(0));
+	}
 
 	// Release texture data:
 	stbi_image_free(data);
@@ -1293,7 +2668,7 @@ GLuint App::loadTexture(const char* filepath, bool flipY)
 	return newTex;
 }
 
-GLuint App::createTexture(GLuint width, GLuint height, GLenum format)
+GLuint App::createTexture(GLuint width, GLuint height, GLenum format, GPUResourceRegistry::Tag tag, const char* name)
 {
 	GLuint newTex;
 	glGenTextures(1, &newTex);
@@ -1303,14 +2678,15 @@ GLuint App::createTexture(GLuint width, GLuint height, GLenum format)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-	GLenum internalFormat = getTextureInternalFormat(format);
+	GLenum internalFormat = SceneUtils::getTextureInternalFormat(format);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, internalFormat, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(newTex, tag, name, format, glm::uvec3(width, height, 1));
 
 	return newTex;
 }
 
-GLuint App::createTexture(glm::uvec2 dim, GLenum format)
+GLuint App::createTexture(glm::uvec2 dim, GLenum format, GPUResourceRegistry::Tag tag, const char* name)
 {
 	GLuint newTex;
 	glGenTextures(1, &newTex);
@@ -1320,14 +2696,15 @@ GLuint App::createTexture(glm::uvec2 dim, GLenum format)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-	GLenum internalFormat = getTextureInternalFormat(format);
+	GLenum internalFormat = SceneUtils::getTextureInternalFormat(format);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, format, dim.x, dim.y, 0, internalFormat, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(newTex, tag, name, format, glm::uvec3(dim, 1));
 
 	return newTex;
 }
 
-GLuint App::createTexture(GLuint width, GLuint height, GLuint depth, GLenum format)
+GLuint App::createTexture(GLuint width, GLuint height, GLuint depth, GLenum format, GPUResourceRegistry::Tag tag, const char* name)
 {
 	GLuint newTex;
 	glGenTextures(1, &newTex);
@@ -1338,14 +2715,15 @@ GLuint App::createTexture(GLuint width, GLuint height, GLuint depth, GLenum form
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-	GLenum internalFormat = getTextureInternalFormat(format);
+	GLenum internalFormat = SceneUtils::getTextureInternalFormat(format);
 
 	glTexImage3D(GL_TEXTURE_3D, 0, format, width, height, depth, 0, internalFormat, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(newTex, tag, name, format, glm::uvec3(width, height, depth));
 
 	return newTex;
 }
 
-GLuint App::createTexture(glm::uvec3 dim, GLenum format)
+GLuint App::createTexture(glm::uvec3 dim, GLenum format, GPUResourceRegistry::Tag tag, const char* name)
 {
 	GLuint newTex;
 	glGenTextures(1, &newTex);
@@ -1356,45 +2734,15 @@ GLuint App::createTexture(glm::uvec3 dim, GLenum format)
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-	GLenum internalFormat = getTextureInternalFormat(format);
+	GLenum internalFormat = SceneUtils::getTextureInternalFormat(format);
 
 	glTexImage3D(GL_TEXTURE_3D, 0, format, dim.x, dim.y, dim.z, 0, internalFormat, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(newTex, tag, name, format, dim);
 
 	return newTex;
 }
 
-GLenum App::getTextureInternalFormat(GLenum format)
-{
-	GLenum internalFormat;
-
-	switch (format)
-	{
-	case GL_RED:
-	case GL_R16F:
-	case GL_R32F:
-		internalFormat = GL_RED;
-		break;
-	case GL_RG:
-	case GL_RG16F:
-	case GL_RG32F:
-		internalFormat = GL_RG;
-		break;
-	case GL_RGB:
-	case GL_RGB16F:
-	case GL_RGB32F:
-		internalFormat = GL_RGB;
-		break;
-	case GL_RGBA:
-	case GL_RGBA16F:
-	case GL_RGBA32F:
-	default:
-		internalFormat = GL_RGBA;
-		break;
-	}
-	return internalFormat;
-}
-
-GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer)
+GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthStencilRBO, const std::string& name, GLenum colourFormat)
 {
 	// Generate and bind new FBO:
 	GLuint newFBO;
@@ -1404,7 +2752,8 @@ GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer)
 	// Generate colour texture attachment:
 	glGenTextures(1, &colourTexBuffer);
 	glBindTexture(GL_TEXTURE_2D, colourTexBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, dim.x, dim.y, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	glTexImage2D(GL_TEXTURE_2D, 0, colourFormat, dim.x, dim.y, 0, SceneUtils::getTextureInternalFormat(colourFormat), GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(colourTexBuffer, GPUResourceRegistry::RENDER_TARGETS, name + " colour", colourFormat, glm::uvec3(dim, 1));
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glBindTexture(GL_TEXTURE_2D, 0);
@@ -1412,15 +2761,15 @@ GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer)
 	// Attach texture to FBO:
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colourTexBuffer, 0);
 
-	// Generate and bind RBO to new FBO:
-	GLuint RBO;
-	glGenRenderbuffers(1, &RBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, RBO);
+	// Generate and bind RBO to new FBO (returned so it can be deleted along with the FBO):
+	glGenRenderbuffers(1, &depthStencilRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthStencilRBO);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, dim.x, dim.y);
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	GPUResourceRegistry::registerRenderbuffer(depthStencilRBO, GPUResourceRegistry::RENDER_TARGETS, name + " depth/stencil", GL_DEPTH24_STENCIL8, dim);
 
 	// Bind RBO to new FBO, check for completeness:
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, RBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencilRBO);
 
 	GLErrorManager::checkFramebuffer();
 
@@ -1430,7 +2779,7 @@ GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer)
 	return newFBO;
 }
 
-GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthTexBuffer)
+GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthTexBuffer, GLuint& depthStencilRBO, const std::string& name)
 {
 	// Generate and bind new FBO:
 	GLuint newFBO;
@@ -1441,6 +2790,7 @@ GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthTexB
 	glGenTextures(1, &colourTexBuffer);
 	glBindTexture(GL_TEXTURE_2D, colourTexBuffer);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, dim.x, dim.y, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	GPUResourceRegistry::registerTexture(colourTexBuffer, GPUResourceRegistry::RENDER_TARGETS, name + " colour", GL_RGB, glm::uvec3(dim, 1));
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glBindTexture(GL_TEXTURE_2D, 0);
@@ -1452,6 +2802,7 @@ GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthTexB
 	glGenTextures(1, &depthTexBuffer);
 	glBindTexture(GL_TEXTURE_2D, depthTexBuffer);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, dim.x, dim.y, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+	GPUResourceRegistry::registerTexture(depthTexBuffer, GPUResourceRegistry::RENDER_TARGETS, name + " depth", GL_RED, glm::uvec3(dim, 1));
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glBindTexture(GL_TEXTURE_2D, 0);
@@ -1459,15 +2810,15 @@ GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthTexB
 	// Attach depth texture to FBO:
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexBuffer, 0);
 
-	// Generate and bind RBO to new FBO:
-	GLuint RBO;
-	glGenRenderbuffers(1, &RBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, RBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, dim.x, dim.x);
+	// Generate and bind RBO to new FBO (returned so it can be deleted along with the FBO):
+	glGenRenderbuffers(1, &depthStencilRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthStencilRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, dim.x, dim.y);
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	GPUResourceRegistry::registerRenderbuffer(depthStencilRBO, GPUResourceRegistry::RENDER_TARGETS, name + " depth/stencil", GL_DEPTH24_STENCIL8, dim);
 
 	// Bind RBO to new FBO, check for completeness:
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, RBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencilRBO);
 
 	GLErrorManager::checkFramebuffer();
 
@@ -1477,25 +2828,7 @@ GLuint App::createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthTexB
 	return newFBO;
 }
 
-GLuint App::createUBO(size_t size, GLuint index, GLuint offset)
-{
-	// Generate and bind UBO:
-	unsigned int newUBO;
-	glGenBuffers(1, &newUBO);
-	glBindBuffer(GL_UNIFORM_BUFFER, newUBO);
-
-	// Set size of UBO in VRAM (don't fill with data yet), set uniform binding point:
-	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_STATIC_DRAW);
-	glBindBufferRange(GL_UNIFORM_BUFFER, index, newUBO, offset, size);
-
-	// Reset buffer binding:
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
-	std::cout << "Successfully created new UBO! (" << size << " bytes)" << std::endl;
-
-	return newUBO;
-}
-
-GLuint App::createShadowmap(glm::uvec2 shadowmapDim, GLuint& colourTexBuffer, GLuint& depthTexBuffer)
+GLuint App::createShadowmap(glm::uvec2 shadowmapDim, GLuint& colourTexBuffer, GLuint& depthTexBuffer, const std::string& name)
 {
 	// Generate and bind FBO:
 	GLuint newFBO;
@@ -1506,6 +2839,7 @@ GLuint App::createShadowmap(glm::uvec2 shadowmapDim, GLuint& colourTexBuffer, GL
 	glGenTextures(1, &colourTexBuffer);
 	glBindTexture(GL_TEXTURE_2D, colourTexBuffer);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, shadowmapDim.x, shadowmapDim.y, 0, GL_RG, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(colourTexBuffer, GPUResourceRegistry::SHADOWS, name + " colour", GL_RG32F, glm::uvec3(shadowmapDim, 1));
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -1518,6 +2852,7 @@ GLuint App::createShadowmap(glm::uvec2 shadowmapDim, GLuint& colourTexBuffer, GL
 	glGenTextures(1, &depthTexBuffer);
 	glBindTexture(GL_TEXTURE_2D, depthTexBuffer);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, shadowmapDim.x, shadowmapDim.y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(depthTexBuffer, GPUResourceRegistry::SHADOWS, name + " depth", GL_DEPTH_COMPONENT, glm::uvec3(shadowmapDim, 1));
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -1530,7 +2865,7 @@ GLuint App::createShadowmap(glm::uvec2 shadowmapDim, GLuint& colourTexBuffer, GL
 	return newFBO;
 }
 
-GLuint App::createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffer)
+GLuint App::createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffer, const std::string& name)
 {
 	// Generate and bind FBO:
 	GLuint newFBO;
@@ -1541,6 +2876,7 @@ GLuint App::createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffe
 	glGenTextures(1, &colourTexBuffer);
 	glBindTexture(GL_TEXTURE_2D_ARRAY, colourTexBuffer);
 	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RG32F, shadowmapDim.x, shadowmapDim.y, shadowmapDim.z, 0, GL_RG, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(colourTexBuffer, GPUResourceRegistry::SHADOWS, name + " colour", GL_RG32F, shadowmapDim);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -1554,7 +2890,7 @@ GLuint App::createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffe
 	return newFBO;
 }
 
-GLuint App::createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffer, GLuint& depthTexBuffer)
+GLuint App::createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffer, GLuint& depthTexBuffer, const std::string& name)
 {
 	// Generate and bind FBO:
 	GLuint newFBO;
@@ -1565,6 +2901,7 @@ GLuint App::createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffe
 	glGenTextures(1, &colourTexBuffer);
 	glBindTexture(GL_TEXTURE_2D_ARRAY, colourTexBuffer);
 	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RG32F, shadowmapDim.x, shadowmapDim.y, shadowmapDim.z, 0, GL_RG, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(colourTexBuffer, GPUResourceRegistry::SHADOWS, name + " colour", GL_RG32F, shadowmapDim);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -1574,6 +2911,7 @@ GLuint App::createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffe
 	glGenTextures(1, &depthTexBuffer);
 	glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexBuffer);
 	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, shadowmapDim.x, shadowmapDim.y, shadowmapDim.z, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(depthTexBuffer, GPUResourceRegistry::SHADOWS, name + " depth", GL_DEPTH_COMPONENT, shadowmapDim);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -17,8 +17,30 @@
 #include "Shader.h"
 #include "Model.h"
 #include "PointLight.h"
-
+#include "CPUProfiler.h"
+#include "GPUTimer.h"
+#include "FroxelBudget.h"
+#include "FramePacer.h"
+#include "RingBuffer.h"
+#include "Benchmark.h"
+#include "CameraTrack.h"
+#include "SceneUtils.h"
+#include "GPUResourceRegistry.h"
+#include "ReferenceRenderer.h"
+#include "ImageMetrics.h"
+#include "Simulation.h"
+#include "JobSystem.h"
+#include "HeadlessContext.h"
+#include "FrameCapture.h"
+#include "FogClipmap.h"
+#include "FroxelBricks.h"
+#include "LightVisibilityVolumes.h"
+
+// Nvidia Perfkit and the Nsight Perf SDK are only set up for Windows, so other platforms build without either:
+#ifdef _WIN32
+#define NV_PERFKIT_ENABLE
 #define NV_PERF_ENABLE_INSTRUMENTATION
+#endif
 
 class App
 {
@@ -30,6 +52,20 @@ public:
 	bool init(GLuint glfwVersionMaj, GLuint glfwVersionMin);	// Initialises GLFW and GLAD, outputs OpenGL and GPU driver version to console.
 	void run();													// Begins application loop.
 
+	// Loads a benchmark scenario file to run unattended (no GUI or input) as soon as the application loop starts:
+	bool loadUnattendedBenchmark(const std::string& filePath, const std::string& outputDir);
+
+	// Offscreen batch rendering, with no window, GUI, input or vendor profilers, for hosts without a display or GPU:
+	struct HeadlessSettings
+	{
+		int			frames = 300;				// Frames to render, unless an unattended benchmark ends the batch first.
+		float		timestep = 1.0f / 60.0f;	// Fixed, so image sequences are repeatable.
+		std::string	outputPrefix;				// Frames are written to <prefix>_<frame>.ppm, or not at all if empty.
+		int			outputEvery = 1;			// Only write every nth frame.
+		std::string	cameraTrackPath;			// Camera track to play (looping), if any.
+	};
+	void setHeadless(const HeadlessSettings& settings);			// Call before init().
+
 	// Callback function data pointers:
 	GLFWwindow* getWindowPtr() { return m_window; }
 	Camera* getCameraPtr() { return &m_camera; }
@@ -40,10 +76,22 @@ public:
 private:
 	void processInput(GLFWwindow* window, float dt);
 	void update(float dt);
+	Simulation::Input makeSimulationInput();
 	void render();
 	void gui();
 
 	void runFogScatterAbsorb();	// Turned into a function purely to make Perfkit Code cleaner.
+	void registerBenchmarkParameters();
+	bool startBenchmark(const std::string& filePath);
+	void updateCameraTrack();
+	CameraTrack::Sample makeCameraTrackSample();
+	void applyCameraTrackSample(const CameraTrack::Sample& sample);
+	void buildReferenceScene();
+	bool renderReference(const std::string& outputPrefix);	// Writes <prefix>_inscattering.pfm, <prefix>_transmittance.pfm and <prefix>.pfm (composited).
+	ReferenceRenderer::Image renderReferenceFog(const ReferenceRenderer::Settings& settings);	// Current camera, lights and fog.
+	std::vector<glm::vec3> readSurfaceColour();				// Linear colour pass output, before fog and gamma.
+	void redrawCompositeInputs();							// Forward fog skips the depth and colour passes, which tools comparing against the composite need.
+	void scoreBenchmarkQuality();							// Compares the composited frame with a (cached) reference.
 
 	void setupMatrices();
 	void setupShaders();
@@ -53,24 +101,46 @@ private:
 	void generateLUTs();
 	void generateHooblerLUT();
 	void generateKovalovsLUT();
+	void dispatchFroxelCascades(const Shader& shader, const GLuint* outputTextures, GLenum outputFormat, const GLuint* outputAlphaTextures = nullptr);	// Runs a per-froxel shader over every cascade.
+	void injectFogDensity();		// Recomputes the cached density volumes, if the medium or the view changed since.
+	void accumulateFroxelCascades();
+	void refineFroxelBricks();		// Allocates, fills and accumulates this frame's refined bricks.
+	void bindScatterLightingTextures();
+	bool useFroxelBricks() const	{ return m_useFroxelBricks && !m_linearOrExpFroxels; }	// They're laid out over exponential slices.
+	float getFroxelFarPlane() const	{ return m_useAnalyticFarFog ? glm::clamp(m_froxelFarPlane, 2.0f * m_nearPlane, m_farPlane) : m_farPlane; }	// Where the slices end.
+	float getSkyFroxelDepth() const	{ return glm::log(m_farPlane / m_nearPlane) / glm::log(getFroxelFarPlane() / m_nearPlane); }	// The far plane's slice coordinate.
+	bool useForwardFog() const		{ return m_useForwardFog && m_applyFog && !m_outputDepth; }	// The depth output needs the depth pass.
+	void renderDepthPass();
+	void renderColourPass(bool forwardFog);	// Into the colour pass FBO, or with forward fog, straight into the output.
+	void updateFroxelGrid();		// Runs the budget, and reallocates the froxel volumes if the grid changed.
+	void allocateFroxelVolumes(glm::uvec3 gridSize);
+	void releaseFroxelVolumes();
+	void measureFroxelFormatError();	// Reruns this frame's fog in each volume format, comparing with FP32.
+	static const char* getFroxelFormatName(int format);
 
 	GLFWwindow* initWindow();
+	bool		initHeadless(GLuint glVersionMaj, GLuint glVersionMin);
+	void		writeHeadlessFrame();	// Captures the composited frame into the image sequence.
+	void		captureFrame(const std::string& prefix);	// Captures the composited frame (and intermediates, if enabled).
+#ifdef NV_PERFKIT_ENABLE
 	bool		initPerfkit();
-	GLuint		loadTexture(const char* filepath, bool flipY = false);
-	GLuint		createTexture(GLuint width, GLuint height, GLenum format);
-	GLuint		createTexture(glm::uvec2 dim, GLenum format);
-	GLuint		createTexture(GLuint width, GLuint height, GLuint depth, GLenum format);
-	GLuint		createTexture(glm::uvec3 dim, GLenum format);
-	GLenum		getTextureInternalFormat(GLenum format);
-	GLuint		createFBO(glm::uvec2 dim, GLuint& colourTexBuffer);
-	GLuint		createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthTexBuffer);
-	GLuint		createUBO(size_t size, GLuint index, GLuint offset);
-	GLuint		createShadowmap(glm::uvec2 shadowmapDim, GLuint& colourTexBuffer, GLuint& depthTexBuffer);
-	GLuint		createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffer);
-	GLuint		createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffer, GLuint& depthTexBuffer);
+#endif
+	void		releaseResources();	// Deletes every OpenGL object the App owns, so anything left in the GPUResourceRegistry has leaked.
+
+	// Resource creation (every allocation is recorded in the GPUResourceRegistry under the given tag/name):
+	GLuint		loadTexture(const char* filepath, GPUResourceRegistry::Tag tag, bool flipY = false);
+	GLuint		createTexture(GLuint width, GLuint height, GLenum format, GPUResourceRegistry::Tag tag, const char* name);
+	GLuint		createTexture(glm::uvec2 dim, GLenum format, GPUResourceRegistry::Tag tag, const char* name);
+	GLuint		createTexture(GLuint width, GLuint height, GLuint depth, GLenum format, GPUResourceRegistry::Tag tag, const char* name);
+	GLuint		createTexture(glm::uvec3 dim, GLenum format, GPUResourceRegistry::Tag tag, const char* name);
+	GLuint		createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthStencilRBO, const std::string& name, GLenum colourFormat = GL_RGB);
+	GLuint		createFBO(glm::uvec2 dim, GLuint& colourTexBuffer, GLuint& depthTexBuffer, GLuint& depthStencilRBO, const std::string& name);
+	GLuint		createShadowmap(glm::uvec2 shadowmapDim, GLuint& colourTexBuffer, GLuint& depthTexBuffer, const std::string& name);
+	GLuint		createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffer, const std::string& name);
+	GLuint		createShadowmapArray(glm::uvec3 shadowmapDim, GLuint& colourTexBuffer, GLuint& depthTexBuffer, const std::string& name);
 
 	// Required scene data:
-	GLFWwindow* m_window;
+	GLFWwindow* m_window = nullptr;
 	Camera		m_camera;
 
 	// Shaders:											/* GEOMETRY RENDERING: */
@@ -83,8 +153,14 @@ private:
 
 														/* FOG CALCULATION/COMPOSITION: */
 	Shader m_fogScatterAbsorbShader;					// Fog scattering and absorption evaluation shader (CS).
+	Shader m_fogDensityShader;							// Injects unlit scattering and absorption into the cached density volumes (CS).
 	Shader m_fogAccumShader;							// Fog accumulation shader using results of above S&A shader (CS).
 	Shader m_fogCompositeShader;						// Fullscreen rendering, combining fog and opaque geometry rendering results (VS/FS).
+	Shader m_fogClipmapUpdateShader;					// Evaluates scattering and extinction for world-space clipmap cells (CS).
+	Shader m_fogClipmapSampleShader;					// Resamples the clipmap into the froxel volume, in place of the S&A shader (CS).
+	Shader m_froxelBrickClassifyShader;					// Frees and allocates refined froxel bricks (CS).
+	Shader m_froxelBrickAccumShader;					// Accumulates the refined bricks, starting from the cascades (CS).
+	Shader m_lightVisibilityShader;						// Bakes a light's shadowmap visibility into its visibility volume (CS).
 
 														/* SHADOWMAPPING AND BLURRING: */
 	Shader m_varianceShadowmapLayeredShader;			// Draws variance depth data (depth and depth * depth) to shadow map texture array (VS/GS/FS).
@@ -99,7 +175,7 @@ private:
 
 	// Misc shader data (uniforms and dispatch group sizes):
 	// Fog data:
-	const glm::uvec3	c_fogNumWorkGroups = glm::uvec3(10, 10, 64);	// Local work group size is (160, 9, 1) for a 160x90x64 texture
+	const glm::uvec2	c_fogLocalSize = glm::uvec2(16, 9);				// Local work group size of the froxel shaders (cascades needn't be multiples of it).
 	float				m_fogScattering = 1.0f;
 	float				m_fogAbsorption = 0.0f;
 	glm::vec3			m_fogAlbedo = glm::vec3(1.0f);
@@ -110,6 +186,56 @@ private:
 	bool				m_useTemporal = false;
 	bool				m_useJitter = true;
 	bool				m_useScreenspaceJitter = false;
+	bool				m_useHeightFog = false;
+	glm::vec2			m_fogHeightRange = glm::vec2(0.0f, 10.0f);	// Base height, and the height the fog thins by a factor of e over above it.
+
+	// Fog applied by the surface shaders, in place of the depth pass and the composite over the colour pass:
+	bool				m_useForwardFog = false;
+	static const GLuint	c_forwardFogFirstUnit = 8;		// Accumulated volumes, then bricks, past the meshes' own textures.
+
+	// Cubic B-spline reconstruction of the accumulated volumes in the composite, weighted against the scene's depth:
+	bool				m_useTricubicFog = false;
+	float				m_fogUpsampleDepthSharpness = 0.5f;	// Per slice of depth difference, 0 for none.
+
+	// Analytic fog past the froxels, which then end at m_froxelFarPlane rather than the camera's far plane:
+	bool				m_useAnalyticFarFog = false;
+	float				m_froxelFarPlane = 50.0f;
+
+	// World-space fog clipmap, an alternative to evaluating the froxels directly:
+	FogClipmap			m_fogClipmap;
+	bool				m_useFogClipmap = false;
+	const float			c_fogClipmapCellSize = 0.75f;	// Of the finest cascade, in metres.
+
+	// Refined froxel bricks around lights and density gradients, over the cascades:
+	FroxelBricks		m_froxelBricks;
+	bool				m_useFroxelBricks = false;
+	float				m_brickDensityThreshold = 0.2f;		// Noise density range across a cell that gets a brick.
+
+	// Per-light visibility volumes, sampled by the S&A shader in place of the shadowmaps:
+	LightVisibilityVolumes	m_lightVisibility;
+	bool					m_useLightVisibilityVolumes = false;
+
+	// Density volumes, cached across frames and lit by the S&A shader, while nothing they depend on changes:
+	struct FogDensityKey
+	{
+		glm::mat4	viewProj = glm::mat4(0.0f);
+		glm::vec3	noiseOffset = glm::vec3(0.0f);
+		float		noiseFreq = 0.0f;
+		float		fogDensity = 0.0f;
+		float		scattering = 0.0f;
+		float		absorption = 0.0f;
+		bool		useHeterogeneousFog = false;
+		bool		linearOrExpFroxels = false;
+		bool		useHeightFog = false;
+		glm::vec2	fogHeightRange = glm::vec2(0.0f);
+		float		froxelFarPlane = 0.0f;
+
+		bool operator==(const FogDensityKey& other) const;
+	};
+	bool				m_cacheFogDensity = false;
+	bool				m_fogDensityValid = false;		// Whether the volumes hold anything (not straight after reallocation).
+	FogDensityKey		m_fogDensityKey;
+	int					m_fogDensityInjections = 0;		// Since startup, to show how often the cache misses.
 
 	// Noise data:
 	float				m_noiseFreq = 0.15f;
@@ -121,23 +247,11 @@ private:
 	const glm::uvec2	c_LUTDim = glm::uvec2(1024);
 	glm::vec2			m_lightViewPlanes = glm::vec2(0.1f, 100.0f);
 
-	// Lights:
-#define NUM_LIGHTS 4
-	PointLight m_light[NUM_LIGHTS];
-
-	// Light data:
-	glm::vec3 m_pointLightPosition[NUM_LIGHTS] = { glm::vec3(0.0f,   3.0f,  10.0f),
-													glm::vec3(0.0f,   3.0f,  50.0f),
-													glm::vec3(50.0f,  1.0f,  10.0f),
-													glm::vec3(-5.0f,   0.0f, -50.0f) };
-	glm::vec3 m_pointLightDiffuse[NUM_LIGHTS] = { glm::vec3(1.0f),
-													glm::vec3(1.0f),
-													glm::vec3(1.0f),
-													glm::vec3(1.0f) };
-	float m_pointLightRadius[NUM_LIGHTS] = { 20.0f,
-													20.0f,
-													20.0f,
-													20.0f };
+	// Light settings (NUM_LIGHTS is defined in LightManager.h), fed to the simulation's light manager:
+	LightManager::Light m_lightSettings[NUM_LIGHTS] = { { glm::vec3(0.0f,   3.0f,  10.0f), glm::vec3(1.0f), 20.0f },
+														{ glm::vec3(0.0f,   3.0f,  50.0f), glm::vec3(1.0f), 20.0f },
+														{ glm::vec3(50.0f,  1.0f,  10.0f), glm::vec3(1.0f), 20.0f },
+														{ glm::vec3(-5.0f,  0.0f, -50.0f), glm::vec3(1.0f), 20.0f } };
 	float m_pointLightConstant = 1.0f;
 	float m_pointLightLinear = 0.09f;
 	float m_pointLightQuadratic = 0.032f;
@@ -145,7 +259,11 @@ private:
 
 	GLuint m_currentLight = 0;
 	GLuint m_numActiveLights = 1;
-	glm::mat4 m_lightSpaceMat[6 * NUM_LIGHTS];
+
+	// Lights whose radius reaches the camera frustum this frame, packed into shader light slots in this order:
+	bool m_cullLights = true;
+	int  m_visibleLights[NUM_LIGHTS];
+	int  m_numVisibleLights = 0;
 
 	// VAOs, VBOs and EBOs:
 	GLuint m_fullscreenQuadVAO;
@@ -156,16 +274,33 @@ private:
 	GLuint m_lightCubeVAO;
 	GLuint m_lightCubeVBO;
 
-	VAO m_testQuadVAO;
+	// Per-frame uniform blocks (std140, matching the shaders), written to ring buffers paced by m_framePacer:
+	struct MatricesBlock
+	{
+		glm::mat4 proj;
+		glm::mat4 view;
+		glm::mat4 invViewProj;
+		glm::mat4 prevViewProj;
+		glm::mat4 currentViewProj;
+	};
+
+	struct LightMatricesBlock
+	{
+		glm::mat4 lightMatrices[6 * NUM_LIGHTS];
+	};
 
-	// UBOs:
-	GLuint m_matricesUBO;
+	FramePacer	m_framePacer;
+	RingBuffer	m_matricesRing;			// Binding 0.
+	RingBuffer	m_lightMatricesRing;	// Binding 1.
+	glm::mat4	m_prevViewProj;			// Last frame's view * proj, for temporal reprojection.
 
 	// FBOs and colour/depth buffers:
 	GLuint	m_fullscreenColourFBO;			// Fullscreen quad
 	GLuint	m_fullscreenDepthFBO;
 	GLuint	m_FBOColourBuffer;
 	GLuint	m_FBODepthBuffer;
+	GLuint	m_fullscreenColourRBO;
+	GLuint	m_fullscreenDepthRBO;
 	GLuint	m_pointShadowmapArrayFBO;		// Point light shadowmap texture array
 	GLuint	m_pointShadowmapArrayColour;
 	GLuint	m_pointShadowmapArrayDepth;
@@ -177,7 +312,9 @@ private:
 
 	// Render groups debug text:
 	std::string m_fogScatterAbsorbText = std::string("Fog scattering and absorption evaluation");
+	std::string m_fogDensityText = std::string("Fog density injection");
 	std::string m_fogAccumText = std::string("Fog accumulation");
+	std::string m_froxelBrickText = std::string("Froxel brick refinement");
 	std::string m_depthPassText = std::string("Depth pass");
 	std::string m_colourPassText = std::string("Colour pass");
 	std::string m_shadowmapPassText = std::string("Shadowmapping pass");
@@ -191,14 +328,72 @@ private:
 	std::string m_uiRenderText = std::string("ImGui");
 	std::string m_uniformUpdateText = std::string("Shader uniforms update");
 
+	// Froxel cascades, near to far, each covering a range of the exponentially distributed slices at a lower XY resolution
+	// than the one in front of it, as far froxels cover much more of the world than near ones:
+	static const int c_numFroxelCascades = 3;
+	struct FroxelCascade
+	{
+		glm::uvec3	dim;			// XY resolution, and slices covered.
+		GLuint		firstSlice;
+	};
+	FroxelCascade m_froxelCascades[c_numFroxelCascades];
+
+	// How each cascade's XY resolution compares to the grid's, and its share of the slices (the far cascade takes the rest):
+	const float c_froxelCascadeXYScale[c_numFroxelCascades] = { 1.0f, 0.5f, 0.2f };
+	const float c_froxelCascadeSliceShare[c_numFroxelCascades] = { 0.5f, 0.25f, 0.25f };
+
+	// Froxel grid, reallocated whenever its size changes: the near cascade's XY resolution (before the budget's
+	// scale) and the slices across all cascades:
+	glm::ivec3	 m_froxelGrid = glm::ivec3(160, 90, 64);
+	glm::uvec3	 m_fogTexSize = glm::uvec3(0);	// The grid as allocated, after scaling.
+	bool		 m_froxelHistoryValid = false;	// Whether last frame's volumes can be reprojected (not if just reallocated).
+	float		 m_historyFroxelFarPlane = 0.0f;	// Where the slices ended when last frame's volumes were computed.
+
+	// Storage formats, chosen separately for the scattering volumes (this frame's and last frame's) and the accumulated
+	// volumes. The packed format keeps RGB in R11G11B10F (unsigned, which both volumes' RGB are) and alpha in R16F:
+	enum FroxelVolumeFormat
+	{
+		FROXEL_RGBA32F = 0,
+		FROXEL_RGBA16F = 1,
+		FROXEL_R11G11B10F_R16F = 2
+	};
+	static GLenum getFroxelInternalFormat(FroxelVolumeFormat format);	// Of the RGB(A) volume.
+	FroxelVolumeFormat m_scatterVolumeFormat = FROXEL_RGBA32F;
+	FroxelVolumeFormat m_accumVolumeFormat = FROXEL_RGBA32F;
+	FroxelVolumeFormat m_allocatedScatterFormat = FROXEL_RGBA32F;
+	FroxelVolumeFormat m_allocatedAccumFormat = FROXEL_RGBA32F;
+
+	// Error of each format pairing against FP32 throughout, from the last measureFroxelFormatError():
+	struct FroxelFormatError
+	{
+		FroxelVolumeFormat	  scatterFormat;
+		FroxelVolumeFormat	  accumFormat;
+		uint64_t			  bytes;					// The cascades' scattering, accumulation and density volumes.
+		float				  maxInScatteringError;		// Largest absolute error in the accumulated volumes.
+		float				  maxTransmittanceError;
+		ImageMetrics::Scores  composite;				// Composited frame against the FP32 one.
+	};
+	std::vector<FroxelFormatError> m_froxelFormatErrors;
+	bool						   m_froxelFormatErrorRequested = false;
+	bool		 m_useFroxelBudget = false;
+	float		 m_froxelBudgetMs = 2.0f;		// Fog scatter/absorb and accumulation passes' GPU time.
+	float		 m_froxelGridScale = 1.0f;		// XY scale the budget settled on.
+	FroxelBudget m_froxelBudget;
+
 	// Models and textures:
 	Model  m_planet;
 	Model  m_rock;
 	GLuint m_rockTex;
-	GLuint m_evenFogScatterAbsorbTex;
-	GLuint m_oddFogScatterAbsorbTex;
+	GLuint m_evenFogScatterAbsorbTex[c_numFroxelCascades];
+	GLuint m_oddFogScatterAbsorbTex[c_numFroxelCascades];
+
+	GLuint m_fogAccumTex[c_numFroxelCascades];
+	GLuint m_fogDensityTex[c_numFroxelCascades] = {};	// RG16F scattering and absorption coefficients, unlit.
 
-	GLuint m_fogAccumTex;
+	// Alpha of each of the above, when their format keeps it separately (0 otherwise):
+	GLuint m_evenFogScatterAlphaTex[c_numFroxelCascades] = {};
+	GLuint m_oddFogScatterAlphaTex[c_numFroxelCascades] = {};
+	GLuint m_fogAccumAlphaTex[c_numFroxelCascades] = {};
 
 	GLuint m_kovalovsLUT;					// LUT created with Kovalovs' method.
 	GLuint m_hooblerAccumLUT[NUM_LIGHTS];	// LUT created with Hoobler's method (accumulation stage).
@@ -206,8 +401,8 @@ private:
 
 	// Misc model/texture data:
 	glm::vec3		 m_planetPosition;
+	std::vector<glm::mat4> m_asteroidMatrices;
 	const GLuint	 c_asteroidsCount = 10000;
-	const glm::uvec3 c_fogTexSize = glm::uvec3(160, 90, 64);
 
 	// Matrices:
 	glm::mat4 m_proj;
@@ -216,16 +411,53 @@ private:
 
 	// Nvidia Perfkit/NSight Perf SDK data:
 	uint64_t		m_perfkitContext;
-	GLuint			m_numTestIterations = 100;
-	GLuint			m_currentIteration = m_numTestIterations;	// Set to m_numTestIterations so that it will wrap around to 0 on the first Perf SDK collection.
-	const char* m_filePaths[6] = {
-		"NSightPerfSDKReports\\NoLUT_StandardShadow\\",
-		"NSightPerfSDKReports\\HooblerLUT_StandardShadow\\",
-		"NSightPerfSDKReports\\KovalovsLUT_StandardShadow\\",
-		"NSightPerfSDKReports\\NoLUT_VSM\\",
-		"NSightPerfSDKReports\\NoLUT_ESM\\",
-		"NSightPerfSDKReports\\NoLUT_LinDist\\"
-	};
+
+	// Benchmarking and GPU pass timing:
+	Benchmark	m_benchmark;
+	GPUTimer	m_gpuTimer;
+	bool		m_unattended = false;										// Run without GUI or input, closing once the benchmark ends.
+	char		m_benchmarkFilePath[256] = "benchmarks/techniqueComparison.bench";
+
+	// Headless batch rendering:
+	bool				m_headless = false;		// No window, just m_headlessContext.
+	HeadlessSettings	m_headlessSettings;
+	HeadlessContext		m_headlessContext;
+	int					m_headlessFrame = 0;
+	double				m_headlessFrameMsTotal = 0.0;
+	GLuint				m_outputFBO = 0;		// The composited frame's target: the back buffer, or an FBO when headless.
+	GLuint				m_outputColour = 0;
+	GLuint				m_outputRBO = 0;
+
+	// Asynchronous frame capture:
+	FrameCapture		m_frameCapture;
+	char				m_capturePrefix[256] = "capture";
+	bool				m_captureRequested = false;
+	bool				m_captureContinuous = false;
+	bool				m_captureIntermediates = false;	// Also the unfogged colour buffer and a fog accumulation slice.
+	int					m_captureFogSlice = 0;
+	int					m_captureIndex = 0;
+
+	// CPU reference renderer:
+	ReferenceRenderer			m_referenceRenderer;
+	ReferenceRenderer::Settings m_referenceSettings;
+	bool						m_referenceSceneBuilt = false;
+	char						m_referenceOutputPrefix[256] = "reference";
+	std::map<std::string, ReferenceRenderer::Image> m_qualityReferences;	// Reference fog keyed by the camera, fog and light state it was rendered with.
+
+	// GPU memory accounting:
+	bool		m_resourcesCreated = false;	// Set once startup has created all OpenGL resources.
+
+	// Camera flythrough recording and playback:
+	CameraTrack m_cameraTrack;
+	char		m_cameraTrackFilePath[256] = "flythrough.track";
+	bool		m_loopCameraTrack = false;
+
+	// Simulation, stepped on its own thread unless frames must be repeatable:
+	Simulation			m_simulation;
+	const FrameState*	m_frame = nullptr;				// Snapshot the current frame renders, from the simulation.
+	bool				m_threadedSimulation = true;
+	glm::vec3			m_simulatedNoiseOffset{};		// Noise offset from the last snapshot, to spot edits to m_noiseOffset.
+	uint32_t			m_noiseOffsetVersion = 0;
 
 	// Misc application data:
 	float	m_dt{};
@@ -249,7 +481,6 @@ private:
 	bool	m_useLUT = false;
 	bool	m_hooblerOrKovalovs = false;	// 'false' = Hoobler, 'true' = Kovalovs.
 	bool	m_linearOrExpFroxels = false;	// 'false' = use exponential depth distribution, 'true' = use linear distribution.
-	bool	m_currentlyTesting = false;
 
 	enum ShadowMapTechnique
 	{
@@ -258,26 +489,26 @@ private:
 		ESM = 2
 	} m_shadowMapTechnique;
 
+	// Which froxels are recomputed together when scattering is amortised over several frames:
+	enum FroxelAmortisationPattern
+	{
+		INTERLEAVED_SLICES = 0,
+		CHECKERBOARD = 1
+	} m_froxelAmortisationPattern = INTERLEAVED_SLICES;
+	int		m_froxelAmortisation = 1;	// 1 in this many froxels are recomputed each frame, the rest reprojected from the last.
+	static const int c_maxFroxelAmortisation = 8;
+
+	// The frame index wraps at a multiple of every amortisation, 1 to c_maxFroxelAmortisation, so each group of froxels
+	// keeps its turn and its own jitter sequence across the wrap:
+	static const int c_frameIndexPeriod = 840;	// Least common multiple of 1 to 8.
+
+	// Many-light sampling: each froxel is lit by this many lights a frame, picked by importance (0 lights it with all of them):
+	static const int c_maxLightSamples = 4;	// MAX_LIGHT_SAMPLES in fogScatterAbsorbShader.comp.
+	int		m_lightSamplesPerFroxel = 0;
+
 	enum ProfilerUsed
 	{
 		PERFKIT = 0,
 		PERF_SDK = 1
 	} m_profilerUsed = PERF_SDK;
-
-	enum TestingSetup
-	{
-		START_VAL = -1,
-
-		// LUT variables:
-		NO_LUT_STANDARD_SHADOW = 0,			// Also accounts for NO_LUT_EXP_DIST
-		HOOBLER_LUT_STANDARD_SHADOW = 1,
-		KOVALOVS_LUT_STANDARD_SHADOW = 2,
-
-		// Shadow mapping variables:
-		NO_LUT_VSM = 3,
-		NO_LUT_ESM = 4,
-
-		// Froxel distribution variables:
-		NO_LUT_LIN_DIST = 5
-	} m_testingSetup;
 };
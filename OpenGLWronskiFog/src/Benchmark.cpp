@@ -0,0 +1,767 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+static std::string trim(const std::string& str)
+{
+	const size_t start = str.find_first_not_of(" \t\r\n");
+	if (start == std::string::npos)
+		return std::string();
+
+	const size_t end = str.find_last_not_of(" \t\r\n");
+	return str.substr(start, end - start + 1);
+}
+
+// Escapes quotes and backslashes (Windows paths) for a JSON string:
+static std::string escapeJSON(const std::string& str)
+{
+	std::string escaped;
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+		escaped += c;
+	}
+	return escaped;
+}
+
+static std::vector<std::string> splitWhitespace(const std::string& str)
+{
+	std::vector<std::string> tokens;
+	std::istringstream stream(str);
+	std::string token;
+
+	while (stream >> token)
+		tokens.push_back(token);
+	return tokens;
+}
+
+bool Benchmark::parseValue(const Parameter& parameter, const std::string& text, void* out) const
+{
+	std::istringstream stream(text);
+
+	switch (parameter.type)
+	{
+	case Parameter::FLOAT:
+		stream >> *(float*)out;
+		break;
+	case Parameter::INT:
+		stream >> *(int*)out;
+		break;
+	case Parameter::BOOL:
+	{
+		const std::string value = trim(text);
+		if (value == "true" || value == "1")
+			*(bool*)out = true;
+		else if (value == "false" || value == "0")
+			*(bool*)out = false;
+		else
+			return false;
+		return true;
+	}
+	case Parameter::VEC3:
+	{
+		glm::vec3& vec = *(glm::vec3*)out;
+		stream >> vec.x >> vec.y >> vec.z;
+		break;
+	}
+	}
+	return !stream.fail();
+}
+
+std::string Benchmark::formatValue(const Parameter& parameter) const
+{
+	std::ostringstream stream;
+	stream << std::setprecision(9);
+
+	switch (parameter.type)
+	{
+	case Parameter::FLOAT:
+		stream << *(float*)parameter.value;
+		break;
+	case Parameter::INT:
+		stream << *(int*)parameter.value;
+		break;
+	case Parameter::BOOL:
+		stream << (*(bool*)parameter.value ? "true" : "false");
+		break;
+	case Parameter::VEC3:
+	{
+		const glm::vec3& vec = *(glm::vec3*)parameter.value;
+		stream << vec.x << " " << vec.y << " " << vec.z;
+		break;
+	}
+	}
+	return stream.str();
+}
+
+bool Benchmark::applyParameter(const std::string& name, const std::string& value)
+{
+	auto it = m_parameters.find(name);
+	if (it == m_parameters.end())
+		return false;
+
+	return parseValue(it->second, value, it->second.value);
+}
+
+bool Benchmark::load(const std::string& filePath)
+{
+	std::ifstream file(filePath);
+	if (!file)
+	{
+		std::cout << "BENCHMARK ERROR: Couldn't open scenario file " << filePath << std::endl;
+		return false;
+	}
+
+	m_filePath = filePath;
+	m_runs.clear();
+	m_tracks.clear();
+
+	Scenario defaults;
+	Scenario current;
+	bool inScenario = false;
+	bool inDefaults = false;
+	bool inheritedCameras = true;	// Cleared once a scenario declares its own camera poses.
+
+	// Reports a parse error with its line number:
+	int lineNumber = 0;
+	auto parseError = [&](const std::string& message) {
+		std::cout << "BENCHMARK ERROR: " << filePath << ":" << lineNumber << ": " << message << std::endl;
+		return false;
+	};
+
+	// Checks a value can be parsed for a bound parameter without changing the parameter:
+	auto validate = [&](const std::string& name, const std::string& value) {
+		auto it = m_parameters.find(name);
+		if (it == m_parameters.end())
+			return parseError("unknown parameter \"" + name + "\"");
+
+		glm::vec3 scratch;
+		if (!parseValue(it->second, value, &scratch))
+			return parseError("invalid value \"" + value + "\" for parameter \"" + name + "\"");
+		return true;
+	};
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		++lineNumber;
+
+		// Strip comments and whitespace:
+		line = trim(line.substr(0, line.find('#')));
+		if (line.empty())
+			continue;
+
+		// Section headers:
+		if (line.front() == '[')
+		{
+			if (line.back() != ']')
+				return parseError("unterminated section header");
+
+			if (inScenario)
+				expandRuns(current);
+
+			const std::string header = trim(line.substr(1, line.size() - 2));
+			if (header == "defaults")
+			{
+				if (inScenario)
+					return parseError("[defaults] must come before any scenario");
+				inDefaults = true;
+			}
+			else if (header.compare(0, 9, "scenario ") == 0)
+			{
+				// Scenarios start as a copy of the defaults:
+				current = defaults;
+				current.name = trim(header.substr(9));
+				inScenario = true;
+				inDefaults = false;
+				inheritedCameras = true;
+			}
+			else
+				return parseError("unknown section \"" + header + "\"");
+			continue;
+		}
+
+		const size_t equals = line.find('=');
+		if (equals == std::string::npos)
+			return parseError("expected '='");
+
+		const std::vector<std::string> keyTokens = splitWhitespace(line.substr(0, equals));
+		const std::string value = trim(line.substr(equals + 1));
+		if (keyTokens.empty())
+			return parseError("missing key");
+
+		if (!inScenario && !inDefaults)
+		{
+			if (keyTokens[0] == "output")
+				m_outputDir = value;
+			else if (keyTokens[0] == "qualityReference")
+			{
+				std::istringstream stream(value);
+				stream >> m_referenceSamplesPerPixel >> m_referenceStepsPerSample;
+				if (stream.fail() || m_referenceSamplesPerPixel < 1 || m_referenceStepsPerSample < 1)
+					return parseError("qualityReference expects <samples per pixel> <steps per sample>");
+			}
+			else
+				return parseError("\"" + keyTokens[0] + "\" must be inside [defaults] or a scenario");
+			continue;
+		}
+		Scenario& target = inScenario ? current : defaults;
+
+		if (keyTokens[0] == "warmup" || keyTokens[0] == "iterations")
+		{
+			std::istringstream stream(value);
+			int frames = 0;
+			stream >> frames;
+			if (stream.fail() || frames < 0)
+				return parseError(keyTokens[0] + " expects a frame count");
+
+			if (keyTokens[0] == "warmup")
+				target.warmupFrames = frames;
+			else
+				target.iterations = std::max(1, frames);
+		}
+		else if (keyTokens[0] == "nsightReport")
+			target.nsightReport = value == "true" || value == "1";
+		else if (keyTokens[0] == "quality")
+			target.quality = value == "true" || value == "1";
+		else if (keyTokens[0] == "camera")
+		{
+			std::istringstream stream(value);
+			CameraPose pose;
+			stream >> pose.position.x >> pose.position.y >> pose.position.z >> pose.pitch >> pose.yaw;
+			if (stream.fail())
+				return parseError("camera expects <x> <y> <z> <pitch> <yaw>");
+
+			// A scenario's own camera poses replace the inherited ones:
+			if (inScenario && inheritedCameras)
+			{
+				target.cameraPoses.clear();
+				inheritedCameras = false;
+			}
+			target.cameraPoses.push_back(pose);
+		}
+		else if (keyTokens[0] == "cameraTrack")
+		{
+			// Load each track once, up front, so a missing file fails before the benchmark starts:
+			if (!m_tracks.count(value) && !m_tracks[value].load(value))
+			{
+				m_tracks.erase(value);
+				return parseError("couldn't load camera track \"" + value + "\"");
+			}
+			target.cameraTrack = value;
+		}
+		else if (keyTokens[0] == "set" && keyTokens.size() == 2)
+		{
+			if (!validate(keyTokens[1], value))
+				return false;
+			target.sets.push_back({ keyTokens[1], value });
+		}
+		else if (keyTokens[0] == "sweep" && keyTokens.size() == 2)
+		{
+			std::vector<std::string> values = splitWhitespace(value);
+
+			// Vec3 sweeps list values as groups of three floats:
+			auto it = m_parameters.find(keyTokens[1]);
+			if (it != m_parameters.end() && it->second.type == Parameter::VEC3)
+			{
+				if (values.size() % 3 != 0)
+					return parseError("vec3 sweeps need groups of three values");
+
+				std::vector<std::string> grouped;
+				for (size_t i = 0; i < values.size(); i += 3)
+					grouped.push_back(values[i] + " " + values[i + 1] + " " + values[i + 2]);
+				values = grouped;
+			}
+
+			if (values.empty())
+				return parseError("sweep needs at least one value");
+			for (const std::string& sweepValue : values)
+				if (!validate(keyTokens[1], sweepValue))
+					return false;
+			target.sweeps.push_back({ keyTokens[1], values });
+		}
+		else
+			return parseError("unknown statement \"" + keyTokens[0] + "\"");
+	}
+	if (inScenario)
+		expandRuns(current);
+
+	if (m_runs.empty())
+	{
+		std::cout << "BENCHMARK ERROR: " << filePath << " doesn't declare any scenarios." << std::endl;
+		return false;
+	}
+
+	std::cout << "Loaded " << m_runs.size() << " benchmark runs from " << filePath << std::endl;
+	return true;
+}
+
+void Benchmark::expandRuns(const Scenario& scenario)
+{
+	// Every combination of sweep values becomes one run (odometer-style over the sweep lists):
+	std::vector<size_t> indices(scenario.sweeps.size(), 0);
+
+	while (true)
+	{
+		Run run;
+		run.name = scenario.name;
+		run.scenario = scenario.name;
+		run.warmupFrames = scenario.warmupFrames;
+		run.iterations = scenario.iterations;
+		run.nsightReport = scenario.nsightReport;
+		run.quality = scenario.quality;
+		run.cameraPoses = scenario.cameraPoses;
+		run.cameraTrack = scenario.cameraTrack;
+		run.sets = scenario.sets;
+
+		for (size_t i = 0; i < scenario.sweeps.size(); ++i)
+		{
+			const std::string& name = scenario.sweeps[i].first;
+			const std::string& value = scenario.sweeps[i].second[indices[i]];
+
+			run.sets.push_back({ name, value });
+			run.name += (i == 0 ? "[" : ", ") + name + "=" + value + (i + 1 == scenario.sweeps.size() ? "]" : "");
+		}
+		m_runs.push_back(run);
+
+		// Advance to the next combination:
+		size_t sweep = 0;
+		for (; sweep < indices.size(); ++sweep)
+		{
+			if (++indices[sweep] < scenario.sweeps[sweep].second.size())
+				break;
+			indices[sweep] = 0;
+		}
+		if (sweep == indices.size())
+			break;
+	}
+}
+
+void Benchmark::start()
+{
+	if (m_runs.empty())
+		return;
+
+	// Remember current parameter values so they can be restored once the benchmark ends:
+	m_savedParameters.clear();
+	for (const auto& parameter : m_parameters)
+		m_savedParameters[parameter.first] = formatValue(parameter.second);
+
+	for (Run& run : m_runs)
+	{
+		run.cpuFrameMs.clear();
+		run.gpuPassMs.clear();
+		run.rmse.clear();
+		run.ssim.clear();
+		run.flip.clear();
+	}
+
+	m_running = true;
+	beginRun(0);
+	std::cout << "Starting benchmark (" << m_runs.size() << " runs)..." << std::endl;
+}
+
+void Benchmark::stop()
+{
+	if (m_running)
+	{
+		std::cout << "Benchmark stopped early." << std::endl;
+		finish();
+	}
+}
+
+void Benchmark::beginRun(size_t runIndex)
+{
+	m_currentRun = runIndex;
+	m_currentPose = 0;
+	m_poseFrame = 0;
+	m_applyRun = true;
+	m_applyPose = true;
+	m_reportPending = m_runs[runIndex].nsightReport;
+}
+
+void Benchmark::beginFrame(Camera& camera)
+{
+	if (!m_running)
+		return;
+
+	const Run& run = m_runs[m_currentRun];
+
+	// Apply the whole parameter state for this run, so runs don't depend on the order they execute in:
+	if (m_applyRun)
+	{
+		for (const auto& set : run.sets)
+			applyParameter(set.first, set.second);
+		m_applyRun = false;
+	}
+
+	// Camera tracks hold their first sample through warmup, then step one sample per measured frame:
+	if (const CameraTrack* track = getRunTrack(run))
+	{
+		const size_t sample = m_poseFrame < run.warmupFrames ? 0 : m_poseFrame - run.warmupFrames;
+		applyTrackSample(track->getSample(std::min(sample, track->getNumSamples() - 1)), camera);
+	}
+	else if (m_applyPose)
+	{
+		if (m_currentPose < run.cameraPoses.size())
+		{
+			const CameraPose& pose = run.cameraPoses[m_currentPose];
+			camera.setPosition(pose.position);
+			camera.setPitch(pose.pitch);
+			camera.setYaw(pose.yaw);
+			camera.findForward();
+		}
+		m_applyPose = false;
+	}
+}
+
+void Benchmark::endFrame(float cpuFrameMs, GPUTimer& gpuTimer)
+{
+	collectGPUResults(gpuTimer);
+
+	if (!m_running)
+		return;
+
+	Run& run = m_runs[m_currentRun];
+	if (m_poseFrame >= run.warmupFrames)
+		run.cpuFrameMs.push_back(cpuFrameMs);
+
+	// Move on to the next camera pose, then the next run, once enough frames have been measured:
+	if (++m_poseFrame < getFramesPerPose(run))
+		return;
+
+	m_poseFrame = 0;
+	m_applyPose = true;
+	if (++m_currentPose < getNumPoses(run))
+		return;
+
+	if (m_currentRun + 1 < m_runs.size())
+	{
+		beginRun(m_currentRun + 1);
+		return;
+	}
+
+	// All runs are done; wait for the last frames' GPU timings before writing results:
+	gpuTimer.flush();
+	collectGPUResults(gpuTimer);
+	finish();
+}
+
+int64_t Benchmark::getFrameTag() const
+{
+	if (!m_running || m_poseFrame < m_runs[m_currentRun].warmupFrames)
+		return -1;
+	return (int64_t)m_currentRun;
+}
+
+bool Benchmark::consumeNsightReportRequest()
+{
+	if (!m_reportPending || m_poseFrame < m_runs[m_currentRun].warmupFrames)
+		return false;
+
+	m_reportPending = false;
+	return true;
+}
+
+bool Benchmark::isQualityCaptureFrame() const
+{
+	if (!m_running)
+		return false;
+
+	const Run& run = m_runs[m_currentRun];
+	return run.quality && m_poseFrame >= run.warmupFrames && m_poseFrame + 1 == getFramesPerPose(run);
+}
+
+void Benchmark::addQualityScores(const ImageMetrics::Scores& scores)
+{
+	if (!m_running)
+		return;
+
+	Run& run = m_runs[m_currentRun];
+	run.rmse.push_back(scores.rmse);
+	run.ssim.push_back(scores.ssim);
+	run.flip.push_back(scores.flip);
+}
+
+float Benchmark::getFixedTimestep() const
+{
+	const CameraTrack* track = m_running ? getRunTrack(m_runs[m_currentRun]) : nullptr;
+	return track ? track->getTimestep() : 0.0f;
+}
+
+const CameraTrack* Benchmark::getRunTrack(const Run& run) const
+{
+	auto it = m_tracks.find(run.cameraTrack);
+	return it != m_tracks.end() && it->second.getNumSamples() > 0 ? &it->second : nullptr;
+}
+
+GLuint Benchmark::getFramesPerPose(const Run& run) const
+{
+	const CameraTrack* track = getRunTrack(run);
+	return run.warmupFrames + (track ? (GLuint)track->getNumSamples() : run.iterations);
+}
+
+size_t Benchmark::getNumPoses(const Run& run) const
+{
+	// A camera track counts as a single pose:
+	return getRunTrack(run) ? 1 : std::max<size_t>(run.cameraPoses.size(), 1);
+}
+
+void Benchmark::applyTrackSample(const CameraTrack::Sample& sample, Camera& camera)
+{
+	CameraTrack::applyToCamera(sample, camera);
+
+	// Write the sample's fog parameters through their bindings:
+	auto setBound = [this](const char* name, Parameter::Type type, const void* value, size_t size) {
+		auto it = m_parameters.find(name);
+		if (it != m_parameters.end() && it->second.type == type)
+			memcpy(it->second.value, value, size);
+	};
+	setBound("fogDensity", Parameter::FLOAT, &sample.fogDensity, sizeof(float));
+	setBound("fogScattering", Parameter::FLOAT, &sample.fogScattering, sizeof(float));
+	setBound("fogAbsorption", Parameter::FLOAT, &sample.fogAbsorption, sizeof(float));
+	setBound("fogPhaseGParam", Parameter::FLOAT, &sample.fogPhaseGParam, sizeof(float));
+	setBound("noiseOffset", Parameter::VEC3, &sample.noiseOffset, sizeof(glm::vec3));
+}
+
+const std::string& Benchmark::getCurrentRunName() const
+{
+	static const std::string none = "None";
+	return m_currentRun < m_runs.size() ? m_runs[m_currentRun].name : none;
+}
+
+std::string Benchmark::getRunOutputDir() const
+{
+	// Keep run names usable as directory names:
+	std::string name = getCurrentRunName();
+	for (char& c : name)
+		if (!isalnum((unsigned char)c) && c != '_' && c != '-')
+			c = '_';
+
+	return m_outputDir + "/" + name + "/";
+}
+
+void Benchmark::collectGPUResults(GPUTimer& gpuTimer)
+{
+	GPUTimer::FrameResults results;
+	while (gpuTimer.popResults(results))
+	{
+		// Untagged frames were warmup or outside the benchmark:
+		if (results.tag < 0 || results.tag >= (int64_t)m_runs.size())
+			continue;
+
+		Run& run = m_runs[results.tag];
+		for (const GPUTimer::ScopeResult& scope : results.scopes)
+			run.gpuPassMs[scope.name].push_back(scope.ms);
+	}
+}
+
+void Benchmark::finish()
+{
+	m_running = false;
+	m_reportPending = false;
+	writeResults();
+
+	// Restore the parameters the benchmark changed:
+	for (const auto& saved : m_savedParameters)
+		applyParameter(saved.first, saved.second);
+}
+
+Benchmark::Stats Benchmark::computeStats(std::vector<float> samples)
+{
+	Stats stats{};
+	stats.count = samples.size();
+	if (samples.empty())
+		return stats;
+
+	std::sort(samples.begin(), samples.end());
+
+	// Linearly interpolated percentile of the sorted samples:
+	auto percentile = [&](float p) {
+		const float rank = p * (samples.size() - 1);
+		const size_t lower = (size_t)rank;
+		const size_t upper = std::min(lower + 1, samples.size() - 1);
+		return samples[lower] + (rank - lower) * (samples[upper] - samples[lower]);
+	};
+
+	double sum = 0.0;
+	for (float sample : samples)
+		sum += sample;
+	stats.mean = (float)(sum / samples.size());
+
+	double squaredDiffs = 0.0;
+	for (float sample : samples)
+		squaredDiffs += (sample - stats.mean) * (sample - stats.mean);
+	stats.stdDev = samples.size() > 1 ? (float)std::sqrt(squaredDiffs / (samples.size() - 1)) : 0.0f;
+
+	stats.median = percentile(0.5f);
+	stats.p95 = percentile(0.95f);
+	stats.min = samples.front();
+	stats.max = samples.back();
+
+	// Two-sided 95% Student's t critical values for 1-30 degrees of freedom, normal approximation beyond:
+	static const float tTable[30] = { 12.706f, 4.303f, 3.182f, 2.776f, 2.571f, 2.447f, 2.365f, 2.306f, 2.262f, 2.228f,
+									   2.201f, 2.179f, 2.160f, 2.145f, 2.131f, 2.120f, 2.110f, 2.101f, 2.093f, 2.086f,
+									   2.080f, 2.074f, 2.069f, 2.064f, 2.060f, 2.056f, 2.052f, 2.048f, 2.045f, 2.042f };
+	const size_t dof = samples.size() - 1;
+	const float t = dof == 0 ? 0.0f : dof <= 30 ? tTable[dof - 1] : 1.96f;
+	const float halfWidth = t * stats.stdDev / std::sqrt((float)samples.size());
+
+	stats.ci95Low = stats.mean - halfWidth;
+	stats.ci95High = stats.mean + halfWidth;
+
+	return stats;
+}
+
+static void writeStatsJSON(std::ofstream& file, const Benchmark::Stats& stats)
+{
+	file << "{\"count\":" << stats.count << ",\"mean\":" << stats.mean << ",\"median\":" << stats.median
+		<< ",\"p95\":" << stats.p95 << ",\"min\":" << stats.min << ",\"max\":" << stats.max
+		<< ",\"stdDev\":" << stats.stdDev << ",\"ci95\":[" << stats.ci95Low << "," << stats.ci95High << "]}";
+}
+
+static void writeStatsCSV(std::ofstream& file, const std::string& run, const std::string& scenario, const std::string& metric, const Benchmark::Stats& stats)
+{
+	file << "\"" << run << "\",\"" << scenario << "\",\"" << metric << "\"," << stats.count << "," << stats.mean << ","
+		<< stats.median << "," << stats.p95 << "," << stats.min << "," << stats.max << "," << stats.stdDev << ","
+		<< stats.ci95Low << "," << stats.ci95High << "\n";
+}
+
+bool Benchmark::writeResults() const
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_outputDir, error);
+
+	std::ofstream json(m_outputDir + "/results.json");
+	std::ofstream csv(m_outputDir + "/results.csv");
+	if (!json || !csv)
+	{
+		std::cout << "BENCHMARK ERROR: Couldn't write results to " << m_outputDir << std::endl;
+		return false;
+	}
+	json << std::setprecision(6);
+	csv << std::setprecision(6);
+
+	json << "{\n\"scenarioFile\":\"" << escapeJSON(m_filePath) << "\",\n\"units\":\"ms\",\n\"runs\":[";
+	csv << "run,scenario,metric,count,mean,median,p95,min,max,stdDev,ci95Low,ci95High\n";
+
+	for (size_t i = 0; i < m_runs.size(); ++i)
+	{
+		const Run& run = m_runs[i];
+		const Stats cpuStats = computeStats(run.cpuFrameMs);
+
+		json << (i ? ",\n" : "\n") << "{\"name\":\"" << escapeJSON(run.name) << "\",\"scenario\":\"" << escapeJSON(run.scenario)
+			<< "\",\"cameraPoses\":" << run.cameraPoses.size() << ",\"cameraTrack\":\"" << escapeJSON(run.cameraTrack) << "\",\"cpuFrameMs\":";
+		writeStatsJSON(json, cpuStats);
+		writeStatsCSV(csv, run.name, run.scenario, "CPU frame", cpuStats);
+
+		json << ",\"gpuPassMs\":{";
+		bool firstPass = true;
+		for (const auto& pass : run.gpuPassMs)
+		{
+			const Stats passStats = computeStats(pass.second);
+
+			json << (firstPass ? "" : ",") << "\"" << escapeJSON(pass.first) << "\":";
+			writeStatsJSON(json, passStats);
+			writeStatsCSV(csv, run.name, run.scenario, pass.first, passStats);
+			firstPass = false;
+		}
+		json << "}";
+
+		if (!run.flip.empty())
+		{
+			const Stats rmseStats = computeStats(run.rmse), ssimStats = computeStats(run.ssim), flipStats = computeStats(run.flip);
+
+			json << ",\"quality\":{\"rmse\":";
+			writeStatsJSON(json, rmseStats);
+			json << ",\"ssim\":";
+			writeStatsJSON(json, ssimStats);
+			json << ",\"flip\":";
+			writeStatsJSON(json, flipStats);
+			json << "}";
+
+			writeStatsCSV(csv, run.name, run.scenario, "RMSE", rmseStats);
+			writeStatsCSV(csv, run.name, run.scenario, "SSIM", ssimStats);
+			writeStatsCSV(csv, run.name, run.scenario, "FLIP", flipStats);
+		}
+		json << "}";
+	}
+	json << "\n]}\n";
+
+	std::cout << "Wrote benchmark results to " << m_outputDir << "/results.json and results.csv" << std::endl;
+	return writeParetoReport();
+}
+
+bool Benchmark::writeParetoReport() const
+{
+	struct Point
+	{
+		const Run*	run;
+		float		costMs;		// Sum of the mean GPU pass times.
+		float		rmse;
+		float		ssim;
+		float		flip;
+		bool		frontier;
+	};
+
+	std::vector<Point> points;
+	for (const Run& run : m_runs)
+	{
+		if (run.flip.empty() || run.gpuPassMs.empty())
+			continue;
+
+		float costMs = 0.0f;
+		for (const auto& pass : run.gpuPassMs)
+			costMs += computeStats(pass.second).mean;
+		points.push_back({ &run, costMs, computeStats(run.rmse).mean, computeStats(run.ssim).mean, computeStats(run.flip).mean, true });
+	}
+
+	// Nothing scored, so there's no report to write:
+	if (points.empty())
+		return true;
+
+	// A run is on the frontier unless another is at least as cheap and as accurate, and better at one:
+	for (Point& point : points)
+		for (const Point& other : points)
+			if (other.costMs <= point.costMs && other.flip <= point.flip && (other.costMs < point.costMs || other.flip < point.flip))
+				point.frontier = false;
+
+	std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) { return a.costMs < b.costMs; });
+
+	std::ofstream csv(m_outputDir + "/pareto.csv");
+	std::ofstream markdown(m_outputDir + "/pareto.md");
+	if (!csv || !markdown)
+	{
+		std::cout << "BENCHMARK ERROR: Couldn't write the Pareto report to " << m_outputDir << std::endl;
+		return false;
+	}
+	csv << std::setprecision(6);
+	markdown << std::fixed;
+
+	csv << "run,scenario,gpuMs,rmse,ssim,flip,frontier\n";
+	markdown << "# Quality versus cost\n\n"
+		<< "Scenario file: `" << m_filePath << "`. Reference: " << m_referenceSamplesPerPixel << " samples per pixel, "
+		<< m_referenceStepsPerSample << " steps per sample.\n\n"
+		<< "Cost is the sum of the mean GPU pass times; error is the mean over camera poses. Frontier runs (marked *) "
+		<< "aren't beaten on both cost and FLIP error by any other run.\n\n"
+		<< "| | Run | GPU ms | RMSE | SSIM | FLIP |\n|---|---|---:|---:|---:|---:|\n";
+
+	for (const Point& point : points)
+	{
+		csv << "\"" << point.run->name << "\",\"" << point.run->scenario << "\"," << point.costMs << "," << point.rmse << ","
+			<< point.ssim << "," << point.flip << "," << (point.frontier ? "true" : "false") << "\n";
+		markdown << "| " << (point.frontier ? "*" : "") << " | " << point.run->name << " | " << std::setprecision(3) << point.costMs
+			<< " | " << std::setprecision(4) << point.rmse << " | " << point.ssim << " | " << point.flip << " |\n";
+	}
+
+	std::cout << "Wrote quality versus cost report to " << m_outputDir << "/pareto.csv and pareto.md" << std::endl;
+	return true;
+}
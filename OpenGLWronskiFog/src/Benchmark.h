@@ -0,0 +1,172 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "GPUTimer.h"	// Includes GLAD, so must come before GLFW.
+#include "Camera.h"
+#include "CameraTrack.h"
+#include "ImageMetrics.h"
+
+/*
+	Data-driven benchmark harness. Scenario files declare camera poses, parameter overrides and
+	sweeps, warmup and iteration counts; every combination of a scenario's sweep values becomes
+	one run. The App binds the parameters a scenario may set by name, and the runner drives
+	them frame by frame, collecting CPU frame times and GPU pass timings. When all runs finish,
+	per-pass statistics are written as JSON and CSV.
+
+	Runs can also be scored for image quality: on the last measured frame of each camera pose the
+	App compares the composited frame with the CPU reference renderer and reports the scores back.
+	Scored runs are then ranked by total GPU pass time against mean FLIP error, and the Pareto
+	frontier (runs no other run beats on both cost and error) is written to pareto.csv and pareto.md.
+
+	Scenario file format (one statement per line, '#' starts a comment):
+
+		output = BenchmarkResults			Output directory (global, optional).
+		qualityReference = <spp> <steps>	Reference renderer samples per pixel and steps per sample
+											used when scoring quality (global, optional).
+		[defaults]							Settings inherited by every scenario.
+		[scenario <name>]					Starts a new scenario.
+		warmup = <frames>					Unmeasured frames before each camera pose.
+		iterations = <frames>				Measured frames per camera pose.
+		camera = <x> <y> <z> <pitch> <yaw>	Adds a camera pose (repeat for several poses).
+		cameraTrack = <file>				Plays a recorded camera track instead of the poses, measuring
+											every sample once (iterations are ignored).
+		set <parameter> = <value>			Sets a bound parameter for the scenario.
+		sweep <parameter> = <v0> <v1> ...	Runs the scenario once per listed value.
+		nsightReport = <true|false>			Also collect an Nsight Perf SDK report per run (if enabled).
+		quality = <true|false>				Score each camera pose against the reference renderer.
+
+	Values are parsed according to the bound parameter's type: floats, ints, booleans
+	(true/false/1/0) and vec3s (three floats).
+*/
+
+class Benchmark
+{
+public:
+	struct Stats
+	{
+		size_t count;
+		float  mean;
+		float  median;
+		float  p95;
+		float  min;
+		float  max;
+		float  stdDev;
+		float  ci95Low;		// 95% confidence interval of the mean.
+		float  ci95High;
+	};
+
+	// Binds a named parameter that scenario files can set or sweep:
+	void bindFloat(const std::string& name, float* value)		{ m_parameters[name] = { Parameter::FLOAT, value }; }
+	void bindInt(const std::string& name, int* value)			{ m_parameters[name] = { Parameter::INT, value }; }
+	void bindBool(const std::string& name, bool* value)			{ m_parameters[name] = { Parameter::BOOL, value }; }
+	void bindVec3(const std::string& name, glm::vec3* value)	{ m_parameters[name] = { Parameter::VEC3, value }; }
+
+	bool load(const std::string& filePath);		// Parses a scenario file into runs, returns false on errors.
+	void start();								// Snapshots bound parameters and begins the first run.
+	void stop();								// Aborts the benchmark, writes whatever was measured, restores parameters.
+
+	// Per-frame driving. beginFrame() applies run parameters and camera poses as runs and poses change:
+	void	beginFrame(Camera& camera);
+	void	endFrame(float cpuFrameMs, GPUTimer& gpuTimer);
+	int64_t getFrameTag() const;				// Tag to pass to GPUTimer::beginFrame() (-1 for unmeasured frames).
+	bool	consumeNsightReportRequest();		// True once per run, after warmup, if the run requested a report.
+	bool	isRunStartFrame() const		{ return m_running && m_currentPose == 0 && m_poseFrame == 0; }
+	bool	isQualityCaptureFrame() const;		// True on the last measured frame of each pose of runs that score quality.
+	void	addQualityScores(const ImageMetrics::Scores& scores);
+	float	getFixedTimestep() const;			// Track timestep while the current run plays a camera track, otherwise 0.
+
+	bool				isRunning() const		{ return m_running; }
+	size_t				getNumRuns() const		{ return m_runs.size(); }
+	size_t				getCurrentRun() const	{ return m_currentRun; }
+	const std::string&	getCurrentRunName() const;
+	std::string			getOutputDir() const	{ return m_outputDir; }
+	std::string			getRunOutputDir() const;
+	void				setOutputDir(const std::string& dir) { m_outputDir = dir; }
+	int					getReferenceSamplesPerPixel() const	{ return m_referenceSamplesPerPixel; }
+	int					getReferenceStepsPerSample() const	{ return m_referenceStepsPerSample; }
+
+	static Stats computeStats(std::vector<float> samples);
+
+private:
+	struct Parameter
+	{
+		enum Type { FLOAT, INT, BOOL, VEC3 } type;
+		void* value;
+	};
+
+	struct CameraPose
+	{
+		glm::vec3 position;
+		float	  pitch;
+		float	  yaw;
+	};
+
+	struct Scenario
+	{
+		std::string										name;
+		GLuint											warmupFrames = 30;
+		GLuint											iterations = 100;
+		bool											nsightReport = false;
+		bool											quality = false;
+		std::vector<CameraPose>							cameraPoses;
+		std::string										cameraTrack;
+		std::vector<std::pair<std::string, std::string>> sets;
+		std::vector<std::pair<std::string, std::vector<std::string>>> sweeps;
+	};
+
+	struct Run
+	{
+		std::string										 name;
+		std::string										 scenario;
+		GLuint											 warmupFrames;
+		GLuint											 iterations;
+		bool											 nsightReport;
+		bool											 quality;
+		std::vector<CameraPose>							 cameraPoses;
+		std::string										 cameraTrack;
+		std::vector<std::pair<std::string, std::string>> sets;	// Defaults, then scenario sets, then this run's sweep values.
+
+		// Samples collected while measuring:
+		std::vector<float>								 cpuFrameMs;
+		std::map<std::string, std::vector<float>>		 gpuPassMs;
+		std::vector<float>								 rmse;	// One score per camera pose.
+		std::vector<float>								 ssim;
+		std::vector<float>								 flip;
+	};
+
+	bool		parseValue(const Parameter& parameter, const std::string& text, void* out) const;
+	std::string formatValue(const Parameter& parameter) const;
+	bool applyParameter(const std::string& name, const std::string& value);
+	void applyTrackSample(const CameraTrack::Sample& sample, Camera& camera);
+	const CameraTrack* getRunTrack(const Run& run) const;
+	GLuint getFramesPerPose(const Run& run) const;
+	size_t getNumPoses(const Run& run) const;
+	void expandRuns(const Scenario& scenario);
+	void beginRun(size_t runIndex);
+	void collectGPUResults(GPUTimer& gpuTimer);
+	void finish();
+	bool writeResults() const;
+	bool writeParetoReport() const;
+
+	std::map<std::string, Parameter>	m_parameters;
+	std::map<std::string, std::string>	m_savedParameters;	// Bound values before the benchmark started, restored afterwards.
+
+	std::vector<Run>					m_runs;
+	std::map<std::string, CameraTrack>	m_tracks;	// Camera tracks used by the runs, keyed by file path.
+	std::string							m_outputDir = "BenchmarkResults";
+	std::string							m_filePath;
+	int									m_referenceSamplesPerPixel = 64;
+	int									m_referenceStepsPerSample = 128;
+
+	bool	m_running = false;
+	size_t	m_currentRun = 0;
+	size_t	m_currentPose = 0;
+	GLuint	m_poseFrame = 0;		// Frames rendered at the current camera pose (warmup included).
+	bool	m_applyRun = false;		// Set when the next beginFrame() must apply the current run's parameters.
+	bool	m_applyPose = false;	// Set when the next beginFrame() must move to the next camera pose.
+	bool	m_reportPending = false;	// Set until the current run's Nsight report has been requested.
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "GLObject.h"
 #include "GLErrorManager.h"
+#include "GPUResourceRegistry.h"
 #include <vector>
 
 class VAO : public GLObject
@@ -36,7 +37,7 @@ public:
 	~VAO() {
 		if (m_handle) {
 			glDeleteVertexArrays(1, &m_handle);
-			glDeleteBuffers(1, &m_VBOhandle);
+			GPUResourceRegistry::deleteBuffer(m_VBOhandle);
 		}
 	}
 	void setData(const float data[], GLuint size, Format format)
@@ -48,6 +49,7 @@ public:
 		glGenBuffers(1, &m_VBOhandle);
 		glBindBuffer(GL_ARRAY_BUFFER, m_VBOhandle);
 		glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+		GPUResourceRegistry::registerBuffer(m_VBOhandle, GPUResourceRegistry::MISC, "VAO vertex buffer", size);
 
 		switch (format)
 		{
@@ -78,7 +80,8 @@ public:
 		// Generate + populate vertex buffer:
 		GLCALL(glGenBuffers(1, &m_VBOhandle));
 		GLCALL(glBindBuffer(GL_ARRAY_BUFFER, m_VBOhandle));
-		GLCALL(glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW));
+		GLCALL(glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(Vertex), data.data(), GL_STATIC_DRAW));
+		GPUResourceRegistry::registerBuffer(m_VBOhandle, GPUResourceRegistry::MESHES, "VAO vertex buffer", data.size() * sizeof(Vertex));
 
 		// Set position, tex coords and normal vertex attributes:
 		GLCALL(glEnableVertexAttribArray(0));
@@ -95,7 +98,7 @@ public:
 		GLCALL(glBindVertexArray(0));
 	}
 private:
-	GLuint m_VBOhandle;
+	GLuint m_VBOhandle = 0;
 };
 
 class EBO : public GLObject
@@ -107,13 +110,14 @@ public:
 	}
 	~EBO() { 
 		if (m_handle)
-			glDeleteBuffers(1, &m_handle);
+			GPUResourceRegistry::deleteBuffer(m_handle);
 	}
 	void setData(GLuint* data, GLuint size)
 	{
 		glGenBuffers(1, &m_handle);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_handle);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+		GPUResourceRegistry::registerBuffer(m_handle, GPUResourceRegistry::MESHES, "EBO index buffer", size);
 	}
 	void bind() const {
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_handle);
@@ -0,0 +1,131 @@
+#include "CPUProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+std::atomic<bool>					CPUProfiler::s_enabled{ true };
+std::atomic<uint32_t>				CPUProfiler::s_frameIndex{ 0 };
+uint64_t							CPUProfiler::s_frameStartNs = 0;
+std::mutex							CPUProfiler::s_registryMutex;
+std::vector<CPUProfiler::ThreadBuffer*>	CPUProfiler::s_threadBuffers;
+
+uint64_t CPUProfiler::now()
+{
+	static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+	// Offset by one so that a valid timestamp is never zero (zero marks a disabled ScopedZone):
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count() + 1;
+}
+
+CPUProfiler::ThreadBuffer* CPUProfiler::getThreadBuffer()
+{
+	thread_local ThreadBuffer* buffer = nullptr;
+
+	if (!buffer)
+	{
+		// Buffers are kept alive until the application exits so zones from finished threads can still be dumped:
+		buffer = new ThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(s_registryMutex);
+		buffer->threadID = (uint32_t)s_threadBuffers.size();
+		buffer->threadName = "Thread " + std::to_string(buffer->threadID);
+		s_threadBuffers.push_back(buffer);
+	}
+	return buffer;
+}
+
+void CPUProfiler::setThreadName(const char* name)
+{
+	ThreadBuffer* buffer = getThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(s_registryMutex);
+	buffer->threadName = name;
+}
+
+void CPUProfiler::markFrame()
+{
+	// Frame zones are recorded on the thread that marks frames (the main thread):
+	const uint64_t timeNs = now();
+	if (s_frameStartNs && isEnabled())
+		recordZone("Frame", s_frameStartNs, timeNs);
+
+	s_frameStartNs = timeNs;
+	s_frameIndex.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CPUProfiler::recordZone(const char* name, uint64_t startNs, uint64_t endNs)
+{
+	ThreadBuffer* buffer = getThreadBuffer();
+
+	// Only the owning thread writes to its buffer, so the slot can be filled before publishing the new index:
+	const uint64_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+	buffer->zones[index % c_ringSize] = { name, startNs, endNs, getFrameIndex() };
+	buffer->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+static void writeEscaped(std::ofstream& file, const char* str)
+{
+	for (; *str; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+			file << '\\';
+		file << *str;
+	}
+}
+
+bool CPUProfiler::dumpChromeTrace(const std::string& filePath)
+{
+	std::ofstream file(filePath);
+	if (!file)
+	{
+		std::cout << "CPU PROFILER ERROR: Couldn't open " << filePath << " for writing." << std::endl;
+		return false;
+	}
+	file << std::fixed << std::setprecision(3);
+
+	std::vector<Zone> zones;
+	size_t numZones = 0;
+	bool firstEvent = true;
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	std::lock_guard<std::mutex> lock(s_registryMutex);
+	for (ThreadBuffer* buffer : s_threadBuffers)
+	{
+		// Snapshot the ring, then drop any slots the owning thread may have overwritten while copying:
+		const uint64_t endIndex = buffer->writeIndex.load(std::memory_order_acquire);
+		uint64_t startIndex = endIndex > c_ringSize ? endIndex - c_ringSize : 0;
+
+		zones.clear();
+		for (uint64_t i = startIndex; i < endIndex; ++i)
+			zones.push_back(buffer->zones[i % c_ringSize]);
+
+		const uint64_t newEndIndex = buffer->writeIndex.load(std::memory_order_acquire);
+		const uint64_t overwritten = newEndIndex > startIndex + c_ringSize ? newEndIndex - (startIndex + c_ringSize) : 0;
+		zones.erase(zones.begin(), zones.begin() + std::min<size_t>(overwritten, zones.size()));
+
+		// Thread name metadata event:
+		file << (firstEvent ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->threadID
+			<< ",\"args\":{\"name\":\"";
+		writeEscaped(file, buffer->threadName.c_str());
+		file << "\"}}";
+		firstEvent = false;
+
+		// Complete ("X") events, timestamps in microseconds:
+		for (const Zone& zone : zones)
+		{
+			file << ",\n{\"name\":\"";
+			writeEscaped(file, zone.name);
+			file << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadID
+				<< ",\"ts\":" << zone.startNs / 1000.0 << ",\"dur\":" << (zone.endNs - zone.startNs) / 1000.0
+				<< ",\"args\":{\"frame\":" << zone.frame << "}}";
+		}
+		numZones += zones.size();
+	}
+	file << "\n]}\n";
+
+	std::cout << "Wrote " << numZones << " CPU profiler zones to " << filePath << std::endl;
+	return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+	Low-overhead CPU timing zones. Each thread records completed zones into its own fixed-size
+	ring buffer (single writer, no locks on the hot path), so the oldest zones are overwritten
+	once a buffer wraps. Zone names must be string literals (or otherwise outlive the profiler),
+	since only the pointer is stored. Recorded zones can be dumped at any time as Chrome/Perfetto
+	trace JSON (load in chrome://tracing or ui.perfetto.dev).
+*/
+
+class CPUProfiler
+{
+public:
+	struct Zone
+	{
+		const char* name;
+		uint64_t	startNs;
+		uint64_t	endNs;
+		uint32_t	frame;
+	};
+
+	static const uint32_t c_ringSize = 1 << 16;	// Zones kept per thread before the oldest are overwritten.
+
+	static void		setEnabled(bool enabled)	{ s_enabled.store(enabled, std::memory_order_relaxed); }
+	static bool		isEnabled()					{ return s_enabled.load(std::memory_order_relaxed); }
+	static uint32_t getFrameIndex()				{ return s_frameIndex.load(std::memory_order_relaxed); }
+
+	static uint64_t now();											// Nanoseconds since the profiler was first used.
+	static void		setThreadName(const char* name);				// Names the calling thread's track in the trace.
+	static void		markFrame();									// Closes the current frame zone and starts the next one.
+	static void		recordZone(const char* name, uint64_t startNs, uint64_t endNs);
+	static bool		dumpChromeTrace(const std::string& filePath);	// Writes all buffered zones to a trace JSON file.
+
+private:
+	struct ThreadBuffer
+	{
+		std::vector<Zone>		zones = std::vector<Zone>(c_ringSize);
+		std::atomic<uint64_t>	writeIndex{ 0 };
+		uint32_t				threadID{};
+		std::string				threadName;
+	};
+
+	static ThreadBuffer* getThreadBuffer();
+
+	static std::atomic<bool>		s_enabled;
+	static std::atomic<uint32_t>	s_frameIndex;
+	static uint64_t					s_frameStartNs;
+
+	// Only touched when a thread registers its buffer or when dumping, never per zone:
+	static std::mutex					s_registryMutex;
+	static std::vector<ThreadBuffer*>	s_threadBuffers;
+};
+
+class ScopedZone
+{
+public:
+	ScopedZone(const char* name) : m_name(name), m_startNs(CPUProfiler::isEnabled() ? CPUProfiler::now() : 0) {}
+	~ScopedZone()
+	{
+		if (m_startNs)
+			CPUProfiler::recordZone(m_name, m_startNs, CPUProfiler::now());
+	}
+
+private:
+	const char* m_name;
+	uint64_t	m_startNs;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ScopedZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
@@ -34,6 +34,8 @@ public:
 
 	void setPitch(float newPitch) { m_pitch = newPitch; }
 	void setYaw(float newYaw) { m_yaw = newYaw; }
+	float getPitch() const { return m_pitch; }
+	float getYaw() const { return m_yaw; }
 
 private:
 	glm::vec3	m_position = glm::vec3(0.0f, 0.0f, 3.0f);
@@ -0,0 +1,158 @@
+#include "CameraTrack.h"
+
+#include <fstream>
+#include <iostream>
+
+void CameraTrack::startRecording(float timestep)
+{
+	m_samples.clear();
+	m_timestep = timestep;
+	m_recording = true;
+	m_playing = false;
+}
+
+void CameraTrack::record(float dt, const Sample& sample)
+{
+	if (!m_recording)
+		return;
+
+	// The first frame is sample zero:
+	if (m_samples.empty())
+	{
+		m_samples.push_back(sample);
+		m_recordTime = 0.0;
+		m_nextSampleTime = m_timestep;
+		m_lastFrameSample = sample;
+		return;
+	}
+
+	// Emit every fixed-timestep sample that falls between the last frame and this one:
+	const double frameTime = m_recordTime + dt;
+	while (dt > 0.0f && m_nextSampleTime <= frameTime)
+	{
+		const float t = (float)((m_nextSampleTime - m_recordTime) / dt);
+		m_samples.push_back(lerp(m_lastFrameSample, sample, t));
+		m_nextSampleTime += m_timestep;
+	}
+
+	m_recordTime = frameTime;
+	m_lastFrameSample = sample;
+}
+
+void CameraTrack::startPlayback(bool loop)
+{
+	m_playing = !m_samples.empty();
+	m_recording = false;
+	m_loop = loop;
+	m_playhead = 0;
+}
+
+bool CameraTrack::advance(Sample& sample)
+{
+	if (!m_playing)
+		return false;
+
+	if (m_playhead >= m_samples.size())
+	{
+		if (!m_loop)
+		{
+			m_playing = false;
+			return false;
+		}
+		m_playhead = 0;
+	}
+
+	sample = m_samples[m_playhead++];
+	return true;
+}
+
+bool CameraTrack::save(const std::string& filePath) const
+{
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "CAMERA TRACK ERROR: Couldn't open " << filePath << " for writing." << std::endl;
+		return false;
+	}
+
+	const uint32_t numSamples = (uint32_t)m_samples.size();
+	file.write((const char*)&c_magic, sizeof(c_magic));
+	file.write((const char*)&c_version, sizeof(c_version));
+	file.write((const char*)&m_timestep, sizeof(m_timestep));
+	file.write((const char*)&numSamples, sizeof(numSamples));
+	file.write((const char*)m_samples.data(), numSamples * sizeof(Sample));
+
+	std::cout << "Saved " << numSamples << " camera track samples to " << filePath << std::endl;
+	return true;
+}
+
+bool CameraTrack::load(const std::string& filePath)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "CAMERA TRACK ERROR: Couldn't open " << filePath << std::endl;
+		return false;
+	}
+
+	uint32_t magic = 0, version = 0, numSamples = 0;
+	float timestep = 0.0f;
+	file.read((char*)&magic, sizeof(magic));
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&timestep, sizeof(timestep));
+	file.read((char*)&numSamples, sizeof(numSamples));
+
+	if (!file || magic != c_magic || version != c_version || !(timestep > 0.0f))
+	{
+		std::cout << "CAMERA TRACK ERROR: " << filePath << " isn't a version " << c_version << " camera track." << std::endl;
+		return false;
+	}
+
+	// The header's sample count is checked against what's left of the file before anything is allocated for it:
+	const std::streampos samplesStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	const uint64_t bytesLeft = (uint64_t)(file.tellg() - samplesStart);
+	file.seekg(samplesStart);
+
+	if (!file || (uint64_t)numSamples * sizeof(Sample) > bytesLeft)
+	{
+		std::cout << "CAMERA TRACK ERROR: " << filePath << " is truncated." << std::endl;
+		return false;
+	}
+
+	std::vector<Sample> samples(numSamples);
+	file.read((char*)samples.data(), numSamples * sizeof(Sample));
+	if (!file)
+	{
+		std::cout << "CAMERA TRACK ERROR: " << filePath << " is truncated." << std::endl;
+		return false;
+	}
+
+	m_samples = std::move(samples);
+	m_timestep = timestep;
+	m_recording = false;
+	m_playing = false;
+	return true;
+}
+
+void CameraTrack::applyToCamera(const Sample& sample, Camera& camera)
+{
+	camera.setPosition(sample.position);
+	camera.setPitch(sample.pitch);
+	camera.setYaw(sample.yaw);
+	camera.findForward();
+}
+
+CameraTrack::Sample CameraTrack::lerp(const Sample& a, const Sample& b, float t)
+{
+	Sample sample;
+	sample.position = glm::mix(a.position, b.position, t);
+	sample.pitch = glm::mix(a.pitch, b.pitch, t);
+	sample.yaw = glm::mix(a.yaw, b.yaw, t);
+	sample.fogDensity = glm::mix(a.fogDensity, b.fogDensity, t);
+	sample.fogScattering = glm::mix(a.fogScattering, b.fogScattering, t);
+	sample.fogAbsorption = glm::mix(a.fogAbsorption, b.fogAbsorption, t);
+	sample.fogPhaseGParam = glm::mix(a.fogPhaseGParam, b.fogPhaseGParam, t);
+	sample.noiseOffset = glm::mix(a.noiseOffset, b.noiseOffset, t);
+	return sample;
+}
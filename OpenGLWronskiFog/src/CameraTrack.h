@@ -0,0 +1,82 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Camera.h"
+
+/*
+	Records and plays back camera flythroughs. Recording resamples live input at a fixed
+	timestep (interpolating between the frames either side of each sample time), and playback
+	steps exactly one sample per frame, so a track replays identically regardless of the frame
+	rate or machine it was recorded on. Alongside the camera pose, each sample stores the
+	time-varying fog parameters so animated fog replays too.
+
+	Binary file layout (little-endian):
+		uint32	magic ("WFCT")
+		uint32	version
+		float	timestep (seconds)
+		uint32	number of samples
+		Sample	samples[number of samples]
+*/
+
+class CameraTrack
+{
+public:
+	struct Sample
+	{
+		glm::vec3 position;
+		float	  pitch;
+		float	  yaw;
+
+		// Fog parameters:
+		float	  fogDensity;
+		float	  fogScattering;
+		float	  fogAbsorption;
+		float	  fogPhaseGParam;
+		glm::vec3 noiseOffset;
+	};
+
+	static constexpr uint32_t c_magic = 'W' | ('F' << 8) | ('C' << 16) | ('T' << 24);
+	static constexpr uint32_t c_version = 1;
+	static constexpr float c_defaultTimestep = 1.0f / 60.0f;
+
+	// Recording. record() is called once per frame with that frame's real delta time:
+	void startRecording(float timestep = c_defaultTimestep);
+	void record(float dt, const Sample& sample);
+	void stopRecording()	{ m_recording = false; }
+
+	// Playback. advance() returns false once the track has finished (never, if looping):
+	void startPlayback(bool loop);
+	bool advance(Sample& sample);
+	void stopPlayback()		{ m_playing = false; }
+
+	bool save(const std::string& filePath) const;
+	bool load(const std::string& filePath);
+
+	bool			isRecording() const		{ return m_recording; }
+	bool			isPlaying() const		{ return m_playing; }
+	float			getTimestep() const		{ return m_timestep; }
+	size_t			getNumSamples() const	{ return m_samples.size(); }
+	size_t			getPlayhead() const		{ return m_playhead; }
+	const Sample&	getSample(size_t index) const { return m_samples[index]; }
+
+	static void applyToCamera(const Sample& sample, Camera& camera);
+
+private:
+	static Sample lerp(const Sample& a, const Sample& b, float t);
+
+	std::vector<Sample> m_samples;
+	float				m_timestep = c_defaultTimestep;
+
+	bool	m_recording = false;
+	double	m_recordTime = 0.0;			// Time of the last recorded frame.
+	double	m_nextSampleTime = 0.0;
+	Sample	m_lastFrameSample{};
+
+	bool	m_playing = false;
+	bool	m_loop = false;
+	size_t	m_playhead = 0;
+};
@@ -0,0 +1,178 @@
+#include "FogClipmap.h"
+
+#include <algorithm>
+#include <string>
+
+#include "FogRenderer.h"
+#include "GPUResourceRegistry.h"
+#include "SceneUtils.h"
+
+static_assert((FogClipmap::c_resolution & (FogClipmap::c_resolution - 1)) == 0, "Clipmap resolution must be a power of two for toroidal addressing.");
+
+bool FogClipmap::Medium::operator==(const Medium& other) const
+{
+	// The noise only matters to heterogeneous fog (which the wind keeps invalidating, as it moves every frame):
+	return scattering == other.scattering && absorption == other.absorption && density == other.density
+		&& lightIntensity == other.lightIntensity && attenuation == other.attenuation && lightPlanes == other.lightPlanes && shadowMapTechnique == other.shadowMapTechnique
+		&& heterogeneous == other.heterogeneous && heightFog == other.heightFog && (!heightFog || heightRange == other.heightRange)
+		&& (!heterogeneous || (noiseFreq == other.noiseFreq && noiseOffset == other.noiseOffset));
+}
+
+void FogClipmap::init(float baseCellSize)
+{
+	m_baseCellSize = baseCellSize;
+
+	for (int i = 0; i < c_numCascades; ++i)
+	{
+		glGenTextures(1, &m_textures[i]);
+		glBindTexture(GL_TEXTURE_3D, m_textures[i]);
+
+		// Wrapping is what makes the toroidal addressing work with filtering:
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+		glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, c_resolution, c_resolution, c_resolution, 0, GL_RGBA, GL_FLOAT, NULL);
+		GPUResourceRegistry::registerTexture(m_textures[i], GPUResourceRegistry::FROXELS, "Fog clipmap cascade " + std::to_string(i), GL_RGBA16F, glm::uvec3(c_resolution));
+	}
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	m_valid = false;
+}
+
+void FogClipmap::release()
+{
+	for (int i = 0; i < c_numCascades; ++i)
+		GPUResourceRegistry::deleteTexture(m_textures[i]);
+
+	m_regions.clear();
+	m_valid = false;
+}
+
+void FogClipmap::plan(const glm::vec3& cameraPos, const Medium& medium, const LightManager::Light* lights, int numLights)
+{
+	m_regions.clear();
+
+	// A changed medium touches every cell, as does the first update:
+	const bool refreshAll = !m_valid || !(medium == m_medium);
+
+	for (int c = 0; c < c_numCascades; ++c)
+	{
+		// Keep the camera in the middle cell of each cascade:
+		const glm::ivec3 origin = glm::ivec3(glm::floor(cameraPos / getCellSize(c))) - glm::ivec3(c_resolution / 2);
+		const glm::ivec3 delta = origin - m_origins[c];
+		m_origins[c] = origin;
+
+		if (refreshAll || glm::any(glm::greaterThanEqual(glm::abs(delta), glm::ivec3(c_resolution))))
+		{
+			addRegion(c, origin, origin + glm::ivec3(c_resolution));
+			continue;
+		}
+
+		// One slab of newly covered cells per axis moved along, each leaving out the cells earlier slabs covered:
+		glm::ivec3 low = origin, high = origin + glm::ivec3(c_resolution);
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (delta[axis] == 0)
+				continue;
+
+			glm::ivec3 slabLow = low, slabHigh = high;
+			if (delta[axis] > 0)
+				slabLow[axis] = high[axis] = high[axis] - delta[axis];
+			else
+				slabHigh[axis] = low[axis] = low[axis] - delta[axis];
+
+			addRegion(c, slabLow, slabHigh);
+		}
+	}
+
+	// Cells lit by a light before or after it changed (or was switched on or off):
+	if (!refreshAll)
+	{
+		for (int i = 0; i < std::max(numLights, m_numLights); ++i)
+		{
+			const bool wasActive = i < m_numLights, isActive = i < numLights;
+			if (wasActive && isActive && lights[i].position == m_lights[i].position && lights[i].diffuse == m_lights[i].diffuse
+				&& lights[i].radius == m_lights[i].radius)
+				continue;
+
+			if (wasActive)
+				addSphere(m_lights[i].position, m_lights[i].radius);
+			if (isActive)
+				addSphere(lights[i].position, lights[i].radius);
+		}
+	}
+
+	m_medium = medium;
+	std::copy(lights, lights + numLights, m_lights);
+	m_numLights = numLights;
+	m_valid = true;
+
+	m_cellsUpdated = 0;
+	for (const Region& region : m_regions)
+		m_cellsUpdated += region.size.x * region.size.y * region.size.z;
+}
+
+void FogClipmap::dispatchUpdates(const Shader& updateShader) const
+{
+	if (m_regions.empty())
+		return;
+
+	updateShader.use();
+	updateShader.setInt("u_resolution", c_resolution);
+
+	for (const Region& region : m_regions)
+	{
+		FogRenderer::bindImage(1, m_textures[region.cascade], GL_WRITE_ONLY, GL_RGBA16F);
+		updateShader.setFloat("u_cellSize", getCellSize(region.cascade));
+		updateShader.setVec3("u_regionMin", glm::vec3(region.min));
+		updateShader.setVec3("u_regionSize", glm::vec3(region.size));
+
+		const glm::uvec3 numGroups = (glm::uvec3(region.size) + glm::uvec3(c_groupSize - 1)) / glm::uvec3(c_groupSize);
+		FogRenderer::dispatch(numGroups, updateShader);
+	}
+
+	// The cascades are sampled as textures next:
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void FogClipmap::bindCascades(const Shader& sampleShader, GLuint firstUnit) const
+{
+	sampleShader.use();
+	sampleShader.setFloat("u_cascadeResolution", (float)c_resolution);
+
+	for (int i = 0; i < c_numCascades; ++i)
+	{
+		glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+		glBindTexture(GL_TEXTURE_3D, m_textures[i]);
+
+		sampleShader.setVec3(SceneUtils::getArrayUniformName("u_cascadeOrigin", i), glm::vec3(m_origins[i]));
+		sampleShader.setFloat(SceneUtils::getArrayUniformName("u_cascadeCellSize", i), getCellSize(i));
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void FogClipmap::addRegion(int cascade, glm::ivec3 min, glm::ivec3 max)
+{
+	min = glm::max(min, m_origins[cascade]);
+	max = glm::min(max, m_origins[cascade] + glm::ivec3(c_resolution));
+
+	if (glm::any(glm::lessThanEqual(max, min)))
+		return;
+
+	m_regions.push_back({ cascade, min, max - min });
+}
+
+void FogClipmap::addSphere(const glm::vec3& centre, float radius)
+{
+	for (int c = 0; c < c_numCascades; ++c)
+	{
+		const float cellSize = getCellSize(c);
+
+		const glm::ivec3 min = glm::ivec3(glm::floor((centre - radius) / cellSize));
+		const glm::ivec3 max = glm::ivec3(glm::floor((centre + radius) / cellSize)) + glm::ivec3(1);
+		addRegion(c, min, max);
+	}
+}
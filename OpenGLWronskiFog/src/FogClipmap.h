@@ -0,0 +1,93 @@
+#pragma once
+#include <glad4.3/glad4.3.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "LightManager.h"
+#include "Shader.h"
+
+/*
+	A world-space fog volume: nested cascades of cells centred on the camera, each with twice the cell
+	size of the one inside it. Cells hold scattering and extinction, so unlike view-aligned froxels
+	they stay valid however the camera turns.
+
+	Each cascade is addressed toroidally (cell c lives in texel c mod c_resolution, which GL_REPEAT
+	sampling follows), so as the camera moves a cascade scrolls by whole cells and only the slabs of
+	cells it newly covers are recomputed. Cells within reach of a light that changed are recomputed
+	too, and every cell is when the medium itself changes.
+
+	For those updates to stay local, the update shader windows each light's attenuation to its radius.
+	Scattering is isotropic, as a view-dependent phase function would tie the cells to the camera
+	direction again.
+*/
+
+class FogClipmap
+{
+public:
+	static const int c_numCascades = 4;
+	static const int c_resolution = 64;		// Cells per side, a power of two.
+	static const int c_groupSize = 4;		// Local size of fogClipmapUpdateShader.comp in each dimension.
+
+	// Everything the cells depend on other than the lights, where any change invalidates the whole clipmap:
+	struct Medium
+	{
+		float		scattering = 0.0f;
+		float		absorption = 0.0f;
+		float		density = 0.0f;
+		float		lightIntensity = 0.0f;
+		glm::vec3	attenuation = glm::vec3(0.0f);	// Constant, linear and quadratic.
+		glm::vec2	lightPlanes = glm::vec2(0.0f);	// Shadowmap near and far planes.
+		int			shadowMapTechnique = 0;
+		bool		heterogeneous = false;
+		float		noiseFreq = 0.0f;
+		glm::vec3	noiseOffset = glm::vec3(0.0f);
+		bool		heightFog = false;
+		glm::vec2	heightRange = glm::vec2(0.0f);	// Base height, and scale height above it.
+
+		bool operator==(const Medium& other) const;
+	};
+
+	void init(float baseCellSize);
+	void release();
+	void invalidate()	{ m_valid = false; }
+
+	// Works out which cells this frame's updates cover, from the camera position and what changed since the last call:
+	void plan(const glm::vec3& cameraPos, const Medium& medium, const LightManager::Light* lights, int numLights);
+
+	// Runs the planned updates (the update shader's fog and light uniforms must already be set):
+	void dispatchUpdates(const Shader& updateShader) const;
+
+	// Binds the cascades to consecutive texture units, and sets the sample shader's cascade uniforms:
+	void bindCascades(const Shader& sampleShader, GLuint firstUnit) const;
+
+	float		getCellSize(int cascade) const	{ return m_baseCellSize * (float)(1 << cascade); }
+	glm::ivec3	getOrigin(int cascade) const	{ return m_origins[cascade]; }
+	GLuint		getTexture(int cascade) const	{ return m_textures[cascade]; }
+	int			getCellsUpdated() const			{ return m_cellsUpdated; }	// Planned by the last plan() call.
+	int			getNumCells() const				{ return c_numCascades * c_resolution * c_resolution * c_resolution; }
+
+private:
+	struct Region
+	{
+		int			cascade;
+		glm::ivec3	min;	// In cells.
+		glm::ivec3	size;
+	};
+
+	void addRegion(int cascade, glm::ivec3 min, glm::ivec3 max);	// Clipped to the cascade.
+	void addSphere(const glm::vec3& centre, float radius);			// Every cell the sphere touches, in every cascade.
+
+	GLuint				m_textures[c_numCascades] = {};
+	float				m_baseCellSize = 1.0f;
+	glm::ivec3			m_origins[c_numCascades];		// Lowest cell each cascade covers.
+	bool				m_valid = false;
+
+	// What the cells were last computed with:
+	Medium				m_medium;
+	LightManager::Light m_lights[NUM_LIGHTS];
+	int					m_numLights = 0;
+
+	std::vector<Region> m_regions;
+	int					m_cellsUpdated = 0;
+};
@@ -16,22 +16,34 @@ public:
 	}
 	static void bindImage(const GLuint binding, const GLuint tex, const GLuint access, const GLuint format)
 	{
-		GLCALL(glBindImageTexture(binding, tex, 0, GL_FALSE, 0, access, format));
+		// Layered, so 3D textures are bound whole rather than just their first slice (ignored for 2D textures):
+		GLCALL(glBindImageTexture(binding, tex, 0, GL_TRUE, 0, access, format));
 	}
-	static void compositeFog(const GLuint vao, const GLuint normalRenderColourTex, const GLuint normalRenderDepthTex, const GLuint fog3DAccumTex, const Shader& shader)
+	static void compositeFog(const GLuint vao, const GLuint normalRenderColourTex, const GLuint normalRenderDepthTex, const GLuint* fog3DAccumTex, const GLuint* fog3DAccumAlphaTex, const int numCascades, const Shader& shader)
 	{
 		shader.use();
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, normalRenderColourTex);
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, normalRenderDepthTex);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_3D, fog3DAccumTex);
+		bindFogVolumes(2, fog3DAccumTex, fog3DAccumAlphaTex, numCascades);
 
 		glBindVertexArray(vao);
 		glDrawArrays(GL_TRIANGLES, 0, 6);	// Two-triangle quad expected.
 		glBindVertexArray(0);
 		glActiveTexture(GL_TEXTURE0);
 	}
+	static void bindFogVolumes(const GLuint firstUnit, const GLuint* fog3DAccumTex, const GLuint* fog3DAccumAlphaTex, const int numCascades)
+	{
+		// One accumulated volume per froxel cascade, near to far, and its transmittance if that's kept separately:
+		for (int i = 0; i < numCascades; ++i)
+		{
+			glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+			glBindTexture(GL_TEXTURE_3D, fog3DAccumTex[i]);
+			glActiveTexture(GL_TEXTURE0 + firstUnit + numCascades + i);
+			glBindTexture(GL_TEXTURE_3D, fog3DAccumAlphaTex[i]);
+		}
+		glActiveTexture(GL_TEXTURE0);
+	}
 private:
 };
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "FrameCapture.h"
+
+#include <iostream>
+
+#include "CPUProfiler.h"
+#include "GPUResourceRegistry.h"
+#include "ReferenceRenderer.h"
+
+static GLsizeiptr getCaptureBytes(glm::uvec2 dim, FrameCapture::Encoding encoding)
+{
+	return (GLsizeiptr)dim.x * dim.y * 3 * (encoding == FrameCapture::PFM ? sizeof(float) : sizeof(uint8_t));
+}
+
+void FrameCapture::init()
+{
+	if (m_writer.joinable())
+		return;
+
+	glGenFramebuffers(1, &m_readFBO);
+
+	m_stopping = false;
+	m_writer = std::thread(&FrameCapture::writerMain, this);
+}
+
+void FrameCapture::shutdown()
+{
+	if (!m_writer.joinable())
+		return;
+
+	// Finish every capture, oldest first:
+	for (int i = 0; i < c_ringSize; ++i)
+		advance(m_slots[(m_nextSlot + i) % c_ringSize], true);
+
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_stopping = true;
+	}
+	m_queueReady.notify_one();
+	m_writer.join();
+
+	// One line for the whole batch, rather than one per file from the writer thread:
+	if (m_written > 0)
+		std::cout << "Wrote " << m_written << " frame captures, the last to " << m_lastWrittenPath << std::endl;
+
+	for (Slot& slot : m_slots)
+	{
+		if (slot.pbo)
+			GPUResourceRegistry::deleteBuffer(slot.pbo);
+		slot.capacity = 0;
+	}
+	glDeleteFramebuffers(1, &m_readFBO);
+	m_readFBO = 0;
+}
+
+void FrameCapture::captureFramebuffer(GLuint fbo, GLenum readBuffer, glm::uvec2 dim, Encoding encoding, const std::string& filePath)
+{
+	const uint64_t startNs = CPUProfiler::now();
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glReadBuffer(readBuffer);
+	readPixels(acquireSlot(getCaptureBytes(dim, encoding)), dim, encoding, filePath);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	m_frameCostNs += CPUProfiler::now() - startNs;
+}
+
+void FrameCapture::captureTextureLayer(GLuint texture, GLint layer, glm::uvec2 dim, Encoding encoding, const std::string& filePath)
+{
+	const uint64_t startNs = CPUProfiler::now();
+
+	// The texture may have been written with image stores, which framebuffer reads don't wait for:
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_readFBO);
+	glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0, layer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	readPixels(acquireSlot(getCaptureBytes(dim, encoding)), dim, encoding, filePath);
+	glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0, 0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	m_frameCostNs += CPUProfiler::now() - startNs;
+}
+
+void FrameCapture::update()
+{
+	PROFILE_FUNCTION();
+	const uint64_t startNs = CPUProfiler::now();
+
+	// Oldest first, so files are written in the order they were captured:
+	for (int i = 0; i < c_ringSize; ++i)
+		advance(m_slots[(m_nextSlot + i) % c_ringSize], false);
+
+	m_frameCostMs = (m_frameCostNs + CPUProfiler::now() - startNs) / 1000000.0f;
+	m_frameCostNs = 0;
+}
+
+FrameCapture::Slot& FrameCapture::acquireSlot(GLsizeiptr bytes)
+{
+	Slot& slot = m_slots[m_nextSlot];
+	m_nextSlot = (m_nextSlot + 1) % c_ringSize;
+
+	// Every slot is busy, so wait for this one, the oldest, to be written:
+	if (slot.state != FREE)
+	{
+		PROFILE_SCOPE("Frame capture stall");
+		const uint64_t startNs = CPUProfiler::now();
+		advance(slot, true);
+		m_totalStallMs += (CPUProfiler::now() - startNs) / 1000000.0f;
+	}
+
+	// Grow the PBO if this capture doesn't fit:
+	if (slot.capacity < bytes)
+	{
+		if (slot.pbo)
+			GPUResourceRegistry::deleteBuffer(slot.pbo);
+
+		glGenBuffers(1, &slot.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		GPUResourceRegistry::registerBuffer(slot.pbo, GPUResourceRegistry::MISC, "Frame capture PBO", bytes);
+		slot.capacity = bytes;
+	}
+
+	return slot;
+}
+
+void FrameCapture::readPixels(Slot& slot, glm::uvec2 dim, Encoding encoding, const std::string& filePath)
+{
+	// With a pack buffer bound, glReadPixels() copies into it on the GPU timeline instead of returning the pixels:
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, dim.x, dim.y, GL_RGB, encoding == PFM ? GL_FLOAT : GL_UNSIGNED_BYTE, NULL);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.filePath = filePath;
+	slot.dim = dim;
+	slot.encoding = encoding;
+	slot.state = READING;
+	++m_pending;
+}
+
+bool FrameCapture::advance(Slot& slot, bool wait)
+{
+	if (slot.state == READING)
+	{
+		// The copy into the PBO may not have finished (when waiting, flush so the fence can signal):
+		if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			if (!wait)
+				return false;
+			while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+
+		// Leave the PBO mapped while the writer thread encodes straight from it:
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		slot.data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, getCaptureBytes(slot.dim, slot.encoding), GL_MAP_READ_BIT);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		if (!slot.data)
+		{
+			std::cout << "FRAME CAPTURE ERROR: Couldn't map the pixel buffer for " << slot.filePath << std::endl;
+			slot.state = FREE;
+			--m_pending;
+			return true;
+		}
+
+		slot.state = WRITING;
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_queue.push_back(&slot);
+		}
+		m_queueReady.notify_one();
+	}
+
+	if (slot.state == WRITING)
+	{
+		if (!wait)
+			return false;
+		while (slot.state == WRITING)
+			std::this_thread::yield();
+	}
+
+	if (slot.state == WRITTEN)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot.data = nullptr;
+		slot.state = FREE;
+		--m_pending;
+	}
+
+	return slot.state == FREE;
+}
+
+void FrameCapture::writerMain()
+{
+	CPUProfiler::setThreadName("Frame capture writer");
+
+	while (true)
+	{
+		Slot* slot;
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_queueReady.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+			if (m_queue.empty())
+				return;
+
+			slot = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		{
+			ScopedZone zone("Write frame capture");
+			if (slot->encoding == PPM)
+				ReferenceRenderer::writePPM(slot->filePath, slot->dim, (const uint8_t*)slot->data);
+			else
+				ReferenceRenderer::writePFM(slot->filePath, slot->dim, (const float*)slot->data, 3);
+		}
+
+		m_lastWrittenPath = slot->filePath;
+		++m_written;
+		slot->state = WRITTEN;
+	}
+}
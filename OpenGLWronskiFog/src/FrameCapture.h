@@ -0,0 +1,95 @@
+#pragma once
+#include <glad4.3/glad4.3.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*
+	Asynchronous image capture. A capture reads a framebuffer (or one layer of a texture array or 3D
+	texture) into one of a ring of pixel buffer objects, so glReadPixels() only queues a copy rather
+	than waiting for the GPU, and fences it. update(), called once per frame, maps the PBOs whose
+	fences have signalled and hands them to a writer thread, which encodes and writes the file straight
+	from the mapped buffer; once written, the next update() unmaps the PBO for reuse.
+
+	The frame loop only stalls if a capture is requested while every slot in the ring is still busy,
+	in which case it waits for the oldest one. getFrameCostMs() is the time the frame loop spent in
+	capture calls last frame, stalls included.
+*/
+
+class FrameCapture
+{
+public:
+	enum Encoding
+	{
+		PPM = 0,	// 8 bit RGB.
+		PFM			// 32 bit float RGB.
+	};
+
+	static const int c_ringSize = 4;
+
+	void init();
+	void shutdown();	// Writes out every pending capture, stops the writer thread and reports what was written.
+
+	// Rows are captured bottom first, as OpenGL stores them (the encoders flip them if needed):
+	void captureFramebuffer(GLuint fbo, GLenum readBuffer, glm::uvec2 dim, Encoding encoding, const std::string& filePath);
+	void captureTextureLayer(GLuint texture, GLint layer, glm::uvec2 dim, Encoding encoding, const std::string& filePath);
+
+	void update();		// Once per frame: hands finished reads to the writer and recycles written slots.
+
+	int		getPending() const		{ return m_pending; }			// Captures not yet written.
+	float	getFrameCostMs() const	{ return m_frameCostMs; }
+	float	getStallMs() const		{ return m_totalStallMs; }		// Total time spent waiting for a free slot.
+	int		getWritten() const		{ return m_written; }
+
+private:
+	enum State
+	{
+		FREE = 0,
+		READING,	// glReadPixels() queued, waiting on the fence.
+		WRITING,	// Mapped, with the writer thread.
+		WRITTEN		// Written, waiting to be unmapped.
+	};
+
+	struct Slot
+	{
+		GLuint				pbo = 0;
+		GLsizeiptr			capacity = 0;
+		GLsync				fence = nullptr;
+		std::atomic<int>	state{ FREE };
+		const void*			data = nullptr;	// Mapped PBO, while writing.
+
+		std::string			filePath;
+		glm::uvec2			dim;
+		Encoding			encoding;
+	};
+
+	Slot& acquireSlot(GLsizeiptr bytes);
+	void  readPixels(Slot& slot, glm::uvec2 dim, Encoding encoding, const std::string& filePath);
+	bool  advance(Slot& slot, bool wait);	// Moves a slot towards FREE, returning whether it got there.
+	void  writerMain();
+
+	Slot			m_slots[c_ringSize];
+	int				m_nextSlot = 0;
+	GLuint			m_readFBO = 0;			// For reading texture layers.
+
+	// Writer thread:
+	std::thread				m_writer;
+	std::mutex				m_queueMutex;
+	std::condition_variable	m_queueReady;
+	std::deque<Slot*>		m_queue;
+	bool					m_stopping = false;
+
+	// Stats:
+	uint64_t		m_frameCostNs = 0;		// Accumulated since the last update().
+	float			m_frameCostMs = 0.0f;
+	float			m_totalStallMs = 0.0f;
+	int				m_pending = 0;
+	std::atomic<int> m_written{ 0 };
+	std::string		m_lastWrittenPath;		// Only read once the writer thread has stopped.
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include "GLErrorManager.h"
+#include "CPUProfiler.h"
+
+/*
+	Lets the CPU run up to c_framesInFlight frames ahead of the GPU. Each frame ends with a fence;
+	beginning a frame waits on the fence of the frame that last used the same slot, so once
+	beginFrame() returns, the GPU has finished with everything that slot's per-frame data (see
+	RingBuffer) was used for, and it can be overwritten without the driver synchronising.
+*/
+
+class FramePacer
+{
+public:
+	static const GLuint c_framesInFlight = 3;
+
+	void init()
+	{
+		m_slot = 0;
+		for (GLsync& fence : m_fences)
+			fence = nullptr;
+	}
+
+	void shutdown()
+	{
+		for (GLsync& fence : m_fences)
+		{
+			if (fence)
+				glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	void beginFrame()
+	{
+		m_slot = (m_slot + 1) % c_framesInFlight;
+		m_stallMs = 0.0f;
+
+		GLsync& fence = m_fences[m_slot];
+		if (!fence)
+			return;
+
+		// Usually already signalled; only wait (flushing so the fence can signal) if the GPU is behind:
+		if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			const uint64_t startNs = CPUProfiler::now();
+			while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, c_waitTimeoutNs) == GL_TIMEOUT_EXPIRED);
+			m_stallMs = (CPUProfiler::now() - startNs) / 1000000.0f;
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	void endFrame()
+	{
+		m_fences[m_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	GLuint getSlot() const		{ return m_slot; }
+	float  getStallMs() const	{ return m_stallMs; }	// Time beginFrame() spent waiting on the GPU this frame.
+
+private:
+	static const GLuint64 c_waitTimeoutNs = 1000000;
+
+	GLsync	m_fences[c_framesInFlight] = {};
+	GLuint	m_slot = 0;
+	float	m_stallMs = 0.0f;
+};
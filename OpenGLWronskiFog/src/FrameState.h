@@ -0,0 +1,48 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+#include "LightManager.h"
+
+/*
+	Everything the GL thread needs from the simulation to render one frame. The simulation fills a
+	FrameState and publishes it whole (see Simulation), so the renderer always sees the fog, lights
+	and light matrices from the same simulation step, and never data that is half way through an
+	update. Plain data only, so snapshots can be copied between threads freely.
+*/
+
+struct FrameState
+{
+	uint64_t	step = 0;					// Simulation steps taken when this snapshot was published.
+	double		time = 0.0;					// Simulated seconds.
+
+	// Scene:
+	glm::vec3	planetPosition = glm::vec3(0.0f);
+
+	// Fog:
+	float		fogScattering = 1.0f;
+	float		fogAbsorption = 0.0f;
+	glm::vec3	fogAlbedo = glm::vec3(1.0f);
+	float		fogPhaseGParam = -0.5f;
+	float		fogDensity = 0.03f;
+	bool		useHeterogeneousFog = false;
+	bool		useHeightFog = false;
+	glm::vec2	fogHeightRange = glm::vec2(0.0f, 10.0f);	// Base height, and the height the fog thins by a factor of e over above it.
+	bool		useShadows = true;
+	bool		useTemporal = false;
+	bool		useJitter = true;
+	bool		useScreenspaceJitter = false;
+	bool		useLUT = false;
+	bool		hooblerOrKovalovs = false;
+	bool		linearOrExpFroxels = false;
+	int			shadowMapTechnique = 0;
+
+	// Noise:
+	float		noiseFreq = 0.15f;
+	glm::vec3	noiseOffset = glm::vec3(0.0f);
+
+	// Lights:
+	float		lightIntensity = 1.0f;
+	LightManager	lights;					// Settings, and cube face matrices built by the simulation.
+};
@@ -0,0 +1,182 @@
+#include "FroxelBricks.h"
+
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "FogRenderer.h"
+#include "GPUResourceRegistry.h"
+
+// Storage buffer layouts, matching froxelBrickClassifyShader.comp (std430):
+struct FreeListHeader
+{
+	GLint	count;
+};
+struct ActiveListHeader
+{
+	GLuint	numGroupsX, numGroupsY, numGroupsZ;	// Indirect dispatch arguments, with one group per brick.
+	GLuint	padding;
+};
+
+void FroxelBricks::init(glm::uvec3 gridSize)
+{
+	m_gridSize = gridSize;
+	m_cellGrid = (gridSize + glm::uvec3(c_brickFootprint - 1)) / glm::uvec3(c_brickFootprint);
+
+	// No cell has a brick to begin with:
+	const std::vector<GLint> noBricks((size_t)m_cellGrid.x * m_cellGrid.y * m_cellGrid.z, -1);
+	glGenTextures(1, &m_table);
+	glBindTexture(GL_TEXTURE_3D, m_table);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_R32I, m_cellGrid.x, m_cellGrid.y, m_cellGrid.z, 0, GL_RED_INTEGER, GL_INT, noBricks.data());
+	GPUResourceRegistry::registerTexture(m_table, GPUResourceRegistry::FROXELS, "Froxel brick table", GL_R32I, m_cellGrid);
+
+	// Bricks are filtered within, and never across their edges, which clamping keeps to the atlas' own:
+	const GLuint atlasSize = c_atlasBricks * c_brickResolution;
+	glGenTextures(1, &m_atlas);
+	glBindTexture(GL_TEXTURE_3D, m_atlas);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, atlasSize, atlasSize, atlasSize, 0, GL_RGBA, GL_FLOAT, NULL);
+	GPUResourceRegistry::registerTexture(m_atlas, GPUResourceRegistry::FROXELS, "Froxel brick atlas", GL_RGBA16F, glm::uvec3(atlasSize));
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	// Every brick starts out free:
+	std::vector<GLint> freeList(1 + c_maxBricks);
+	freeList[0] = c_maxBricks;
+	std::iota(freeList.begin() + 1, freeList.end(), 0);
+	glGenBuffers(1, &m_freeList);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_freeList);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, freeList.size() * sizeof(GLint), freeList.data(), GL_DYNAMIC_DRAW);
+	GPUResourceRegistry::registerBuffer(m_freeList, GPUResourceRegistry::FROXELS, "Froxel brick free list", freeList.size() * sizeof(GLint));
+
+	const GLsizeiptr activeListBytes = sizeof(ActiveListHeader) + c_maxBricks * sizeof(glm::uvec4);
+	glGenBuffers(1, &m_activeList);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_activeList);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, activeListBytes, NULL, GL_DYNAMIC_DRAW);
+	GPUResourceRegistry::registerBuffer(m_activeList, GPUResourceRegistry::FROXELS, "Froxel brick active list", activeListBytes);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// The number of bricks in use is read back a few frames late, so it never waits on the GPU:
+	for (GLuint i = 0; i < GPUTimer::c_framesInFlight; ++i)
+	{
+		glGenBuffers(1, &m_countReadback[i]);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_countReadback[i]);
+		glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint), NULL, GL_STREAM_READ);
+		GPUResourceRegistry::registerBuffer(m_countReadback[i], GPUResourceRegistry::FROXELS, "Froxel brick count readback " + std::to_string(i), sizeof(GLuint));
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	m_frame = 0;
+	m_bricksInUse = 0;
+}
+
+void FroxelBricks::release()
+{
+	GPUResourceRegistry::deleteTexture(m_table);
+	GPUResourceRegistry::deleteTexture(m_atlas);
+	GPUResourceRegistry::deleteBuffer(m_freeList);
+	GPUResourceRegistry::deleteBuffer(m_activeList);
+	for (GLuint i = 0; i < GPUTimer::c_framesInFlight; ++i)
+		GPUResourceRegistry::deleteBuffer(m_countReadback[i]);
+
+	m_gridSize = m_cellGrid = glm::uvec3(0);
+}
+
+void FroxelBricks::classify(const Shader& classifyShader)
+{
+	// The copy made c_framesInFlight - 1 frames ago is in this frame's slot:
+	const GLuint slot = m_frame % GPUTimer::c_framesInFlight;
+	if (m_frame >= GPUTimer::c_framesInFlight)
+	{
+		GLuint bricksInUse = 0;
+		glBindBuffer(GL_COPY_READ_BUFFER, m_countReadback[slot]);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(GLuint), &bricksInUse);
+		m_bricksInUse = (int)bricksInUse;
+	}
+	++m_frame;
+
+	// The active list is rebuilt from scratch:
+	const ActiveListHeader emptyList = { 0, 1, 1, 0 };
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_activeList);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(emptyList), &emptyList);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	FogRenderer::bindImage(0, m_table, GL_READ_WRITE, GL_R32I);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_freeList);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_activeList);
+
+	classifyShader.use();
+	setUniforms(classifyShader);
+	const glm::uvec3 numGroups = (m_cellGrid + glm::uvec3(c_groupSize - 1)) / glm::uvec3(c_groupSize);
+
+	// Pushing freed bricks and popping them again in the same dispatch would race, so they're separate passes:
+	classifyShader.setBool("u_allocate", false);
+	FogRenderer::dispatch(numGroups, classifyShader);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	classifyShader.setBool("u_allocate", true);
+	FogRenderer::dispatch(numGroups, classifyShader);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, m_activeList);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_countReadback[slot]);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLuint));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void FroxelBricks::dispatchFill(const Shader& scatterShader) const
+{
+	scatterShader.use();
+	setUniforms(scatterShader);
+	scatterShader.setBool("u_fillBricks", true);
+
+	FogRenderer::bindImage(5, m_atlas, GL_WRITE_ONLY, GL_RGBA16F);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_activeList);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_activeList);
+	GLCALL(glDispatchComputeIndirect(0));
+
+	scatterShader.setBool("u_fillBricks", false);
+
+	// Accumulated in place next:
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
+void FroxelBricks::dispatchAccumulation(const Shader& accumShader) const
+{
+	accumShader.use();
+	setUniforms(accumShader);
+
+	FogRenderer::bindImage(5, m_atlas, GL_READ_WRITE, GL_RGBA16F);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_activeList);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_activeList);
+	GLCALL(glDispatchComputeIndirect(0));
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+	// The composite samples the atlas next:
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void FroxelBricks::bind(const Shader& shader, GLuint firstUnit) const
+{
+	shader.use();
+	setUniforms(shader);
+
+	glActiveTexture(GL_TEXTURE0 + firstUnit);
+	glBindTexture(GL_TEXTURE_3D, m_table);
+	glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+	glBindTexture(GL_TEXTURE_3D, m_atlas);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void FroxelBricks::setUniforms(const Shader& shader) const
+{
+	// A cell's extent in froxel UVW coordinates (the last cells may reach past the frustum):
+	shader.setVec3("u_brickCellSize", glm::vec3(c_brickFootprint) / glm::vec3(m_gridSize));
+	shader.setVec3("u_brickCellGrid", glm::vec3(m_cellGrid));
+}
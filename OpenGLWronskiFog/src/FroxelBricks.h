@@ -0,0 +1,65 @@
+#pragma once
+#include <glad4.3/glad4.3.h>
+#include <glm/glm.hpp>
+
+#include "GPUTimer.h"
+#include "Shader.h"
+
+/*
+	Sparse refinement of the froxel grid. The frustum is divided into brick cells of c_brickFootprint
+	froxels of the full resolution grid per side (in froxel UVW, so across all cascades), and cells
+	that a light's sphere or a steep density gradient crosses are given a brick of c_brickResolution
+	texels per side, evaluated at about twice the grid's resolution. Everywhere else, the cascades are
+	all there is.
+
+	Which cells need a brick is worked out on the GPU each frame. Bricks stay with their cell while it
+	needs one, and are otherwise returned to a free list that new cells take theirs from, so neither
+	the allocation nor the list of bricks to evaluate ever comes back to the CPU. When the free list
+	runs dry, cells go without and the cascades show through.
+
+	A brick's texels sit on its cell's corners and edges, so neighbouring bricks share their boundary
+	samples and can be filtered by the hardware without an apron. Accumulated, each brick starts from
+	the cascades' value at its front face.
+*/
+
+class FroxelBricks
+{
+public:
+	static const int c_brickFootprint = 4;		// Froxels of the full resolution grid per cell side.
+	static const int c_brickResolution = 8;		// Texels per brick side, boundaries included.
+	static const int c_groupSize = 4;			// Local size of froxelBrickClassifyShader.comp in each dimension.
+	static const int c_atlasBricks = 8;			// Bricks per atlas side.
+	static const int c_maxBricks = c_atlasBricks * c_atlasBricks * c_atlasBricks;
+
+	void init(glm::uvec3 gridSize);
+	void release();
+
+	// Frees the bricks of cells that no longer need them, then gives them to cells that newly do (the classify
+	// shader's fog and light uniforms must already be set):
+	void classify(const Shader& classifyShader);
+
+	// Evaluates every allocated brick's scattering and extinction with the scatter shader, then accumulates
+	// them in place, starting from the accumulated cascades bound for the accumulation shader:
+	void dispatchFill(const Shader& scatterShader) const;
+	void dispatchAccumulation(const Shader& accumShader) const;
+
+	// Binds the brick table and atlas to two consecutive texture units, and sets a shader's brick uniforms:
+	void bind(const Shader& shader, GLuint firstUnit) const;
+	void setUniforms(const Shader& shader) const;
+
+	bool		isAllocated() const			{ return m_table != 0; }
+	glm::uvec3	getCellGrid() const			{ return m_cellGrid; }
+	int			getBricksInUse() const		{ return m_bricksInUse; }	// A few frames old.
+
+private:
+	GLuint		m_table = 0;			// R32I per cell: its brick, or negative without one.
+	GLuint		m_atlas = 0;			// RGBA16F, c_atlasBricks bricks per side.
+	GLuint		m_freeList = 0;			// Count and stack of free bricks.
+	GLuint		m_activeList = 0;		// Indirect dispatch arguments (one group per brick), then each brick's cell and index.
+	GLuint		m_countReadback[GPUTimer::c_framesInFlight] = {};
+
+	glm::uvec3	m_gridSize = glm::uvec3(0);
+	glm::uvec3	m_cellGrid = glm::uvec3(0);
+	GLuint		m_frame = 0;
+	int			m_bricksInUse = 0;
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+#include "GPUTimer.h"
+
+/*
+	Scales the froxel grid's XY resolution to hold the fog passes within a GPU time budget. Pass
+	times are smoothed, and only acted on outside a band below the budget, so the grid isn't
+	reallocated back and forth every few frames. Cost is taken to go with the number of froxels, the
+	square of the scale, with each step clamped as fixed costs make that an overestimate.
+
+	GPU timings are c_framesInFlight frames old when read back, so after each change the
+	controller waits for timings of frames rendered at the new resolution before judging it.
+*/
+
+class FroxelBudget
+{
+public:
+	static constexpr float c_minScale = 0.25f;
+	static constexpr float c_growThreshold = 0.75f;	// Fraction of the budget under which the grid grows again.
+	static constexpr float c_targetFraction = 0.9f;	// Where in that band a change aims for.
+	static constexpr float c_maxStep = 0.25f;		// Largest relative change to the scale at once.
+	static constexpr float c_smoothing = 0.1f;
+	static const int	   c_settleFrames = GPUTimer::c_framesInFlight + 2;
+	static const int	   c_minSamples = 16;
+
+	void reset()
+	{
+		m_settleFrames = c_settleFrames;
+		m_samples = 0;
+	}
+
+	// Feeds one frame's fog pass time (negative if there isn't one), and returns whether the scale was changed:
+	bool update(float fogMs, float budgetMs, float& scale)
+	{
+		if (fogMs < 0.0f || budgetMs <= 0.0f)
+			return false;
+
+		// Skip timings of frames rendered before the last change:
+		if (m_settleFrames > 0)
+		{
+			--m_settleFrames;
+			return false;
+		}
+
+		m_smoothedMs = m_samples == 0 ? fogMs : m_smoothedMs + c_smoothing * (fogMs - m_smoothedMs);
+		if (++m_samples < c_minSamples)
+			return false;
+
+		const bool overBudget = m_smoothedMs > budgetMs;
+		const bool underBudget = m_smoothedMs < c_growThreshold * budgetMs && scale < 1.0f;
+		if (!overBudget && !underBudget)
+			return false;
+
+		float target = scale * std::sqrt(c_targetFraction * budgetMs / m_smoothedMs);
+		target = std::min(std::max(target, scale * (1.0f - c_maxStep)), scale * (1.0f + c_maxStep));
+		target = std::min(std::max(target, c_minScale), 1.0f);
+
+		// Already as small (or as large) as it goes:
+		if (std::abs(target - scale) < 0.01f)
+			return false;
+
+		scale = target;
+		reset();
+		return true;
+	}
+
+	float getSmoothedMs() const	{ return m_samples > 0 ? m_smoothedMs : 0.0f; }
+
+private:
+	float m_smoothedMs = 0.0f;
+	int	  m_samples = 0;
+	int	  m_settleFrames = c_settleFrames;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <csignal>
 #include <iostream>
 
 #include <glad4.3/glad4.3.h>
@@ -18,7 +19,11 @@ class GLErrorManager
 {
 public:
 	// Break if errors occur:
+#ifdef _MSC_VER
 	#define ASSERT(x) if (!(x)) __debugbreak();
+#else
+	#define ASSERT(x) if (!(x)) std::raise(SIGTRAP);
+#endif
 
 	// Output error code, file with error-causing code and line number:
 	#define GLCALL(x) GLErrorManager::GLClearError(); x; ASSERT(GLErrorManager::GLLogCall(#x, __FILE__, __LINE__))
@@ -7,5 +7,5 @@ public:
 	virtual void bind() const = 0;
 	virtual void unbind() const = 0;
 protected:
-	GLuint m_handle;
+	GLuint m_handle = 0;
 };
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "GPUResourceRegistry.h"
+
+#include <iomanip>
+#include <iostream>
+
+static const uint64_t c_MB = 1024 * 1024;
+
+std::map<uint64_t, GPUResourceRegistry::Resource> GPUResourceRegistry::s_resources;
+uint64_t GPUResourceRegistry::s_tagBytes[NUM_TAGS] = {};
+uint64_t GPUResourceRegistry::s_budgets[NUM_TAGS] = {
+	768 * c_MB,		// Shadows (three 1024x1024x24 RG32F arrays plus depth).
+	64 * c_MB,		// Froxels
+	32 * c_MB,		// LUTs
+	128 * c_MB,		// Meshes
+	128 * c_MB,		// Render targets
+	16 * c_MB		// Misc
+};
+
+void GPUResourceRegistry::registerTexture(GLuint handle, Tag tag, const std::string& name, GLenum format, glm::uvec3 dim, bool mipmapped)
+{
+	uint64_t bytes = (uint64_t)dim.x * dim.y * dim.z * getBytesPerTexel(format);
+
+	// A full mip chain adds roughly a third:
+	if (mipmapped)
+		bytes += bytes / 3;
+
+	add({ TEXTURE, handle, tag, name, format, dim, bytes });
+}
+
+void GPUResourceRegistry::registerBuffer(GLuint handle, Tag tag, const std::string& name, uint64_t bytes)
+{
+	add({ BUFFER, handle, tag, name, GL_NONE, glm::uvec3((GLuint)bytes, 1, 1), bytes });
+}
+
+void GPUResourceRegistry::registerRenderbuffer(GLuint handle, Tag tag, const std::string& name, GLenum format, glm::uvec2 dim)
+{
+	const uint64_t bytes = (uint64_t)dim.x * dim.y * getBytesPerTexel(format);
+	add({ RENDERBUFFER, handle, tag, name, format, glm::uvec3(dim, 1), bytes });
+}
+
+void GPUResourceRegistry::deleteTexture(GLuint& handle)
+{
+	if (!handle)
+		return;
+
+	remove(TEXTURE, handle);
+	glDeleteTextures(1, &handle);
+	handle = 0;
+}
+
+void GPUResourceRegistry::deleteBuffer(GLuint& handle)
+{
+	if (!handle)
+		return;
+
+	remove(BUFFER, handle);
+	glDeleteBuffers(1, &handle);
+	handle = 0;
+}
+
+void GPUResourceRegistry::deleteRenderbuffer(GLuint& handle)
+{
+	if (!handle)
+		return;
+
+	remove(RENDERBUFFER, handle);
+	glDeleteRenderbuffers(1, &handle);
+	handle = 0;
+}
+
+uint64_t GPUResourceRegistry::getTotalBytes()
+{
+	uint64_t total = 0;
+	for (uint64_t bytes : s_tagBytes)
+		total += bytes;
+	return total;
+}
+
+const char* GPUResourceRegistry::getTagName(Tag tag)
+{
+	switch (tag)
+	{
+	case SHADOWS:			return "Shadows";
+	case FROXELS:			return "Froxels";
+	case LUTS:				return "LUTs";
+	case MESHES:			return "Meshes";
+	case RENDER_TARGETS:	return "Render targets";
+	case MISC:
+	default:				return "Misc";
+	}
+}
+
+const char* GPUResourceRegistry::getTypeName(Type type)
+{
+	switch (type)
+	{
+	case TEXTURE:		return "texture";
+	case BUFFER:		return "buffer";
+	case RENDERBUFFER:
+	default:			return "renderbuffer";
+	}
+}
+
+GLuint GPUResourceRegistry::getBytesPerTexel(GLenum format)
+{
+	switch (format)
+	{
+	case GL_RED:
+	case GL_R8:
+		return 1;
+	case GL_RG:
+	case GL_RG8:
+	case GL_R16F:
+	case GL_DEPTH_COMPONENT16:
+		return 2;
+	case GL_RGB:	// Padded to RGBA8.
+	case GL_RGB8:
+	case GL_RGBA:
+	case GL_RGBA8:
+	case GL_RG16F:
+	case GL_R32F:
+	case GL_R32I:
+	case GL_R11F_G11F_B10F:
+	case GL_DEPTH_COMPONENT:	// Typically 24-bit depth, padded to 32.
+	case GL_DEPTH_COMPONENT24:
+	case GL_DEPTH_COMPONENT32F:
+	case GL_DEPTH24_STENCIL8:
+		return 4;
+	case GL_RGB16F:	// Padded to RGBA16F.
+	case GL_RGBA16F:
+	case GL_RG32F:
+	case GL_DEPTH32F_STENCIL8:
+		return 8;
+	case GL_RGB32F:
+		return 12;
+	case GL_RGBA32F:
+		return 16;
+	default:
+		std::cout << "GPU RESOURCE ERROR: Unknown texture format " << format << ", assuming 4 bytes per texel." << std::endl;
+		return 4;
+	}
+}
+
+void GPUResourceRegistry::printSummary()
+{
+	std::cout << "GPU memory by subsystem:" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (int i = 0; i < NUM_TAGS; ++i)
+		std::cout << "\t" << std::left << std::setw(16) << getTagName((Tag)i) << std::right << std::setw(10) << (double)s_tagBytes[i] / c_MB
+			<< " MB (budget " << (double)s_budgets[i] / c_MB << " MB)" << (isOverBudget((Tag)i) ? " OVER BUDGET" : "") << std::endl;
+	std::cout << "\t" << std::left << std::setw(16) << "Total" << std::right << std::setw(10) << (double)getTotalBytes() / c_MB << " MB" << std::endl;
+	std::cout << std::defaultfloat;
+}
+
+size_t GPUResourceRegistry::reportLeaks()
+{
+	for (const auto& entry : s_resources)
+	{
+		const Resource& resource = entry.second;
+		std::cout << "GPU RESOURCE LEAK: " << getTagName(resource.tag) << " " << getTypeName(resource.type) << " " << resource.handle
+			<< " \"" << resource.name << "\" (" << resource.bytes << " bytes)" << std::endl;
+	}
+
+	if (s_resources.empty())
+		std::cout << "No GPU resources leaked." << std::endl;
+	else
+		std::cout << s_resources.size() << " GPU resources leaked." << std::endl;
+
+	return s_resources.size();
+}
+
+void GPUResourceRegistry::add(const Resource& resource)
+{
+	const uint64_t key = getKey(resource.type, resource.handle);
+	if (s_resources.count(key))
+	{
+		std::cout << "GPU RESOURCE ERROR: " << getTypeName(resource.type) << " " << resource.handle << " (\"" << resource.name
+			<< "\") registered twice, replacing \"" << s_resources[key].name << "\"." << std::endl;
+		remove(resource.type, resource.handle);
+	}
+
+	const bool wasOverBudget = isOverBudget(resource.tag);
+	s_resources[key] = resource;
+	s_tagBytes[resource.tag] += resource.bytes;
+
+	// Report each crossing of a budget once, naming the allocation that crossed it:
+	if (!wasOverBudget && isOverBudget(resource.tag))
+		std::cout << "GPU MEMORY BUDGET ERROR: " << getTagName(resource.tag) << " exceeded its " << s_budgets[resource.tag] / c_MB
+			<< " MB budget allocating \"" << resource.name << "\" (" << s_tagBytes[resource.tag] / c_MB << " MB in use)." << std::endl;
+}
+
+void GPUResourceRegistry::remove(Type type, GLuint handle)
+{
+	auto it = s_resources.find(getKey(type, handle));
+	if (it == s_resources.end())
+	{
+		std::cout << "GPU RESOURCE ERROR: Releasing untracked " << getTypeName(type) << " " << handle << std::endl;
+		return;
+	}
+
+	s_tagBytes[it->second.tag] -= it->second.bytes;
+	s_resources.erase(it);
+}
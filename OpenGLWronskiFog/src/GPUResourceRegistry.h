@@ -0,0 +1,84 @@
+#pragma once
+#include <glad4.3/glad4.3.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/*
+	Tracks every texture, buffer and renderbuffer the application allocates, with its format,
+	dimensions and estimated size in bytes, grouped by the subsystem that owns it. Each subsystem
+	has a memory budget; crossing it is reported on the console and highlighted in the UI. Anything
+	still registered when reportLeaks() is called at shutdown was never released.
+
+	Sizes are estimates (drivers add padding and alignment of their own): unsized formats assume 8
+	bits per channel, three channel formats are padded to four and mipmapped textures add a third.
+*/
+
+class GPUResourceRegistry
+{
+public:
+	enum Tag
+	{
+		SHADOWS = 0,
+		FROXELS,
+		LUTS,
+		MESHES,
+		RENDER_TARGETS,
+		MISC,
+		NUM_TAGS
+	};
+
+	enum Type
+	{
+		TEXTURE = 0,
+		BUFFER,
+		RENDERBUFFER
+	};
+
+	struct Resource
+	{
+		Type		type;
+		GLuint		handle;
+		Tag			tag;
+		std::string name;
+		GLenum		format;		// Internal format (textures and renderbuffers only).
+		glm::uvec3	dim;		// Texels, or (bytes, 1, 1) for buffers.
+		uint64_t	bytes;
+	};
+
+	// Registration, called straight after the resource's storage is allocated:
+	static void registerTexture(GLuint handle, Tag tag, const std::string& name, GLenum format, glm::uvec3 dim, bool mipmapped = false);
+	static void registerBuffer(GLuint handle, Tag tag, const std::string& name, uint64_t bytes);
+	static void registerRenderbuffer(GLuint handle, Tag tag, const std::string& name, GLenum format, glm::uvec2 dim);
+
+	// Deletes the OpenGL object, unregisters it and zeroes the handle:
+	static void deleteTexture(GLuint& handle);
+	static void deleteBuffer(GLuint& handle);
+	static void deleteRenderbuffer(GLuint& handle);
+
+	static void		setBudget(Tag tag, uint64_t bytes)	{ s_budgets[tag] = bytes; }
+	static uint64_t getBudget(Tag tag)					{ return s_budgets[tag]; }
+	static uint64_t getTagBytes(Tag tag)				{ return s_tagBytes[tag]; }
+	static bool		isOverBudget(Tag tag)				{ return s_tagBytes[tag] > s_budgets[tag]; }
+	static uint64_t getTotalBytes();
+
+	static const std::map<uint64_t, Resource>& getResources() { return s_resources; }
+
+	static const char*	getTagName(Tag tag);
+	static const char*	getTypeName(Type type);
+	static GLuint		getBytesPerTexel(GLenum format);
+
+	static void		printSummary();		// Per-subsystem totals against their budgets.
+	static size_t	reportLeaks();		// Lists every resource still registered, returning how many there are.
+
+private:
+	static uint64_t getKey(Type type, GLuint handle) { return ((uint64_t)type << 32) | handle; }
+	static void		add(const Resource& resource);
+	static void		remove(Type type, GLuint handle);
+
+	static std::map<uint64_t, Resource> s_resources;	// Ordered, so reports list resources by type then handle.
+	static uint64_t						s_tagBytes[NUM_TAGS];
+	static uint64_t						s_budgets[NUM_TAGS];
+};
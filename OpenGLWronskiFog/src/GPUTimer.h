@@ -0,0 +1,157 @@
+#pragma once
+#include "GLErrorManager.h"
+
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+/*
+	Times GPU work with GL_TIMESTAMP queries. Each frame's queries are only read back once the
+	same query slot comes round again (c_framesInFlight frames later), so reading results never
+	stalls the pipeline. Scopes may be nested; each is reported under its own name.
+*/
+
+class GPUTimer
+{
+public:
+	struct ScopeResult
+	{
+		const char* name;
+		float		ms;
+	};
+
+	struct FrameResults
+	{
+		int64_t					 tag;	// User value passed to beginFrame(), e.g. the benchmark run this frame belongs to.
+		std::vector<ScopeResult> scopes;
+	};
+
+	static const GLuint c_framesInFlight = 4;
+	static const GLuint c_maxScopes = 32;
+
+	void init()
+	{
+		for (Frame& frame : m_frames)
+		{
+			glGenQueries(2 * c_maxScopes, frame.queries);
+			frame.pending = false;
+		}
+		m_initialised = true;
+	}
+
+	void shutdown()
+	{
+		if (!m_initialised)
+			return;
+
+		for (Frame& frame : m_frames)
+			glDeleteQueries(2 * c_maxScopes, frame.queries);
+		m_initialised = false;
+	}
+
+	void beginFrame(int64_t tag)
+	{
+		m_currentFrame = (m_currentFrame + 1) % c_framesInFlight;
+		Frame& frame = m_frames[m_currentFrame];
+
+		// Read back this slot's results from c_framesInFlight frames ago before reusing its queries:
+		if (frame.pending)
+			resolve(frame);
+
+		frame.tag = tag;
+		frame.scopeNames.clear();
+		frame.pending = true;
+		m_scopeStack.clear();
+	}
+
+	void begin(const char* name)
+	{
+		Frame& frame = m_frames[m_currentFrame];
+		if (frame.scopeNames.size() >= c_maxScopes)
+			return;
+
+		glQueryCounter(frame.queries[2 * frame.scopeNames.size()], GL_TIMESTAMP);
+		m_scopeStack.push_back((GLuint)frame.scopeNames.size());
+		frame.scopeNames.push_back(name);
+	}
+
+	void end()
+	{
+		if (m_scopeStack.empty())
+			return;
+
+		Frame& frame = m_frames[m_currentFrame];
+		glQueryCounter(frame.queries[2 * m_scopeStack.back() + 1], GL_TIMESTAMP);
+		m_scopeStack.pop_back();
+	}
+
+	// Blocks until every outstanding frame has been read back (used when a benchmark finishes):
+	void flush()
+	{
+		for (GLuint i = 1; i <= c_framesInFlight; ++i)
+		{
+			Frame& frame = m_frames[(m_currentFrame + i) % c_framesInFlight];
+			if (frame.pending)
+				resolve(frame);
+		}
+	}
+
+	// Returns the oldest frame of results that hasn't been consumed yet, if there is one:
+	bool popResults(FrameResults& results)
+	{
+		if (m_results.empty())
+			return false;
+
+		results = std::move(m_results.front());
+		m_results.pop_front();
+		return true;
+	}
+
+	// The named scope's time in the most recently read back frame, or a negative value if it wasn't timed:
+	float getLatestMs(const char* name) const
+	{
+		for (const ScopeResult& scope : m_latest.scopes)
+			if (strcmp(scope.name, name) == 0)
+				return scope.ms;
+		return -1.0f;
+	}
+
+private:
+	struct Frame
+	{
+		GLuint					 queries[2 * c_maxScopes];
+		std::vector<const char*> scopeNames;
+		int64_t					 tag;
+		bool					 pending;
+	};
+
+	void resolve(Frame& frame)
+	{
+		FrameResults results;
+		results.tag = frame.tag;
+
+		for (size_t i = 0; i < frame.scopeNames.size(); ++i)
+		{
+			GLuint64 start, end;
+			glGetQueryObjectui64v(frame.queries[2 * i], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(frame.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+			results.scopes.push_back({ frame.scopeNames[i], (end - start) / 1000000.0f });
+		}
+		frame.pending = false;
+
+		m_latest = results;
+		m_results.push_back(std::move(results));
+
+		// Don't let unconsumed results grow without bound:
+		if (m_results.size() > 64 * c_framesInFlight)
+			m_results.pop_front();
+	}
+
+	Frame					 m_frames[c_framesInFlight];
+	GLuint					 m_currentFrame = 0;
+	std::vector<GLuint>		 m_scopeStack;
+	std::deque<FrameResults> m_results;
+	FrameResults			 m_latest;
+	bool					 m_initialised = false;
+};
@@ -0,0 +1,146 @@
+#include "HeadlessContext.h"
+
+#include <iostream>
+
+#ifdef HEADLESS_CONTEXT_USE_EGL
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+bool HeadlessContext::init(GLuint versionMajor, GLuint versionMinor)
+{
+	// Prefer Mesa's surfaceless platform, which needs no display server or DRM device:
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+	{
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		m_description = "EGL (surfaceless)";
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		m_description = "EGL (default display)";
+	}
+
+	EGLint eglMajor, eglMinor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &eglMajor, &eglMinor))
+	{
+		std::cout << "HEADLESS CONTEXT ERROR: Couldn't initialise an EGL display (error 0x" << std::hex << eglGetError() << std::dec << ")." << std::endl;
+		return false;
+	}
+	m_display = display;
+
+	// Desktop OpenGL rather than OpenGL ES:
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "HEADLESS CONTEXT ERROR: EGL display doesn't support desktop OpenGL." << std::endl;
+		shutdown();
+		return false;
+	}
+
+	// No surface will be created, so any OpenGL config will do (or none at all, if the driver allows it):
+	const EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+	EGLint numConfigs = 0;
+	eglChooseConfig(display, configAttribs, &config, 1, &numConfigs);
+
+	const EGLint contextAttribs[] = { EGL_CONTEXT_MAJOR_VERSION, (EGLint)versionMajor,
+									  EGL_CONTEXT_MINOR_VERSION, (EGLint)versionMinor,
+									  EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+									  EGL_NONE };
+	EGLContext context = eglCreateContext(display, numConfigs ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cout << "HEADLESS CONTEXT ERROR: Couldn't create an OpenGL " << versionMajor << "." << versionMinor << " core context (error 0x" << std::hex << eglGetError() << std::dec << ")." << std::endl;
+		shutdown();
+		return false;
+	}
+	m_context = context;
+
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		std::cout << "HEADLESS CONTEXT ERROR: Couldn't make the context current without a surface." << std::endl;
+		shutdown();
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		std::cout << "Failed to initialise GLAD.\n";
+		shutdown();
+		return false;
+	}
+
+	m_created = true;
+	std::cout << "Created headless " << m_description << " context!\nOpenGL version: " << glGetString(GL_VERSION)
+		<< "\nRenderer: " << glGetString(GL_RENDERER) << "\n\n";
+	return true;
+}
+
+void HeadlessContext::shutdown()
+{
+	if (!m_display)
+		return;
+
+	eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (m_context)
+		eglDestroyContext(m_display, m_context);
+	eglTerminate(m_display);
+
+	m_display = nullptr;
+	m_context = nullptr;
+	m_created = false;
+}
+
+#else
+
+bool HeadlessContext::init(GLuint versionMajor, GLuint versionMinor)
+{
+	if (!glfwInit())
+	{
+		std::cout << "Failed to initialise GLFW.\n";
+		return false;
+	}
+
+	// A window that's never shown, just to own the context:
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, versionMajor);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, versionMinor);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	m_window = glfwCreateWindow(1, 1, "WronskiFog (headless)", NULL, NULL);
+	if (!m_window)
+	{
+		std::cout << "HEADLESS CONTEXT ERROR: Couldn't create a hidden GLFW window." << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(m_window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialise GLAD.\n";
+		shutdown();
+		return false;
+	}
+
+	m_created = true;
+	m_description = "hidden GLFW window";
+	std::cout << "Created headless " << m_description << " context!\nOpenGL version: " << glGetString(GL_VERSION)
+		<< "\nRenderer: " << glGetString(GL_RENDERER) << "\n\n";
+	return true;
+}
+
+void HeadlessContext::shutdown()
+{
+	if (!m_window)
+		return;
+
+	glfwDestroyWindow(m_window);
+	glfwTerminate();
+
+	m_window = nullptr;
+	m_created = false;
+}
+
+#endif
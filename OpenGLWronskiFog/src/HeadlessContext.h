@@ -0,0 +1,39 @@
+#pragma once
+#include <glad4.3/glad4.3.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+
+// Linux hosts may have no display server (or GPU) at all, so use surfaceless EGL there, which Mesa's
+// llvmpipe/softpipe drivers provide. Elsewhere, or with HEADLESS_CONTEXT_USE_GLFW defined, a hidden
+// GLFW window stands in:
+#if defined(__linux__) && !defined(HEADLESS_CONTEXT_USE_GLFW)
+#define HEADLESS_CONTEXT_USE_EGL
+#endif
+
+/*
+	An OpenGL context with no visible window, for rendering offscreen. init() makes it current on the
+	calling thread and loads GLAD, just as App::initWindow() does for a window.
+
+	A surfaceless context has no default framebuffer, so everything has to be drawn to FBOs.
+*/
+
+class HeadlessContext
+{
+public:
+	bool init(GLuint versionMajor, GLuint versionMinor);
+	void shutdown();
+
+	bool			   isCreated() const		{ return m_created; }
+	const std::string& getDescription() const	{ return m_description; }	// Which kind of context was created.
+
+private:
+#ifdef HEADLESS_CONTEXT_USE_EGL
+	void*		m_display = nullptr;	// EGLDisplay (EGL headers stay in the .cpp, as they can pull in X11).
+	void*		m_context = nullptr;	// EGLContext
+#else
+	GLFWwindow* m_window = nullptr;
+#endif
+	bool		m_created = false;
+	std::string m_description;
+};
@@ -0,0 +1,228 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/*
+	Full-reference image error metrics, used to score the real-time fog against the CPU reference
+	renderer. Images are display-encoded RGB (gamma 2.2, as the fog composite writes them) in
+	[0, 1], stored row by row, and must share the same dimensions. No OpenGL calls are made.
+
+	- RMSE: root mean squared error over all three channels.
+	- SSIM: mean structural similarity of luminance over 8x8 windows (stride 4), 1 is identical.
+	- FLIP: a simplified take on NVIDIA's FLIP, in [0, 1] with 0 identical. Both images are taken to
+	  CIELAB and low-pass filtered to stand in for the eye's contrast sensitivity, compared with the
+	  HyAB colour distance and remapped so small differences are compressed, then amplified where
+	  edges or points in the luminance differ. It skips FLIP's per-channel opponent-space filters and
+	  Hunt adjustment, so scores are comparable with each other but not with published FLIP values.
+*/
+
+class ImageMetrics
+{
+public:
+	struct Scores
+	{
+		float rmse;
+		float ssim;
+		float flip;
+	};
+
+	static Scores compare(const std::vector<glm::vec3>& test, const std::vector<glm::vec3>& reference, glm::uvec2 dim)
+	{
+		return { computeRMSE(test, reference), computeSSIM(test, reference, dim), computeFLIP(test, reference, dim) };
+	}
+
+	static float computeRMSE(const std::vector<glm::vec3>& test, const std::vector<glm::vec3>& reference)
+	{
+		double sum = 0.0;
+		for (size_t i = 0; i < test.size(); ++i)
+		{
+			const glm::vec3 diff = glm::clamp(test[i], 0.0f, 1.0f) - glm::clamp(reference[i], 0.0f, 1.0f);
+			sum += glm::dot(diff, diff);
+		}
+		return test.empty() ? 0.0f : (float)std::sqrt(sum / (3.0 * test.size()));
+	}
+
+	static float computeSSIM(const std::vector<glm::vec3>& test, const std::vector<glm::vec3>& reference, glm::uvec2 dim)
+	{
+		const unsigned int window = 8, stride = 4;
+		const double c1 = 0.01 * 0.01, c2 = 0.03 * 0.03;	// (k * dynamic range)^2 with a range of 1.
+
+		const std::vector<float> testLuma = getLuminance(test);
+		const std::vector<float> referenceLuma = getLuminance(reference);
+
+		double sum = 0.0;
+		size_t count = 0;
+		for (unsigned int y = 0; y + window <= dim.y; y += stride)
+		{
+			for (unsigned int x = 0; x + window <= dim.x; x += stride)
+			{
+				double meanA = 0.0, meanB = 0.0, varA = 0.0, varB = 0.0, covariance = 0.0;
+				for (unsigned int j = 0; j < window; ++j)
+				{
+					for (unsigned int i = 0; i < window; ++i)
+					{
+						const size_t index = (size_t)(y + j) * dim.x + x + i;
+						meanA += testLuma[index];
+						meanB += referenceLuma[index];
+					}
+				}
+				meanA /= window * window;
+				meanB /= window * window;
+
+				for (unsigned int j = 0; j < window; ++j)
+				{
+					for (unsigned int i = 0; i < window; ++i)
+					{
+						const size_t index = (size_t)(y + j) * dim.x + x + i;
+						const double a = testLuma[index] - meanA, b = referenceLuma[index] - meanB;
+						varA += a * a;
+						varB += b * b;
+						covariance += a * b;
+					}
+				}
+				varA /= window * window - 1;
+				varB /= window * window - 1;
+				covariance /= window * window - 1;
+
+				sum += ((2.0 * meanA * meanB + c1) * (2.0 * covariance + c2)) / ((meanA * meanA + meanB * meanB + c1) * (varA + varB + c2));
+				++count;
+			}
+		}
+		return count ? (float)(sum / count) : 1.0f;
+	}
+
+	static float computeFLIP(const std::vector<glm::vec3>& test, const std::vector<glm::vec3>& reference, glm::uvec2 dim)
+	{
+		if (test.empty())
+			return 0.0f;
+
+		std::vector<glm::vec3> testLab = toLab(test), referenceLab = toLab(reference);
+
+		// Colour pipeline: low-pass filter (contrast sensitivity stand-in), then HyAB distance:
+		const std::vector<glm::vec3> testFiltered = gaussianBlur(testLab, dim, 1.0f);
+		const std::vector<glm::vec3> referenceFiltered = gaussianBlur(referenceLab, dim, 1.0f);
+
+		// Largest distance within the sRGB gamut, between pure green and pure blue:
+		const float maxDistance = std::pow(hyab(rgbToLab(glm::vec3(0.0f, 1.0f, 0.0f)), rgbToLab(glm::vec3(0.0f, 0.0f, 1.0f))), 0.7f);
+		const float pc = 0.4f, pt = 0.95f;
+
+		// Feature pipeline: edges (first derivative) and points (second derivative) of normalised lightness:
+		std::vector<float> testL(test.size()), referenceL(test.size());
+		for (size_t i = 0; i < test.size(); ++i)
+		{
+			testL[i] = testLab[i].x / 100.0f;
+			referenceL[i] = referenceLab[i].x / 100.0f;
+		}
+
+		double sum = 0.0;
+		for (unsigned int y = 0; y < dim.y; ++y)
+		{
+			for (unsigned int x = 0; x < dim.x; ++x)
+			{
+				const size_t index = (size_t)y * dim.x + x;
+
+				// Compress small colour differences, stretch large ones:
+				float colourError = std::pow(hyab(testFiltered[index], referenceFiltered[index]), 0.7f);
+				colourError = colourError < pc * maxDistance ? pt * colourError / (pc * maxDistance)
+					: pt + (colourError - pc * maxDistance) / (maxDistance - pc * maxDistance) * (1.0f - pt);
+				colourError = std::min(colourError, 1.0f);
+
+				glm::vec2 testFeatures = getFeatures(testL, dim, x, y);
+				glm::vec2 referenceFeatures = getFeatures(referenceL, dim, x, y);
+				const float featureError = std::pow(std::min(1.0f, std::max(std::abs(testFeatures.x - referenceFeatures.x),
+					std::abs(testFeatures.y - referenceFeatures.y)) / std::sqrt(2.0f)), 0.5f);
+
+				sum += std::pow(colourError, 1.0f - featureError);
+			}
+		}
+		return (float)(sum / test.size());
+	}
+
+private:
+	static std::vector<float> getLuminance(const std::vector<glm::vec3>& image)
+	{
+		std::vector<float> luma(image.size());
+		for (size_t i = 0; i < image.size(); ++i)
+			luma[i] = glm::dot(glm::clamp(image[i], 0.0f, 1.0f), glm::vec3(0.2126f, 0.7152f, 0.0722f));
+		return luma;
+	}
+
+	static glm::vec3 rgbToLab(glm::vec3 rgb)
+	{
+		// Display-encoded to linear, then linear sRGB to XYZ (D65), normalised by the white point:
+		const glm::vec3 linear = glm::pow(glm::clamp(rgb, 0.0f, 1.0f), glm::vec3(2.2f));
+		const glm::vec3 xyz = glm::vec3(
+			glm::dot(linear, glm::vec3(0.4124f, 0.3576f, 0.1805f)) / 0.9505f,
+			glm::dot(linear, glm::vec3(0.2126f, 0.7152f, 0.0722f)),
+			glm::dot(linear, glm::vec3(0.0193f, 0.1192f, 0.9505f)) / 1.089f);
+
+		auto f = [](float t) { return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f; };
+		const glm::vec3 fxyz(f(xyz.x), f(xyz.y), f(xyz.z));
+		return glm::vec3(116.0f * fxyz.y - 16.0f, 500.0f * (fxyz.x - fxyz.y), 200.0f * (fxyz.y - fxyz.z));
+	}
+
+	static std::vector<glm::vec3> toLab(const std::vector<glm::vec3>& image)
+	{
+		std::vector<glm::vec3> lab(image.size());
+		for (size_t i = 0; i < image.size(); ++i)
+			lab[i] = rgbToLab(image[i]);
+		return lab;
+	}
+
+	static float hyab(glm::vec3 a, glm::vec3 b)
+	{
+		return std::abs(a.x - b.x) + glm::length(glm::vec2(a.y - b.y, a.z - b.z));
+	}
+
+	// Separable Gaussian blur, clamping at the image borders:
+	static std::vector<glm::vec3> gaussianBlur(const std::vector<glm::vec3>& image, glm::uvec2 dim, float sigma)
+	{
+		const int radius = (int)std::ceil(3.0f * sigma);
+		std::vector<float> weights(2 * radius + 1);
+		float total = 0.0f;
+		for (int i = -radius; i <= radius; ++i)
+			total += weights[i + radius] = std::exp(-(float)(i * i) / (2.0f * sigma * sigma));
+		for (float& weight : weights)
+			weight /= total;
+
+		std::vector<glm::vec3> horizontal(image.size()), result(image.size());
+		for (int y = 0; y < (int)dim.y; ++y)
+		{
+			for (int x = 0; x < (int)dim.x; ++x)
+			{
+				glm::vec3 sum(0.0f);
+				for (int i = -radius; i <= radius; ++i)
+					sum += weights[i + radius] * image[(size_t)y * dim.x + glm::clamp(x + i, 0, (int)dim.x - 1)];
+				horizontal[(size_t)y * dim.x + x] = sum;
+			}
+		}
+		for (int y = 0; y < (int)dim.y; ++y)
+		{
+			for (int x = 0; x < (int)dim.x; ++x)
+			{
+				glm::vec3 sum(0.0f);
+				for (int i = -radius; i <= radius; ++i)
+					sum += weights[i + radius] * horizontal[(size_t)glm::clamp(y + i, 0, (int)dim.y - 1) * dim.x + x];
+				result[(size_t)y * dim.x + x] = sum;
+			}
+		}
+		return result;
+	}
+
+	// Edge (Sobel gradient) and point (Laplacian) magnitudes of a single channel image at a pixel:
+	static glm::vec2 getFeatures(const std::vector<float>& image, glm::uvec2 dim, unsigned int x, unsigned int y)
+	{
+		auto at = [&](int i, int j) {
+			return image[(size_t)glm::clamp((int)y + j, 0, (int)dim.y - 1) * dim.x + glm::clamp((int)x + i, 0, (int)dim.x - 1)];
+		};
+
+		const float gx = (at(1, -1) + 2.0f * at(1, 0) + at(1, 1) - at(-1, -1) - 2.0f * at(-1, 0) - at(-1, 1)) / 4.0f;
+		const float gy = (at(-1, 1) + 2.0f * at(0, 1) + at(1, 1) - at(-1, -1) - 2.0f * at(0, -1) - at(1, -1)) / 4.0f;
+		const float laplacian = at(1, 0) + at(-1, 0) + at(0, 1) + at(0, -1) - 4.0f * at(0, 0);
+
+		return glm::vec2(std::sqrt(gx * gx + gy * gy), std::abs(laplacian));
+	}
+};
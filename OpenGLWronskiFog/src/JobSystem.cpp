@@ -0,0 +1,255 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include "CPUProfiler.h"
+
+static const uint32_t c_notAWorker = UINT32_MAX;
+static thread_local uint32_t s_workerIndex = c_notAWorker;
+
+std::vector<std::unique_ptr<JobSystem::Worker>> JobSystem::s_workers;
+std::atomic<bool>								JobSystem::s_running{ false };
+std::atomic<int>								JobSystem::s_queuedJobs{ 0 };
+std::mutex										JobSystem::s_sleepMutex;
+std::condition_variable							JobSystem::s_wake;
+JobSystem::TimingHook							JobSystem::s_timingHook;
+
+void JobSystem::init(uint32_t numWorkers)
+{
+	if (!s_workers.empty())
+		return;
+
+	if (numWorkers == 0)
+		numWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+	s_running = true;
+	for (uint32_t i = 0; i < numWorkers; ++i)
+		s_workers.push_back(std::make_unique<Worker>());
+
+	// The calling thread is worker 0, the rest get threads of their own:
+	s_workerIndex = 0;
+	for (uint32_t i = 1; i < numWorkers; ++i)
+		s_workers[i]->thread = std::thread(&JobSystem::workerMain, i);
+
+	std::cout << "Job system started with " << numWorkers << " workers." << std::endl;
+}
+
+void JobSystem::shutdown()
+{
+	if (s_workers.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(s_sleepMutex);
+		s_running = false;
+	}
+	s_wake.notify_all();
+
+	for (auto& worker : s_workers)
+		if (worker->thread.joinable())
+			worker->thread.join();
+
+	// Anything still queued on worker 0 (which only runs jobs while waiting) runs now:
+	while (JobHandle job = findJob(0))
+		execute(job, 0);
+
+	s_workers.clear();
+	s_workerIndex = c_notAWorker;
+}
+
+JobSystem::JobHandle JobSystem::create(const char* name, std::function<void()> function)
+{
+	JobHandle job = std::make_shared<Job>();
+	job->name = name;
+	job->function = std::move(function);
+	return job;
+}
+
+void JobSystem::addDependency(const JobHandle& job, const JobHandle& dependency)
+{
+	std::lock_guard<std::mutex> lock(dependency->continuationMutex);
+	if (dependency->finished)
+		return;
+
+	job->pendingDependencies.fetch_add(1);
+	dependency->continuations.push_back(job);
+}
+
+void JobSystem::submit(const JobHandle& job)
+{
+	if (job->pendingDependencies.fetch_sub(1) == 1)
+		enqueue(job);
+}
+
+JobSystem::JobHandle JobSystem::run(const char* name, std::function<void()> function, const std::vector<JobHandle>& dependencies)
+{
+	JobHandle job = create(name, std::move(function));
+	for (const JobHandle& dependency : dependencies)
+		addDependency(job, dependency);
+	submit(job);
+	return job;
+}
+
+void JobSystem::wait(const JobHandle& job)
+{
+	const uint32_t worker = getWorkerIndex();
+
+	// Help out rather than block, which also makes waiting from inside a job safe:
+	while (!job->finished)
+	{
+		if (JobHandle other = findJob(worker))
+			execute(other, worker);
+		else
+			std::this_thread::yield();
+	}
+}
+
+bool JobSystem::isFinished(const JobHandle& job)
+{
+	return job->finished;
+}
+
+void JobSystem::parallelFor(const char* name, size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function)
+{
+	if (count == 0)
+		return;
+
+	// A few chunks per worker, so workers that finish early can steal the rest:
+	grainSize = std::max<size_t>(grainSize, 1);
+	const size_t maxChunks = std::max<size_t>(s_workers.size() * 4, 1);
+	const size_t numChunks = std::min((count + grainSize - 1) / grainSize, maxChunks);
+
+	if (numChunks <= 1 || s_workers.empty())
+	{
+		ScopedZone zone(name);
+		function(0, count);
+		return;
+	}
+
+	std::vector<JobHandle> chunks;
+	chunks.reserve(numChunks);
+	for (size_t i = 0; i < numChunks; ++i)
+	{
+		const size_t begin = count * i / numChunks, end = count * (i + 1) / numChunks;
+		chunks.push_back(run(name, [&function, begin, end]() { function(begin, end); }));
+	}
+
+	for (const JobHandle& chunk : chunks)
+		wait(chunk);
+}
+
+void JobSystem::workerMain(uint32_t index)
+{
+	s_workerIndex = index;
+	const std::string threadName = "Job worker " + std::to_string(index);
+	CPUProfiler::setThreadName(threadName.c_str());
+
+	while (s_running || s_queuedJobs > 0)
+	{
+		if (JobHandle job = findJob(index))
+		{
+			execute(job, index);
+			continue;
+		}
+
+		// Sleep until there's work, or the job system shuts down:
+		std::unique_lock<std::mutex> lock(s_sleepMutex);
+		s_wake.wait(lock, []() { return s_queuedJobs > 0 || !s_running; });
+	}
+}
+
+void JobSystem::enqueue(const JobHandle& job)
+{
+	// Without workers (before init() or after shutdown()), jobs run as soon as they're ready:
+	if (s_workers.empty())
+	{
+		execute(job, c_notAWorker);
+		return;
+	}
+
+	// Workers queue onto their own deque, other threads spread jobs over all of them:
+	static std::atomic<uint32_t> s_nextWorker{ 0 };
+	uint32_t worker = getWorkerIndex();
+	if (worker == c_notAWorker)
+		worker = s_nextWorker.fetch_add(1) % (uint32_t)s_workers.size();
+
+	{
+		std::lock_guard<std::mutex> lock(s_workers[worker]->mutex);
+		s_workers[worker]->jobs.push_back(job);
+	}
+	s_queuedJobs.fetch_add(1);
+
+	// Taking the lock means a worker can't miss the wakeup between checking for work and sleeping:
+	{
+		std::lock_guard<std::mutex> lock(s_sleepMutex);
+	}
+	s_wake.notify_one();
+}
+
+JobSystem::JobHandle JobSystem::findJob(uint32_t worker)
+{
+	const uint32_t numWorkers = (uint32_t)s_workers.size();
+	if (numWorkers == 0)
+		return nullptr;
+
+	// Newest job from our own deque:
+	if (worker < numWorkers)
+	{
+		Worker& own = *s_workers[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			JobHandle job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			s_queuedJobs.fetch_sub(1);
+			return job;
+		}
+	}
+
+	// Otherwise the oldest job from someone else's:
+	const uint32_t start = worker < numWorkers ? worker + 1 : 0;
+	for (uint32_t i = 0; i < numWorkers; ++i)
+	{
+		Worker& victim = *s_workers[(start + i) % numWorkers];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			JobHandle job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			s_queuedJobs.fetch_sub(1);
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::execute(const JobHandle& job, uint32_t worker)
+{
+	if (s_timingHook)
+	{
+		const uint64_t startNs = CPUProfiler::now();
+		job->function();
+		s_timingHook(job->name, worker, startNs, CPUProfiler::now());
+	}
+	else
+		job->function();
+
+	// Mark the job finished and release anything that was waiting on it:
+	std::vector<JobHandle> continuations;
+	{
+		std::lock_guard<std::mutex> lock(job->continuationMutex);
+		job->finished = true;
+		continuations.swap(job->continuations);
+	}
+
+	for (const JobHandle& continuation : continuations)
+		if (continuation->pendingDependencies.fetch_sub(1) == 1)
+			enqueue(continuation);
+}
+
+uint32_t JobSystem::getWorkerIndex()
+{
+	return s_workerIndex;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	Work-stealing job scheduler for CPU work. Each worker thread has its own deque: jobs submitted
+	from a worker go on the back of its own deque and it pops from the back (so it keeps working on
+	what it just produced, while the data is still in cache), while idle workers steal from the
+	front of other workers' deques. The thread that calls init() counts as worker 0 and only runs
+	jobs while it's waiting on one, so it's never tied up by work it didn't ask for.
+
+	Jobs can depend on other jobs: a job isn't queued until it has been submitted and everything
+	it depends on has finished. wait() runs other jobs while it waits rather than blocking, so
+	waiting from inside a job is safe.
+
+	An optional timing hook (set before init()) is called on the worker with each job's name, worker
+	and start/end times (CPUProfiler::now() nanoseconds). The App uses it to record every job as a CPU
+	profiler zone on its worker's track. Job names must outlive the job, as with profiler zones.
+*/
+
+class JobSystem
+{
+public:
+	struct Job;
+	using JobHandle = std::shared_ptr<Job>;
+	using TimingHook = std::function<void(const char* name, uint32_t worker, uint64_t startNs, uint64_t endNs)>;
+
+	static void init(uint32_t numWorkers = 0);	// 0 uses every hardware thread (including the calling one).
+	static void shutdown();						// Finishes queued jobs, then joins the worker threads.
+
+	static JobHandle create(const char* name, std::function<void()> function);
+	static void		 addDependency(const JobHandle& job, const JobHandle& dependency);	// Before job is submitted.
+	static void		 submit(const JobHandle& job);
+	static JobHandle run(const char* name, std::function<void()> function, const std::vector<JobHandle>& dependencies = {});
+	static void		 wait(const JobHandle& job);
+	static bool		 isFinished(const JobHandle& job);
+
+	// Splits [0, count) into chunks of at least grainSize and runs them as jobs, returning once all are done.
+	// A single chunk runs inline on the calling thread:
+	static void parallelFor(const char* name, size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function);
+
+	static void		setTimingHook(TimingHook hook)	{ s_timingHook = std::move(hook); }
+	static uint32_t getNumWorkers()					{ return (uint32_t)s_workers.size(); }
+
+	struct Job
+	{
+		const char*				name;
+		std::function<void()>	function;
+		std::atomic<int>		pendingDependencies{ 1 };	// Plus one until submitted.
+		std::atomic<bool>		finished{ false };
+		std::mutex				continuationMutex;
+		std::vector<JobHandle>	continuations;				// Jobs waiting on this one.
+	};
+
+private:
+	struct Worker
+	{
+		std::mutex				mutex;
+		std::deque<JobHandle>	jobs;
+		std::thread				thread;
+	};
+
+	static void		 workerMain(uint32_t index);
+	static void		 enqueue(const JobHandle& job);
+	static JobHandle findJob(uint32_t worker);	// Pops the worker's own newest job, or steals another's oldest.
+	static void		 execute(const JobHandle& job, uint32_t worker);
+	static uint32_t	 getWorkerIndex();
+
+	static std::vector<std::unique_ptr<Worker>> s_workers;
+	static std::atomic<bool>					s_running;
+	static std::atomic<int>						s_queuedJobs;
+	static std::mutex							s_sleepMutex;
+	static std::condition_variable				s_wake;
+	static TimingHook							s_timingHook;
+};
@@ -0,0 +1,190 @@
+#include "LightManager.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define LIGHT_MANAGER_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+static_assert(NUM_LIGHTS <= 32, "Dirty flags are a 32 bit mask");
+
+// Cube face look directions and up vectors, in shadowmap layer order:
+static const glm::vec3 c_faceDirections[6] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+											   glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+											   glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+static const glm::vec3 c_faceUps[6] = { glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+										glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+										glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) };
+
+LightManager::LightManager()
+{
+	for (int i = 0; i < c_capacity; ++i)
+	{
+		m_positionX[i] = m_positionY[i] = m_positionZ[i] = 0.0f;
+		m_radius[i] = 20.0f;
+		m_diffuse[i] = glm::vec3(1.0f);
+	}
+
+	for (int i = 0; i < 6 * NUM_LIGHTS; ++i)
+		m_matrices[i] = glm::mat4(1.0f);
+
+	// Build the face matrices for the default view planes, which dirties every light:
+	m_viewPlanes = glm::vec2(0.0f);
+	setViewPlanes(glm::vec2(0.1f, 100.0f));
+}
+
+void LightManager::setLight(int index, const Light& light)
+{
+	setPosition(index, light.position);
+	setDiffuse(index, light.diffuse);
+	setRadius(index, light.radius);
+}
+
+void LightManager::setPosition(int index, const glm::vec3& position)
+{
+	if (position == getPosition(index))
+		return;
+
+	m_positionX[index] = position.x;
+	m_positionY[index] = position.y;
+	m_positionZ[index] = position.z;
+	markDirty(index);
+}
+
+void LightManager::setViewPlanes(const glm::vec2& viewPlanes)
+{
+	if (viewPlanes == m_viewPlanes)
+		return;
+
+	m_viewPlanes = viewPlanes;
+
+	const glm::mat4 lightProj = glm::perspective(glm::radians(90.0f), 1.0f, viewPlanes.x, viewPlanes.y);
+	for (int face = 0; face < 6; ++face)
+		m_faceMatrices[face] = lightProj * glm::lookAt(glm::vec3(0.0f), c_faceDirections[face], c_faceUps[face]);
+
+	// Every light's matrices depend on the projection:
+	m_dirty = NUM_LIGHTS == 32 ? ~0u : (1u << NUM_LIGHTS) - 1;
+}
+
+void LightManager::copySettings(const LightManager& other)
+{
+	setNumActive(other.m_numActive);
+	setViewPlanes(other.m_viewPlanes);
+	for (int i = 0; i < NUM_LIGHTS; ++i)
+		setLight(i, other.getLight(i));
+}
+
+int LightManager::updateMatrices()
+{
+	m_matricesRebuilt = 0;
+
+	// Inactive lights stay dirty until they're switched on:
+	const uint32_t activeMask = m_numActive == 32 ? ~0u : (1u << m_numActive) - 1;
+	const uint32_t rebuild = m_dirty & activeMask;
+	if (!rebuild)
+		return 0;
+
+	for (int batch = 0; batch < c_capacity; batch += c_batchSize)
+	{
+		const uint32_t batchMask = (rebuild >> batch) & ((1u << c_batchSize) - 1);
+		if (!batchMask)
+			continue;
+
+		// Translation column of each face matrix, face * translate(-position), for the whole batch:
+		alignas(16) float column[6][4][c_batchSize];
+
+#ifdef LIGHT_MANAGER_USE_SSE
+		const __m128 x = _mm_load_ps(&m_positionX[batch]);
+		const __m128 y = _mm_load_ps(&m_positionY[batch]);
+		const __m128 z = _mm_load_ps(&m_positionZ[batch]);
+#endif
+
+		for (int face = 0; face < 6; ++face)
+		{
+			const glm::mat4& faceMat = m_faceMatrices[face];
+			for (int row = 0; row < 4; ++row)
+			{
+#ifdef LIGHT_MANAGER_USE_SSE
+				__m128 sum = _mm_mul_ps(_mm_set1_ps(faceMat[0][row]), x);
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(faceMat[1][row]), y));
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(faceMat[2][row]), z));
+				_mm_store_ps(column[face][row], _mm_sub_ps(_mm_set1_ps(faceMat[3][row]), sum));
+#else
+				for (int lane = 0; lane < c_batchSize; ++lane)
+				{
+					const int light = batch + lane;
+					column[face][row][lane] = faceMat[3][row] - (faceMat[0][row] * m_positionX[light] + faceMat[1][row] * m_positionY[light] + faceMat[2][row] * m_positionZ[light]);
+				}
+#endif
+			}
+		}
+
+		// Write out the dirty lights' matrices:
+		for (int lane = 0; lane < c_batchSize; ++lane)
+		{
+			if (!(batchMask & (1u << lane)))
+				continue;
+
+			const int light = batch + lane;
+			for (int face = 0; face < 6; ++face)
+			{
+				glm::mat4& lightSpaceMat = m_matrices[6 * light + face];
+				lightSpaceMat = m_faceMatrices[face];
+				lightSpaceMat[3] = glm::vec4(column[face][0][lane], column[face][1][lane], column[face][2][lane], column[face][3][lane]);
+			}
+			++m_matricesRebuilt;
+		}
+	}
+
+	m_dirty &= ~rebuild;
+	return m_matricesRebuilt;
+}
+
+int LightManager::cull(const glm::mat4& viewProj, int* visible) const
+{
+	// Frustum planes from the view-projection's rows, normalised so distances are in world units:
+	const glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+	const glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+	const glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+	const glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+	glm::vec4 planes[6] = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+	for (glm::vec4& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	int numVisible = 0;
+	for (int batch = 0; batch < m_numActive; batch += c_batchSize)
+	{
+		// One bit per light in the batch, cleared by any plane the light's sphere is entirely behind:
+		int inside = (1 << c_batchSize) - 1;
+
+#ifdef LIGHT_MANAGER_USE_SSE
+		const __m128 x = _mm_load_ps(&m_positionX[batch]);
+		const __m128 y = _mm_load_ps(&m_positionY[batch]);
+		const __m128 z = _mm_load_ps(&m_positionZ[batch]);
+		const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(&m_radius[batch]));
+
+		for (const glm::vec4& plane : planes)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y));
+			distance = _mm_add_ps(distance, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z), _mm_set1_ps(plane.w)));
+			inside &= _mm_movemask_ps(_mm_cmpge_ps(distance, negRadius));
+		}
+#else
+		for (int lane = 0; lane < c_batchSize; ++lane)
+		{
+			const int light = batch + lane;
+			for (const glm::vec4& plane : planes)
+				if (plane.x * m_positionX[light] + plane.y * m_positionY[light] + plane.z * m_positionZ[light] + plane.w < -m_radius[light])
+					inside &= ~(1 << lane);
+		}
+#endif
+
+		for (int lane = 0; lane < c_batchSize && batch + lane < m_numActive; ++lane)
+			if (inside & (1 << lane))
+				visible[numVisible++] = batch + lane;
+	}
+
+	return numVisible;
+}
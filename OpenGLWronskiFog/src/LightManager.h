@@ -0,0 +1,81 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+#define NUM_LIGHTS 4
+
+/*
+	Point light storage for the simulation and renderer. Lights are kept as a structure of arrays,
+	padded to whole batches of c_batchSize, so the per-light loops (shadow matrix builds and camera
+	culling) run on four lights at once with SSE, falling back to plain loops without it.
+
+	Each light's six cube face view-projections only depend on its position and the light view
+	planes, so setters mark a light dirty when those change, and updateMatrices() only rebuilds dirty
+	lights. Every face matrix is the face's projection-rotation (shared by all lights) times a
+	translation to the light, so a rebuild is one column per face rather than six lookAt/perspective
+	products per light.
+
+	cull() tests each active light's radius against a view-projection's frustum and writes the
+	indices of the lights that reach into it, which is all the renderer needs to draw.
+
+	Plain data only, so a LightManager can be copied around in a FrameState.
+*/
+
+class LightManager
+{
+public:
+	struct Light
+	{
+		glm::vec3	position = glm::vec3(0.0f);
+		glm::vec3	diffuse = glm::vec3(1.0f);
+		float		radius = 20.0f;
+	};
+
+	static const int c_batchSize = 4;
+	static const int c_capacity = (NUM_LIGHTS + c_batchSize - 1) / c_batchSize * c_batchSize;
+
+	LightManager();
+
+	// Light settings (changes that affect shadows mark the light dirty):
+	void setNumActive(int numActive)				{ m_numActive = glm::clamp(numActive, 0, NUM_LIGHTS); }
+	void setLight(int index, const Light& light);
+	void setPosition(int index, const glm::vec3& position);
+	void setDiffuse(int index, const glm::vec3& diffuse)	{ m_diffuse[index] = diffuse; }
+	void setRadius(int index, float radius)					{ m_radius[index] = radius; }
+	void setViewPlanes(const glm::vec2& viewPlanes);
+	void copySettings(const LightManager& other);	// Takes another manager's lights, without its matrices.
+
+	int			getNumActive() const				{ return m_numActive; }
+	Light		getLight(int index) const			{ return { getPosition(index), m_diffuse[index], m_radius[index] }; }
+	glm::vec3	getPosition(int index) const		{ return glm::vec3(m_positionX[index], m_positionY[index], m_positionZ[index]); }
+	glm::vec3	getDiffuse(int index) const			{ return m_diffuse[index]; }
+	float		getRadius(int index) const			{ return m_radius[index]; }
+	glm::vec2	getViewPlanes() const				{ return m_viewPlanes; }
+
+	// Rebuilds the cube face matrices of dirty lights, returning how many were rebuilt:
+	int updateMatrices();
+	const glm::mat4* getMatrices(int index) const	{ return &m_matrices[6 * index]; }	// Six faces: +x, -x, +y, -y, +z, -z.
+	int getMatricesRebuilt() const					{ return m_matricesRebuilt; }		// By the last updateMatrices().
+
+	// Writes the indices of active lights whose radius intersects the frustum, returning how many:
+	int cull(const glm::mat4& viewProj, int* visible) const;
+
+private:
+	void markDirty(int index)						{ m_dirty |= 1u << index; }
+
+	// Structure of arrays, aligned for SSE loads:
+	alignas(16) float	m_positionX[c_capacity];
+	alignas(16) float	m_positionY[c_capacity];
+	alignas(16) float	m_positionZ[c_capacity];
+	alignas(16) float	m_radius[c_capacity];
+	glm::vec3			m_diffuse[c_capacity];
+
+	int					m_numActive = 1;
+	uint32_t			m_dirty = 0;				// One bit per light.
+	int					m_matricesRebuilt = 0;
+
+	glm::vec2			m_viewPlanes = glm::vec2(0.1f, 100.0f);
+	glm::mat4			m_faceMatrices[6];			// Projection * face rotation, shared by every light.
+	glm::mat4			m_matrices[6 * NUM_LIGHTS];
+};
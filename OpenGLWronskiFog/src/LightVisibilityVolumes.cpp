@@ -0,0 +1,92 @@
+#include "LightVisibilityVolumes.h"
+
+#include <string>
+
+#include "FogRenderer.h"
+#include "GPUResourceRegistry.h"
+#include "SceneUtils.h"
+
+bool LightVisibilityVolumes::Scene::operator==(const Scene& other) const
+{
+	return planetPosition == other.planetPosition && lightPlanes == other.lightPlanes && shadowMapTechnique == other.shadowMapTechnique;
+}
+
+void LightVisibilityVolumes::init()
+{
+	for (int i = 0; i < NUM_LIGHTS; ++i)
+	{
+		glGenTextures(1, &m_textures[i]);
+		glBindTexture(GL_TEXTURE_3D, m_textures[i]);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+		glTexImage3D(GL_TEXTURE_3D, 0, GL_R8, c_resolution, c_resolution, c_resolution, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+		GPUResourceRegistry::registerTexture(m_textures[i], GPUResourceRegistry::SHADOWS, "Light visibility volume " + std::to_string(i), GL_R8, glm::uvec3(c_resolution));
+	}
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	invalidate();
+}
+
+void LightVisibilityVolumes::release()
+{
+	for (int i = 0; i < NUM_LIGHTS; ++i)
+		GPUResourceRegistry::deleteTexture(m_textures[i]);
+
+	invalidate();
+}
+
+void LightVisibilityVolumes::update(const Shader& visibilityShader, const Scene& scene, const LightManager& lights, const int* visibleLights, int numVisible)
+{
+	m_volumesUpdated = 0;
+
+	// A changed scene touches every volume, visible or not:
+	if (!(scene == m_scene))
+	{
+		for (bool& valid : m_valid)
+			valid = false;
+		m_scene = scene;
+	}
+
+	const glm::uvec3 numGroups(c_resolution / c_groupSize);
+	for (int i = 0; i < numVisible; ++i)
+	{
+		const int index = visibleLights[i];
+		const glm::vec4 bounds(lights.getPosition(index), lights.getRadius(index));
+		if (m_valid[index] && bounds == m_bounds[index])
+			continue;
+
+		// The shadowmap and light matrices are in visible order:
+		visibilityShader.use();
+		visibilityShader.setInt("u_light", i);
+		visibilityShader.setVec4("u_bounds", bounds);
+		FogRenderer::bindImage(0, m_textures[index], GL_WRITE_ONLY, GL_R8);
+		FogRenderer::dispatch(numGroups, visibilityShader);
+
+		m_bounds[index] = bounds;
+		m_valid[index] = true;
+		++m_volumesUpdated;
+	}
+
+	// The scatter shader samples the volumes next:
+	if (m_volumesUpdated)
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void LightVisibilityVolumes::bind(const Shader& scatterShader, GLuint firstUnit, const int* visibleLights, int numVisible) const
+{
+	scatterShader.use();
+	for (int i = 0; i < numVisible; ++i)
+	{
+		const int index = visibleLights[i];
+		glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+		glBindTexture(GL_TEXTURE_3D, m_textures[index]);
+
+		// Lights whose volume hasn't been computed (yet) have no bounds, so they're always shadowed the long way:
+		scatterShader.setVec4(SceneUtils::getArrayUniformName("u_visibilityBounds", i), m_valid[index] ? m_bounds[index] : glm::vec4(0.0f));
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
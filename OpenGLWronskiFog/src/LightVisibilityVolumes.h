@@ -0,0 +1,55 @@
+#pragma once
+#include <glad4.3/glad4.3.h>
+#include <glm/glm.hpp>
+
+#include "LightManager.h"
+#include "Shader.h"
+
+/*
+	A low resolution world-space volume of shadowmap visibility per light, covering the cube around
+	its sphere of influence. The scatter shader samples it trilinearly in place of calcShadow()'s
+	cube face projections and shadowmap fetches, falling back on them outside the cube.
+
+	A volume only depends on its light's position and radius, and on the occluders and shadowmap
+	settings, so it's computed from the light's shadowmap once, and again only when one of those
+	changes. Volumes are kept per light rather than per visible slot, so a light that's culled and
+	comes back into view keeps its volume.
+*/
+
+class LightVisibilityVolumes
+{
+public:
+	static const int c_resolution = 32;		// Texels per side.
+	static const int c_groupSize = 4;		// Local size of lightVisibilityShader.comp in each dimension.
+
+	// Everything the volumes depend on other than the lights, where any change invalidates them all:
+	struct Scene
+	{
+		glm::vec3	planetPosition = glm::vec3(0.0f);	// The only occluder that isn't static.
+		glm::vec2	lightPlanes = glm::vec2(0.0f);		// Shadowmap near and far planes.
+		int			shadowMapTechnique = 0;
+
+		bool operator==(const Scene& other) const;
+	};
+
+	void init();
+	void release();
+	void invalidate()	{ for (bool& valid : m_valid) valid = false; }
+
+	// Recomputes the volumes of visible lights that changed since theirs were, from this frame's shadowmaps (the
+	// visibility shader's shadow uniforms, shadowmaps and light matrices must already be set up, in visible order):
+	void update(const Shader& visibilityShader, const Scene& scene, const LightManager& lights, const int* visibleLights, int numVisible);
+
+	// Binds the visible lights' volumes to consecutive texture units, and sets the scatter shader's bounds uniforms:
+	void bind(const Shader& scatterShader, GLuint firstUnit, const int* visibleLights, int numVisible) const;
+
+	int getVolumesUpdated() const	{ return m_volumesUpdated; }	// By the last update() call.
+
+private:
+	GLuint		m_textures[NUM_LIGHTS] = {};	// R8 visibility.
+	glm::vec4	m_bounds[NUM_LIGHTS];			// What each volume was computed for: its light's position and radius.
+	bool		m_valid[NUM_LIGHTS] = {};
+
+	Scene		m_scene;
+	int			m_volumesUpdated = 0;
+};
@@ -1,4 +1,6 @@
 #include "Mesh.h"
+#include "SceneUtils.h"
+#include "GPUResourceRegistry.h"
 
 Mesh::Mesh(const std::vector<VAO::Vertex>& vertices, const std::vector<GLuint>& indices, const std::vector<Texture>& textures)
 	: m_vertices(vertices), m_indices(indices), m_textures(textures)
@@ -16,14 +18,8 @@ void Mesh::draw(const Shader& shader) const
 		// Activate and bind texture units in sequence:
 		glActiveTexture(GL_TEXTURE0 + i);
 
-		std::string number;
-		std::string name = m_textures[i].type;
-		if (name == "texture_diffuse")
-			number = std::to_string(diffuseIndex++);
-		else if (name == "texture_specular")
-			number = std::to_string(specularIndex++);
-
-		glUniform1i(glGetUniformLocation(shader.m_ID, (name + number).c_str()), i);
+		const std::string name = SceneUtils::getTextureUniformName(m_textures[i].type, diffuseIndex, specularIndex);
+		glUniform1i(glGetUniformLocation(shader.m_ID, name.c_str()), i);
 		glBindTexture(GL_TEXTURE_2D, m_textures[i].id);
 	}
 
@@ -37,9 +33,6 @@ void Mesh::draw(const Shader& shader) const
 
 void Mesh::setupMesh()
 {
-	m_VAO.setData(m_vertices);
-	m_EBO.setData(m_indices.data(), m_indices.size() * sizeof(GLuint));
-
 	GLCALL(glGenVertexArrays(1, &m_vao));
 	GLCALL(glGenBuffers(1, &m_ebo));
 	GLCALL(glGenBuffers(1, &m_vbo));
@@ -50,6 +43,8 @@ void Mesh::setupMesh()
 	GLCALL(glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(VAO::Vertex), &m_vertices[0], GL_STATIC_DRAW));
 	GLCALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo));
 	GLCALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), &m_indices[0], GL_STATIC_DRAW));
+	GPUResourceRegistry::registerBuffer(m_vbo, GPUResourceRegistry::MESHES, "Mesh VBO", m_vertices.size() * sizeof(VAO::Vertex));
+	GPUResourceRegistry::registerBuffer(m_ebo, GPUResourceRegistry::MESHES, "Mesh EBO", m_indices.size() * sizeof(unsigned int));
 
 	// Vertices:
 	GLCALL(glEnableVertexAttribArray(0));
@@ -64,4 +59,11 @@ void Mesh::setupMesh()
 	GLCALL(glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VAO::Vertex), (void*)offsetof(VAO::Vertex, texCoords)));
 
 	glBindVertexArray(0);
-}
\ No newline at end of file
+}
+
+void Mesh::release()
+{
+	glDeleteVertexArrays(1, &m_vao);
+	GPUResourceRegistry::deleteBuffer(m_vbo);
+	GPUResourceRegistry::deleteBuffer(m_ebo);
+}
@@ -21,14 +21,13 @@ public:
     std::vector<VAO::Vertex>    m_vertices;
     std::vector<GLuint>         m_indices;
     std::vector<Texture>        m_textures;
-    VAO m_VAO;
     GLuint m_vao;
 
     Mesh(const std::vector<VAO::Vertex>& vertices, const std::vector<GLuint>& indices, const std::vector<Texture>& textures);
     void draw(const Shader& shader) const;
+    void release();    // Deletes the mesh's buffers (textures are shared, so are owned by the Model).
 
 private:
-    EBO m_EBO;
     GLuint m_ebo;
     GLuint m_vbo;
     void setupMesh();
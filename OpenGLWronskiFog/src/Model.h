@@ -13,6 +13,9 @@
 
 #include "Mesh.h"
 #include "Shader.h"
+#include "CPUProfiler.h"
+#include "SceneUtils.h"
+#include "GPUResourceRegistry.h"
 
 #include <string>
 #include <iostream>
@@ -66,16 +69,25 @@ public:
 
     inline void setModel(const std::string& filePath)
     {
-        // If this object already contains a model, empty mesh and texture vectors:
+        // If this object already contains a model, release its meshes and textures:
         if (m_meshes.size() || m_textures.size())
-        {
-            m_meshes.clear();
-            m_textures.clear();
-        }
+            release();
         std::cout << "Loading model " << filePath << "..." << std::endl;
         loadModel(filePath);
     }
 
+    // Delete all mesh buffers and textures (meshes are copied around by value, so this is explicit rather than in a destructor):
+    inline void release()
+    {
+        for (Mesh& mesh : m_meshes)
+            mesh.release();
+        for (Texture& texture : m_textures)
+            GPUResourceRegistry::deleteTexture(texture.id);
+
+        m_meshes.clear();
+        m_textures.clear();
+    }
+
     // Call OpenGL draw functions for each mesh in this model:
     inline void draw(Shader& shader)
     {
@@ -86,6 +98,8 @@ public:
     // Load a model using Assimp and store model data in vector of Mesh objects:
     void loadModel(std::string const& path)
     {
+        PROFILE_FUNCTION();
+
         Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
         
@@ -108,63 +122,20 @@ private:
     // Process Assimp scene nodes recursively, starting from the root:
     void processNode(aiNode* node, const aiScene* scene)
     {
-        // Process meshes at the current node:
-        for (size_t i = 0; i < node->mNumMeshes; i++)
-        {
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+        std::vector<const aiMesh*> meshes;
+        SceneUtils::collectNodeMeshes(node, scene, meshes);
+
+        for (const aiMesh* mesh : meshes)
             m_meshes.push_back(processMesh(mesh, scene));
-        }
-        // After all meshes in this node have been processed (if any), process meshes in child nodes:
-        for (size_t i = 0; i < node->mNumChildren; i++)
-            processNode(node->mChildren[i], scene);
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    Mesh processMesh(const aiMesh* mesh, const aiScene* scene)
     {
         std::vector<VAO::Vertex> vertices;
         std::vector<GLuint> indices;
         std::vector<Texture> textures;
 
-        for (size_t i = 0; i < mesh->mNumVertices; i++)
-        {
-            VAO::Vertex vertex;
-            glm::vec3 vector;
-
-            // Position:
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.position = vector;
-
-            // Normal (if present):
-            if (mesh->HasNormals())
-            {
-                vector.x = mesh->mNormals[i].x;
-                vector.y = mesh->mNormals[i].y;
-                vector.z = mesh->mNormals[i].z;
-                vertex.normal = vector;
-            }
-
-            // Tex coords (if present):
-            if (mesh->mTextureCoords[0])
-            {
-                glm::vec2 vec;
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.texCoords = vec;
-            }
-            else
-                vertex.texCoords = glm::vec2(0.0f, 0.0f);
-
-            vertices.push_back(vertex);
-        }
-        // Retrieve vertex indices by processing each mesh face (triangle):
-        for (size_t i = 0; i < mesh->mNumFaces; i++)
-        {
-            aiFace face = mesh->mFaces[i];
-            for (unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
-        }
+        SceneUtils::extractMeshData(mesh, vertices, indices);
 
         // Process materials and store texture map data:
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
@@ -237,15 +208,19 @@ private:
             glBindTexture(GL_TEXTURE_2D, textureID);
             glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
             glGenerateMipmap(GL_TEXTURE_2D);
+            GPUResourceRegistry::registerTexture(textureID, GPUResourceRegistry::MESHES, filename, format, glm::uvec3(width, height, 1), true);
 
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         }
-        // If no data was found, output error message:
+        // If no data was found, output error message (the empty texture is still tracked, since it's deleted with the model):
         else
+        {
             std::cout << "IMAGE LOADING ERROR: Texture failed to load at path " << path << std::endl;
+            GPUResourceRegistry::registerTexture(textureID, GPUResourceRegistry::MESHES, filename + " (failed to load)", GL_RGBA, glm::uvec3(0));
+        }
 
         stbi_image_free(data);
         return textureID;
@@ -0,0 +1,552 @@
+#include "ReferenceRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+static const float c_pi = 3.14159265358979f;
+static const float c_infinity = 1e30f;
+static const uint32_t c_maxLeafSize = 4;
+
+// Ken Perlin's permutation, repeated so lookups of up to perm[511] don't need wrapping:
+static const int c_perm[512] = { 151,160,137,91,90,15,
+	131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
+	190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,
+	88,237,149,56,87,174,20,125,136,171,168, 68,175,74,165,71,134,139,48,27,166,
+	77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,55,46,245,40,244,
+	102,143,54, 65,25,63,161, 1,216,80,73,209,76,132,187,208, 89,18,169,200,196,
+	135,130,116,188,159,86,164,100,109,198,173,186, 3,64,52,217,226,250,124,123,
+	5,202,38,147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,
+	223,183,170,213,119,248,152, 2,44,154,163, 70,221,153,101,155,167, 43,172,9,
+	129,22,39,253, 19,98,108,110,79,113,224,232,178,185, 112,104,218,246,97,228,
+	251,34,242,193,238,210,144,12,191,179,162,241, 81,51,145,235,249,14,239,107,
+	49,192,214, 31,181,199,106,157,184, 84,204,176,115,121,50,45,127, 4,150,254,
+	138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180,
+	151,160,137,91,90,15,
+	131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
+	190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,
+	88,237,149,56,87,174,20,125,136,171,168, 68,175,74,165,71,134,139,48,27,166,
+	77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,55,46,245,40,244,
+	102,143,54, 65,25,63,161, 1,216,80,73,209,76,132,187,208, 89,18,169,200,196,
+	135,130,116,188,159,86,164,100,109,198,173,186, 3,64,52,217,226,250,124,123,
+	5,202,38,147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,
+	223,183,170,213,119,248,152, 2,44,154,163, 70,221,153,101,155,167, 43,172,9,
+	129,22,39,253, 19,98,108,110,79,113,224,232,178,185, 112,104,218,246,97,228,
+	251,34,242,193,238,210,144,12,191,179,162,241, 81,51,145,235,249,14,239,107,
+	49,192,214, 31,181,199,106,157,184, 84,204,176,115,121,50,45,127, 4,150,254,
+	138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
+};
+
+// PCG hash, used both to seed each pixel sample and to step its random sequence:
+static uint32_t pcgHash(uint32_t value)
+{
+	const uint32_t state = value * 747796405u + 2891336453u;
+	const uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+// Uniform float in [0, 1):
+static float random(uint32_t& state)
+{
+	state = pcgHash(state);
+	return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+// Slab test, returning the entry distance, or c_infinity if the box is missed:
+static float intersectBounds(const glm::vec3& origin, const glm::vec3& invDirection, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float tMax)
+{
+	const glm::vec3 t0 = (boundsMin - origin) * invDirection;
+	const glm::vec3 t1 = (boundsMax - origin) * invDirection;
+	const glm::vec3 tNear = glm::min(t0, t1);
+	const glm::vec3 tFar = glm::max(t0, t1);
+
+	const float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+	return entry <= exit ? entry : c_infinity;
+}
+
+int ReferenceRenderer::addMesh(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+{
+	MeshData mesh;
+	mesh.triangles.reserve(indices.size() / 3);
+	mesh.min = glm::vec3(c_infinity);
+	mesh.max = glm::vec3(-c_infinity);
+
+	std::vector<glm::vec3> mins, maxs;
+	mins.reserve(indices.size() / 3);
+	maxs.reserve(indices.size() / 3);
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const glm::vec3 v0 = positions[indices[i]], v1 = positions[indices[i + 1]], v2 = positions[indices[i + 2]];
+		mesh.triangles.push_back({ v0, v1 - v0, v2 - v0 });
+
+		mins.push_back(glm::min(v0, glm::min(v1, v2)));
+		maxs.push_back(glm::max(v0, glm::max(v1, v2)));
+		mesh.min = glm::min(mesh.min, mins.back());
+		mesh.max = glm::max(mesh.max, maxs.back());
+	}
+
+	buildBVH(mesh.bvh, mins, maxs);
+	m_meshes.push_back(std::move(mesh));
+	return (int)m_meshes.size() - 1;
+}
+
+void ReferenceRenderer::addInstance(int mesh, const glm::mat4& world)
+{
+	m_instances.push_back({ mesh, world, glm::inverse(world) });
+}
+
+void ReferenceRenderer::clear()
+{
+	m_meshes.clear();
+	m_instances.clear();
+	m_lights.clear();
+	m_instanceBVH = BVH();
+}
+
+void ReferenceRenderer::build()
+{
+	// World space bounds of each instance, from its mesh's transformed bounding box corners:
+	std::vector<glm::vec3> mins, maxs;
+	for (const Instance& instance : m_instances)
+	{
+		const MeshData& mesh = m_meshes[instance.mesh];
+		glm::vec3 boundsMin(c_infinity), boundsMax(-c_infinity);
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 local((corner & 1) ? mesh.max.x : mesh.min.x, (corner & 2) ? mesh.max.y : mesh.min.y, (corner & 4) ? mesh.max.z : mesh.min.z);
+			const glm::vec3 world = glm::vec3(instance.world * glm::vec4(local, 1.0f));
+			boundsMin = glm::min(boundsMin, world);
+			boundsMax = glm::max(boundsMax, world);
+		}
+		mins.push_back(boundsMin);
+		maxs.push_back(boundsMax);
+	}
+
+	buildBVH(m_instanceBVH, mins, maxs);
+}
+
+size_t ReferenceRenderer::getNumTriangles() const
+{
+	size_t numTriangles = 0;
+	for (const Instance& instance : m_instances)
+		numTriangles += m_meshes[instance.mesh].triangles.size();
+	return numTriangles;
+}
+
+ReferenceRenderer::Image ReferenceRenderer::render(const glm::mat4& view, const glm::mat4& proj, float farPlane, const Medium& medium, const Settings& settings) const
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	Image image;
+	image.dim = settings.resolution;
+	image.inScattering.assign((size_t)image.dim.x * image.dim.y, glm::vec3(0.0f));
+	image.transmittance.assign((size_t)image.dim.x * image.dim.y, 1.0f);
+
+	const glm::mat4 invView = glm::inverse(view);
+	const glm::mat4 invViewProj = glm::inverse(proj * view);
+	const glm::vec3 cameraPos = glm::vec3(invView[3]);
+	const glm::vec3 cameraForward = -glm::normalize(glm::vec3(invView[2]));
+
+	const int numSamples = std::max(settings.samplesPerPixel, 1);
+	const int numSteps = std::max(settings.stepsPerSample, 1);
+	const int numLights = (int)m_lights.size();
+
+	auto renderPixel = [&](uint32_t x, uint32_t y)
+	{
+		const uint32_t pixelIndex = y * image.dim.x + x;
+		glm::vec3 inScattering(0.0f);
+		float transmittance = 0.0f;
+
+		for (int sample = 0; sample < numSamples; ++sample)
+		{
+			uint32_t rngState = pcgHash(settings.seed ^ pcgHash(pixelIndex * 9781u + sample));
+
+			// Jittered primary ray through the far plane:
+			const glm::vec2 ndc = 2.0f * (glm::vec2(x, y) + glm::vec2(random(rngState), random(rngState))) / glm::vec2(image.dim) - 1.0f;
+			const glm::vec4 farPoint = invViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+			const Ray ray = makeRay(cameraPos, glm::normalize(glm::vec3(farPoint) / farPoint.w - cameraPos));
+
+			// March to the nearest surface, or to the far plane (the back of the froxel volume):
+			float tEnd = farPlane / std::max(glm::dot(ray.direction, cameraForward), 1e-4f);
+			intersectScene(ray, tEnd, false);
+
+			const float stepLength = tEnd / numSteps;
+			const float offset = random(rngState);
+			glm::vec3 sampleInScattering(0.0f);
+			float sampleTransmittance = 1.0f;
+
+			for (int step = 0; step < numSteps; ++step)
+			{
+				const glm::vec3 pos = ray.origin + ray.direction * ((step + offset) * stepLength);
+
+				float scattering, extinction;
+				getCoefficients(medium, pos, scattering, extinction);
+
+				// Integrate in-scattering analytically over the step, assuming constant lighting across it:
+				const float stepTransmittance = std::exp(-extinction * stepLength);
+				const float scatteringIntegral = extinction > 1e-7f ? (1.0f - stepTransmittance) / extinction : stepLength;
+
+				if (numLights && scattering > 0.0f)
+				{
+					// Pick one light per step, weighting by the number of lights:
+					const int lightIndex = std::min((int)(random(rngState) * numLights), numLights - 1);
+					const Light& light = m_lights[lightIndex];
+
+					const glm::vec3 toLight = light.position - pos;
+					const float dist = glm::length(toLight);
+					const glm::vec3 lightDir = toLight / std::max(dist, 1e-6f);
+
+					float visibility = 1.0f;
+					float shadowT = dist * 0.999f;
+					if (intersectScene(makeRay(pos, lightDir), shadowT, true))
+						visibility = 0.0f;
+					else if (settings.lightTransmittance)
+						visibility = estimateTransmittance(medium, pos, light.position, rngState);
+
+					if (visibility > 0.0f)
+					{
+						const float distOverRadius = dist / light.radius;
+						const float window = glm::clamp(1.0f - distOverRadius * distOverRadius * distOverRadius * distOverRadius, 0.0f, 1.0f);
+						const float attenuation = window * window / (light.constant + light.linear * dist + light.quadratic * dist * dist);
+						const glm::vec3 radiance = light.colour * attenuation * phaseHG(glm::dot(ray.direction, lightDir), medium.phaseG) * visibility * (float)numLights;
+						sampleInScattering += sampleTransmittance * scattering * medium.albedo * radiance * scatteringIntegral;
+					}
+				}
+				sampleTransmittance *= stepTransmittance;
+			}
+
+			inScattering += sampleInScattering;
+			transmittance += sampleTransmittance;
+		}
+
+		image.inScattering[pixelIndex] = inScattering / (float)numSamples;
+		image.transmittance[pixelIndex] = transmittance / numSamples;
+	};
+
+	// Rows are handed out to threads one at a time:
+	std::atomic<uint32_t> nextRow{ 0 };
+	auto worker = [&]()
+	{
+		for (uint32_t y = nextRow++; y < image.dim.y; y = nextRow++)
+			for (uint32_t x = 0; x < image.dim.x; ++x)
+				renderPixel(x, y);
+	};
+
+	const int numThreads = settings.numThreads > 0 ? settings.numThreads : std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numThreads; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "Rendered " << image.dim.x << "x" << image.dim.y << " reference (" << numSamples << " spp, " << numSteps << " steps, "
+		<< getNumTriangles() << " triangles) on " << numThreads << " threads in " << seconds << "s" << std::endl;
+
+	return image;
+}
+
+std::vector<glm::vec3> ReferenceRenderer::composite(const Image& fog, const std::vector<glm::vec3>& surfaceColour)
+{
+	std::vector<glm::vec3> result(fog.inScattering.size());
+	for (size_t i = 0; i < result.size(); ++i)
+	{
+		const glm::vec3 surface = i < surfaceColour.size() ? surfaceColour[i] : glm::vec3(0.0f);
+		result[i] = glm::pow(glm::max(surface * fog.transmittance[i] + fog.inScattering[i], glm::vec3(0.0f)), glm::vec3(1.0f / 2.2f));
+	}
+	return result;
+}
+
+bool ReferenceRenderer::writePFM(const std::string& filePath, glm::uvec2 dim, const float* data, int numChannels)
+{
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "REFERENCE RENDERER ERROR: Couldn't open " << filePath << " for writing." << std::endl;
+		return false;
+	}
+
+	// A negative scale marks the data as little-endian:
+	file << (numChannels == 3 ? "PF" : "Pf") << "\n" << dim.x << " " << dim.y << "\n-1.0\n";
+	file.write((const char*)data, (size_t)dim.x * dim.y * numChannels * sizeof(float));
+
+	return true;
+}
+
+bool ReferenceRenderer::writePPM(const std::string& filePath, glm::uvec2 dim, const uint8_t* data)
+{
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "REFERENCE RENDERER ERROR: Couldn't open " << filePath << " for writing." << std::endl;
+		return false;
+	}
+
+	file << "P6\n" << dim.x << " " << dim.y << "\n255\n";
+	const size_t rowSize = (size_t)dim.x * 3;
+	for (unsigned int y = dim.y; y-- > 0;)
+		file.write((const char*)data + y * rowSize, rowSize);
+
+	return true;
+}
+
+float ReferenceRenderer::perlinNoise(glm::vec3 p)
+{
+	auto fade = [](float t) { return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f); };
+	auto lerp = [](float t, float a, float b) { return a + t * (b - a); };
+	auto grad = [](int hash, float x, float y, float z)
+	{
+		const int h = hash & 15;
+		const float u = h < 8 ? x : y,
+					v = h < 4 ? y : h == 12 || h == 14 ? x : z;
+		return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+	};
+
+	const int X = (int)std::floor(p.x) & 255,
+			  Y = (int)std::floor(p.y) & 255,
+			  Z = (int)std::floor(p.z) & 255;
+
+	// Isolate decimal values of p:
+	p -= glm::floor(p);
+
+	const float u = fade(p.x),
+				v = fade(p.y),
+				w = fade(p.z);
+
+	const int A = c_perm[X] + Y, AA = c_perm[A] + Z, AB = c_perm[A + 1] + Z,
+			  B = c_perm[X + 1] + Y, BA = c_perm[B] + Z, BB = c_perm[B + 1] + Z;
+
+	return lerp(w, lerp(v, lerp(u, grad(c_perm[AA], p.x, p.y, p.z),
+								   grad(c_perm[BA], p.x - 1, p.y, p.z)),
+						   lerp(u, grad(c_perm[AB], p.x, p.y - 1, p.z),
+								   grad(c_perm[BB], p.x - 1, p.y - 1, p.z))),
+				   lerp(v, lerp(u, grad(c_perm[AA + 1], p.x, p.y, p.z - 1),
+								   grad(c_perm[BA + 1], p.x - 1, p.y, p.z - 1)),
+						   lerp(u, grad(c_perm[AB + 1], p.x, p.y - 1, p.z - 1),
+								   grad(c_perm[BB + 1], p.x - 1, p.y - 1, p.z - 1))));
+}
+
+float ReferenceRenderer::phaseHG(float cosTheta, float g)
+{
+	const float denom = 1.0f + g * g - 2.0f * g * cosTheta;
+	return (1.0f - g * g) / (4.0f * c_pi * denom * std::sqrt(denom));
+}
+
+void ReferenceRenderer::buildBVH(BVH& bvh, const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs)
+{
+	const uint32_t numPrims = (uint32_t)mins.size();
+	bvh.nodes.clear();
+	bvh.indices.resize(numPrims);
+	for (uint32_t i = 0; i < numPrims; ++i)
+		bvh.indices[i] = i;
+
+	if (!numPrims)
+		return;
+
+	bvh.nodes.reserve(2 * numPrims);
+	bvh.nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), numPrims });
+
+	// Split nodes at the centroid median of their longest axis until leaves are small enough:
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty())
+	{
+		const uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+
+		const uint32_t first = bvh.nodes[nodeIndex].leftOrFirst, count = bvh.nodes[nodeIndex].count;
+		glm::vec3 boundsMin(c_infinity), boundsMax(-c_infinity), centroidMin(c_infinity), centroidMax(-c_infinity);
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			const uint32_t prim = bvh.indices[i];
+			boundsMin = glm::min(boundsMin, mins[prim]);
+			boundsMax = glm::max(boundsMax, maxs[prim]);
+			centroidMin = glm::min(centroidMin, mins[prim] + maxs[prim]);
+			centroidMax = glm::max(centroidMax, mins[prim] + maxs[prim]);
+		}
+		bvh.nodes[nodeIndex].min = boundsMin;
+		bvh.nodes[nodeIndex].max = boundsMax;
+
+		const glm::vec3 extent = centroidMax - centroidMin;
+		const int axis = extent.x > extent.y && extent.x > extent.z ? 0 : extent.y > extent.z ? 1 : 2;
+		if (count <= c_maxLeafSize || extent[axis] <= 0.0f)
+			continue;
+
+		const uint32_t half = count / 2;
+		std::nth_element(bvh.indices.begin() + first, bvh.indices.begin() + first + half, bvh.indices.begin() + first + count,
+			[&](uint32_t a, uint32_t b) { return mins[a][axis] + maxs[a][axis] < mins[b][axis] + maxs[b][axis]; });
+
+		const uint32_t left = (uint32_t)bvh.nodes.size();
+		bvh.nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), half });
+		bvh.nodes.push_back({ glm::vec3(0.0f), first + half, glm::vec3(0.0f), count - half });
+		bvh.nodes[nodeIndex].leftOrFirst = left;
+		bvh.nodes[nodeIndex].count = 0;
+
+		stack.push_back(left);
+		stack.push_back(left + 1);
+	}
+}
+
+ReferenceRenderer::Ray ReferenceRenderer::makeRay(glm::vec3 origin, glm::vec3 direction)
+{
+	Ray ray;
+	ray.origin = origin;
+	ray.direction = direction;
+	ray.invDirection = 1.0f / glm::vec3(
+		std::abs(direction.x) > 1e-12f ? direction.x : 1e-12f,
+		std::abs(direction.y) > 1e-12f ? direction.y : 1e-12f,
+		std::abs(direction.z) > 1e-12f ? direction.z : 1e-12f);
+	return ray;
+}
+
+// Moller-Trumbore, double sided:
+bool ReferenceRenderer::intersectTriangle(const Ray& ray, const Triangle& triangle, float tMax, float& t)
+{
+	const glm::vec3 p = glm::cross(ray.direction, triangle.edge2);
+	const float det = glm::dot(triangle.edge1, p);
+	if (std::abs(det) < 1e-12f)
+		return false;
+
+	const float invDet = 1.0f / det;
+	const glm::vec3 s = ray.origin - triangle.v0;
+	const float u = glm::dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	const glm::vec3 q = glm::cross(s, triangle.edge1);
+	const float v = glm::dot(ray.direction, q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	t = glm::dot(triangle.edge2, q) * invDet;
+	return t > 1e-4f && t < tMax;
+}
+
+bool ReferenceRenderer::intersectMesh(const MeshData& mesh, const Ray& ray, float& tMax, bool anyHit) const
+{
+	const BVH& bvh = mesh.bvh;
+	if (bvh.nodes.empty())
+		return false;
+
+	bool hit = false;
+	uint32_t stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize)
+	{
+		const BVHNode& node = bvh.nodes[stack[--stackSize]];
+		if (intersectBounds(ray.origin, ray.invDirection, node.min, node.max, tMax) == c_infinity)
+			continue;
+
+		if (node.count)
+		{
+			for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+			{
+				float t;
+				if (intersectTriangle(ray, mesh.triangles[bvh.indices[i]], tMax, t))
+				{
+					tMax = t;
+					hit = true;
+					if (anyHit)
+						return true;
+				}
+			}
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is visited next:
+		const BVHNode& left = bvh.nodes[node.leftOrFirst];
+		const BVHNode& right = bvh.nodes[node.leftOrFirst + 1];
+		const float tLeft = intersectBounds(ray.origin, ray.invDirection, left.min, left.max, tMax);
+		const float tRight = intersectBounds(ray.origin, ray.invDirection, right.min, right.max, tMax);
+		const bool leftFirst = tLeft <= tRight;
+		if ((leftFirst ? tRight : tLeft) != c_infinity)
+			stack[stackSize++] = leftFirst ? node.leftOrFirst + 1 : node.leftOrFirst;
+		if ((leftFirst ? tLeft : tRight) != c_infinity)
+			stack[stackSize++] = leftFirst ? node.leftOrFirst : node.leftOrFirst + 1;
+	}
+	return hit;
+}
+
+bool ReferenceRenderer::intersectScene(const Ray& ray, float& tMax, bool anyHit) const
+{
+	if (m_instanceBVH.nodes.empty())
+		return false;
+
+	bool hit = false;
+	uint32_t stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize)
+	{
+		const BVHNode& node = m_instanceBVH.nodes[stack[--stackSize]];
+		if (intersectBounds(ray.origin, ray.invDirection, node.min, node.max, tMax) == c_infinity)
+			continue;
+
+		if (node.count)
+		{
+			for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+			{
+				// Trace in the instance's object space. The direction isn't renormalised, so distances stay in world units:
+				const Instance& instance = m_instances[m_instanceBVH.indices[i]];
+				const Ray localRay = makeRay(glm::vec3(instance.invWorld * glm::vec4(ray.origin, 1.0f)), glm::vec3(instance.invWorld * glm::vec4(ray.direction, 0.0f)));
+				if (intersectMesh(m_meshes[instance.mesh], localRay, tMax, anyHit))
+				{
+					hit = true;
+					if (anyHit)
+						return true;
+				}
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.leftOrFirst + 1;
+		stack[stackSize++] = node.leftOrFirst;
+	}
+	return hit;
+}
+
+void ReferenceRenderer::getCoefficients(const Medium& medium, glm::vec3 pos, float& scattering, float& extinction) const
+{
+	float density = medium.density;
+	if (medium.heightFog)
+		density *= std::exp(-std::max(pos.y - medium.heightRange.x, 0.0f) / medium.heightRange.y);
+	if (medium.heterogeneous)
+		density *= glm::clamp(perlinNoise((pos + medium.noiseOffset) * medium.noiseFreq) * 0.5f + 0.5f, 0.0f, 1.0f);
+
+	scattering = medium.scattering * density;
+	extinction = (medium.scattering + medium.absorption) * density;
+}
+
+// Exact for homogeneous fog, otherwise an unbiased ratio tracking estimate against the constant density majorant (which
+// height fog, only ever thinning, stays under):
+float ReferenceRenderer::estimateTransmittance(const Medium& medium, glm::vec3 from, glm::vec3 to, uint32_t& rngState) const
+{
+	const float dist = glm::length(to - from);
+	const float majorant = (medium.scattering + medium.absorption) * medium.density;
+	if (!(medium.heterogeneous || medium.heightFog) || majorant <= 0.0f)
+		return std::exp(-majorant * dist);
+
+	const glm::vec3 dir = (to - from) / dist;
+	float transmittance = 1.0f;
+	float t = 0.0f;
+	while (true)
+	{
+		t -= std::log(1.0f - random(rngState)) / majorant;
+		if (t >= dist)
+			break;
+
+		float scattering, extinction;
+		getCoefficients(medium, from + dir * t, scattering, extinction);
+		transmittance *= 1.0f - extinction / majorant;
+	}
+	return transmittance;
+}
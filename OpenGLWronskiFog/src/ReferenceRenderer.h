@@ -0,0 +1,155 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+	Multithreaded CPU Monte Carlo single-scattering renderer for the fog scene, used as ground truth
+	for scoring the real-time froxel path. It evaluates the same participating medium (constant or
+	Perlin noise density, Henyey-Greenstein phase function, point lights with the same constant/
+	linear/quadratic attenuation) against the scene's actual triangles, so shadows come from exact
+	visibility rays rather than shadow maps.
+
+	Each pixel averages samplesPerPixel primary rays, jittered within the pixel. Each ray is marched
+	to the nearest surface (or the far plane, as the froxel volume is) in stepsPerSample steps at a
+	random offset, with one randomly chosen light evaluated per step. Transmittance towards the
+	light is included by default (ratio tracking through heterogeneous fog); the real-time path
+	ignores it, so it can be turned off to isolate the error of each shortcut.
+
+	Differences from the real-time shader, intentionally: the phase angle is measured against the
+	view ray (not the camera's forward vector) with the correct 3/2 exponent, in-scattering isn't
+	weighted by the albedo twice, and the noise uses Perlin's doubled permutation table.
+
+	Geometry is instanced: meshes are added once in object space and referenced by instances with
+	a world matrix, and rays are traced through a two-level BVH. Images are stored bottom row first,
+	matching glReadPixels().
+*/
+
+class ReferenceRenderer
+{
+public:
+	struct Light
+	{
+		glm::vec3	position;
+		glm::vec3	colour;		// Diffuse colour multiplied by intensity.
+		float		constant;
+		float		linear;
+		float		quadratic;
+		float		radius;		// Attenuation is windowed to nothing here, as the scatter shader's.
+	};
+
+	struct Medium
+	{
+		float		density;
+		float		scattering;
+		float		absorption;
+		float		phaseG;
+		glm::vec3	albedo = glm::vec3(1.0f);
+		bool		heterogeneous = false;
+		float		noiseFreq = 0.15f;
+		glm::vec3	noiseOffset = glm::vec3(0.0f);
+		bool		heightFog = false;
+		glm::vec2	heightRange = glm::vec2(0.0f, 10.0f);	// Base height, and the height the fog thins by a factor of e over above it.
+	};
+
+	struct Settings
+	{
+		glm::uvec2	resolution;
+		int			samplesPerPixel = 16;
+		int			stepsPerSample = 64;
+		int			numThreads = 0;				// 0 uses every hardware thread.
+		bool		lightTransmittance = true;	// Attenuate light by the fog between it and each scattering point.
+		uint32_t	seed = 1;
+	};
+
+	struct Image
+	{
+		glm::uvec2				dim;
+		std::vector<glm::vec3>	inScattering;	// Linear radiance scattered towards the camera.
+		std::vector<float>		transmittance;	// Fraction of the surface (or background) colour that reaches the camera.
+	};
+
+	// Scene setup. build() must be called after the last mesh/instance is added and before render():
+	int  addMesh(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+	void addInstance(int mesh, const glm::mat4& world);
+	void addLight(const Light& light)	{ m_lights.push_back(light); }
+	void clearLights()					{ m_lights.clear(); }
+	void clear();
+	void build();
+
+	size_t getNumTriangles() const;	// Across all instances.
+
+	Image render(const glm::mat4& view, const glm::mat4& proj, float farPlane, const Medium& medium, const Settings& settings) const;
+
+	// Combines fog with a linear surface colour image the same way fogCompositeShader does (including gamma):
+	static std::vector<glm::vec3> composite(const Image& fog, const std::vector<glm::vec3>& surfaceColour);
+
+	// Writes a 1 (greyscale) or 3 (RGB) channel little-endian PFM, rows bottom first:
+	static bool writePFM(const std::string& filePath, glm::uvec2 dim, const float* data, int numChannels);
+
+	// Writes an 8 bit RGB binary PPM from rows bottom first (as glReadPixels() returns them), flipping them to top first:
+	static bool writePPM(const std::string& filePath, glm::uvec2 dim, const uint8_t* data);
+
+	static float perlinNoise(glm::vec3 p);					// In [-1, 1].
+	static float phaseHG(float cosTheta, float g);
+
+private:
+	struct Ray
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+		glm::vec3 invDirection;
+	};
+
+	struct BVHNode
+	{
+		glm::vec3	min;
+		uint32_t	leftOrFirst;	// Left child (right child follows it) if count is zero, otherwise first primitive.
+		glm::vec3	max;
+		uint32_t	count;
+	};
+
+	struct BVH
+	{
+		std::vector<BVHNode>	nodes;
+		std::vector<uint32_t>	indices;	// Primitive indices, ordered so each leaf's primitives are contiguous.
+	};
+
+	struct Triangle
+	{
+		glm::vec3 v0;
+		glm::vec3 edge1;
+		glm::vec3 edge2;
+	};
+
+	struct MeshData
+	{
+		std::vector<Triangle>	triangles;
+		BVH						bvh;
+		glm::vec3				min;
+		glm::vec3				max;
+	};
+
+	struct Instance
+	{
+		int			mesh;
+		glm::mat4	world;
+		glm::mat4	invWorld;
+	};
+
+	static void buildBVH(BVH& bvh, const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs);
+	static Ray	makeRay(glm::vec3 origin, glm::vec3 direction);
+	static bool intersectTriangle(const Ray& ray, const Triangle& triangle, float tMax, float& t);
+
+	bool  intersectMesh(const MeshData& mesh, const Ray& ray, float& tMax, bool anyHit) const;
+	bool  intersectScene(const Ray& ray, float& tMax, bool anyHit) const;
+	void  getCoefficients(const Medium& medium, glm::vec3 pos, float& scattering, float& extinction) const;
+	float estimateTransmittance(const Medium& medium, glm::vec3 from, glm::vec3 to, uint32_t& rngState) const;
+
+	std::vector<MeshData>	m_meshes;
+	std::vector<Instance>	m_instances;
+	std::vector<Light>		m_lights;
+	BVH						m_instanceBVH;
+};
@@ -20,14 +20,8 @@ public:
 				// Activate and bind texture units in sequence:
 				glActiveTexture(GL_TEXTURE0 + i);
 
-				std::string number;
-				std::string name = mesh.m_textures[i].type;
-				if (name == "texture_diffuse")
-					number = std::to_string(diffuseIndex++);
-				else if (name == "texture_specular")
-					number = std::to_string(specularIndex++);
-
-				shader.setInt((name + number).c_str(), i);
+				const std::string name = SceneUtils::getTextureUniformName(mesh.m_textures[i].type, diffuseIndex, specularIndex);
+				shader.setInt(name.c_str(), i);
 				glBindTexture(GL_TEXTURE_2D, mesh.m_textures[i].id);
 			}
 
@@ -70,14 +64,8 @@ public:
 				// Activate and bind texture units in sequence:
 				glActiveTexture(GL_TEXTURE0 + i);
 
-				std::string number;
-				std::string name = mesh.m_textures[i].type;
-				if (name == "texture_diffuse")
-					number = std::to_string(diffuseIndex++);
-				else if (name == "texture_specular")
-					number = std::to_string(specularIndex++);
-
-				shader.setInt((name + number).c_str(), i);
+				const std::string name = SceneUtils::getTextureUniformName(mesh.m_textures[i].type, diffuseIndex, specularIndex);
+				shader.setInt(name.c_str(), i);
 				glBindTexture(GL_TEXTURE_2D, mesh.m_textures[i].id);
 			}
 
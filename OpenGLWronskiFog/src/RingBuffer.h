@@ -0,0 +1,66 @@
+#pragma once
+#include "GLErrorManager.h"
+#include "GPUResourceRegistry.h"
+#include "FramePacer.h"
+
+#include <cstring>
+#include <string>
+
+/*
+	Uniform buffer for data that changes every frame, split into one region per frame in flight.
+	Each frame writes only its FramePacer slot's region, which the pacer has already fenced, so
+	the region is mapped unsynchronised and the driver never has to wait for (or copy around) a
+	buffer the GPU may still be reading, as glBufferSubData on a single buffer would.
+
+	OpenGL 4.3 has no persistent mapping (glBufferStorage is 4.4), so the region is mapped and
+	unmapped once per frame instead: write() the whole frame's data, then bind() its region.
+*/
+
+class RingBuffer
+{
+public:
+	void init(GLuint bytesPerFrame, GPUResourceRegistry::Tag tag, const std::string& name)
+	{
+		// Every region has to start on a valid uniform buffer offset:
+		GLint alignment;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		m_size = bytesPerFrame;
+		m_stride = (bytesPerFrame + alignment - 1) / alignment * alignment;
+
+		glGenBuffers(1, &m_handle);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_handle);
+		glBufferData(GL_UNIFORM_BUFFER, m_stride * FramePacer::c_framesInFlight, NULL, GL_STREAM_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		GPUResourceRegistry::registerBuffer(m_handle, tag, name, m_stride * FramePacer::c_framesInFlight);
+	}
+
+	void release() { GPUResourceRegistry::deleteBuffer(m_handle); }
+
+	// Copies a frame's data into the slot's region:
+	void write(GLuint slot, const void* data)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_handle);
+		void* region = glMapBufferRange(GL_UNIFORM_BUFFER, slot * m_stride, m_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (region)
+		{
+			memcpy(region, data, m_size);
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+		}
+		else
+			std::cout << "RING BUFFER ERROR: Couldn't map frame region " << slot << " of buffer " << m_handle << std::endl;
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	// Binds the slot's region to a uniform block binding point:
+	void bind(GLuint slot, GLuint index) const
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, index, m_handle, slot * m_stride, m_size);
+	}
+
+	GLuint getHandle() const { return m_handle; }
+
+private:
+	GLuint m_handle = 0;
+	GLuint m_size = 0;
+	GLuint m_stride = 0;	// Size rounded up to the uniform buffer offset alignment.
+};
@@ -0,0 +1,186 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <assimp/scene.h>
+
+#include "Buffers.h"
+
+#include <string>
+#include <vector>
+
+/*
+	CPU-side scene setup and per-frame helpers that make no OpenGL calls, so they can be timed in
+	isolation by the microbenchmark project (OpenGLWronskiFogBench) as well as used by the App.
+*/
+
+class SceneUtils
+{
+public:
+	// The rand() results each asteroid is placed with, drawn up front so matrices can be built in any order:
+	struct AsteroidRandoms
+	{
+		int x, y, z;
+		int scale;
+		int rotation;
+	};
+
+	// Draws every asteroid's random numbers in the same order the asteroids have always been placed with:
+	static void drawAsteroidRandoms(AsteroidRandoms* randoms, GLuint count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			randoms[i].x = rand();
+			randoms[i].y = rand();
+			randoms[i].z = rand();
+			randoms[i].scale = rand();
+			randoms[i].rotation = rand();
+		}
+	}
+
+	// Builds world matrices [begin, end) of a ring of randomly placed, scaled and rotated asteroids (thread safe):
+	static void buildAsteroidMatrices(glm::mat4* worldMatrices, const AsteroidRandoms* randoms, size_t begin, size_t end, GLuint count, float radius, float offset)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			// Randomise distance to planet in range (-offset, offset):
+			float angle = (float)i / (float)count * 360.0f;
+			float displacement = (randoms[i].x % (int)(2 * offset * 100)) / 100.0f - offset;
+			float x = sin(angle) * radius + displacement;
+
+			displacement = (randoms[i].y % (int)(2 * offset * 100)) / 100.0f - offset;
+			float y = displacement * 0.4f;
+
+			displacement = (randoms[i].z % (int)(2 * offset * 100)) / 100.0f - offset;
+			float z = cos(angle) * radius + displacement;
+
+			glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
+
+			// Randomise scale in the range (0.05, 0.25):
+			float scale = (randoms[i].scale % 20) / 100.0f + 0.05f;
+			world = glm::scale(world, glm::vec3(scale));
+
+			// Randomise rotation around an arbitrary axis:
+			float rotAngle = (randoms[i].rotation % 360);
+			world = glm::rotate(world, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
+
+			worldMatrices[i] = world;
+		}
+	}
+
+	// Builds world matrices for the whole ring of asteroids on the calling thread (uses rand()):
+	static void buildAsteroidMatrices(glm::mat4* worldMatrices, GLuint count, float radius, float offset)
+	{
+		std::vector<AsteroidRandoms> randoms(count);
+		drawAsteroidRandoms(randoms.data(), count);
+		buildAsteroidMatrices(worldMatrices, randoms.data(), 0, count, count, radius, offset);
+	}
+
+	// Maps a sized or unsized texture format to the pixel data format used when creating the texture:
+	static GLenum getTextureInternalFormat(GLenum format)
+	{
+		GLenum internalFormat;
+
+		switch (format)
+		{
+		case GL_RED:
+		case GL_R16F:
+		case GL_R32F:
+			internalFormat = GL_RED;
+			break;
+		case GL_RG:
+		case GL_RG16F:
+		case GL_RG32F:
+			internalFormat = GL_RG;
+			break;
+		case GL_RGB:
+		case GL_RGB16F:
+		case GL_RGB32F:
+		case GL_R11F_G11F_B10F:
+			internalFormat = GL_RGB;
+			break;
+		case GL_RGBA:
+		case GL_RGBA16F:
+		case GL_RGBA32F:
+		default:
+			internalFormat = GL_RGBA;
+			break;
+		}
+		return internalFormat;
+	}
+
+	// Copies an Assimp mesh's positions, normals, tex coords and face indices into vertex/index arrays:
+	static void extractMeshData(const aiMesh* mesh, std::vector<VAO::Vertex>& vertices, std::vector<GLuint>& indices)
+	{
+		for (size_t i = 0; i < mesh->mNumVertices; i++)
+		{
+			VAO::Vertex vertex;
+			glm::vec3 vector;
+
+			// Position:
+			vector.x = mesh->mVertices[i].x;
+			vector.y = mesh->mVertices[i].y;
+			vector.z = mesh->mVertices[i].z;
+			vertex.position = vector;
+
+			// Normal (if present):
+			if (mesh->HasNormals())
+			{
+				vector.x = mesh->mNormals[i].x;
+				vector.y = mesh->mNormals[i].y;
+				vector.z = mesh->mNormals[i].z;
+				vertex.normal = vector;
+			}
+
+			// Tex coords (if present):
+			if (mesh->mTextureCoords[0])
+			{
+				glm::vec2 vec;
+				vec.x = mesh->mTextureCoords[0][i].x;
+				vec.y = mesh->mTextureCoords[0][i].y;
+				vertex.texCoords = vec;
+			}
+			else
+				vertex.texCoords = glm::vec2(0.0f, 0.0f);
+
+			vertices.push_back(vertex);
+		}
+		// Retrieve vertex indices by processing each mesh face (triangle):
+		for (size_t i = 0; i < mesh->mNumFaces; i++)
+		{
+			aiFace face = mesh->mFaces[i];
+			for (unsigned int j = 0; j < face.mNumIndices; j++)
+				indices.push_back(face.mIndices[j]);
+		}
+	}
+
+	// Collects the meshes of an Assimp node hierarchy in depth-first order, starting from the given node:
+	static void collectNodeMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes)
+	{
+		// Meshes at the current node:
+		for (size_t i = 0; i < node->mNumMeshes; i++)
+			meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+
+		// After all meshes in this node have been collected (if any), collect meshes in child nodes:
+		for (size_t i = 0; i < node->mNumChildren; i++)
+			collectNodeMeshes(node->mChildren[i], scene, meshes);
+	}
+
+	// Returns the sampler uniform name of a mesh texture ("texture_diffuse1", "texture_specular2", etc.),
+	// incrementing the per-type counter:
+	static std::string getTextureUniformName(const std::string& type, GLuint& diffuseIndex, GLuint& specularIndex)
+	{
+		std::string number;
+		if (type == "texture_diffuse")
+			number = std::to_string(diffuseIndex++);
+		else if (type == "texture_specular")
+			number = std::to_string(specularIndex++);
+
+		return type + number;
+	}
+
+	// Returns the name of an element of a uniform array, e.g. "u_lightMatrices[3]":
+	static std::string getArrayUniformName(const std::string& name, int index)
+	{
+		return name + "[" + std::to_string(index) + "]";
+	}
+};
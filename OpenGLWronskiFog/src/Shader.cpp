@@ -104,6 +104,11 @@ void Shader::setVec3(const std::string& name, float x, float y, float z) const
 	glUniform3f(glGetUniformLocation(m_ID, name.c_str()), x, y, z);
 }
 
+void Shader::setVec4(const std::string& name, glm::vec4 val) const
+{
+	glUniform4f(glGetUniformLocation(m_ID, name.c_str()), val.x, val.y, val.z, val.w);
+}
+
 void Shader::setMat3(const std::string& name, glm::mat3 val) const
 {
 	glUniformMatrix3fv(glGetUniformLocation(m_ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(val));
@@ -126,7 +131,7 @@ void Shader::setPointLight(const std::string& name, PointLight light) const
 	glUniform1f(glGetUniformLocation(m_ID, (name + ".radius").c_str()), light.getRadius());
 }
 
-GLuint Shader::setupStage(const char* path, GLuint type)
+std::string Shader::readSource(const std::string& path, int includeDepth)
 {
 	// Containers for shader code and file streams:
 	std::string code;
@@ -151,7 +156,37 @@ GLuint Shader::setupStage(const char* path, GLuint type)
 	catch (std::ifstream::failure e)
 	{
 		std::cout << "SHADER FILE NOT SUCCESSFULLY READ\n(" << path << ")\n\n";
+		return code;
 	}
+
+	// Replace each #include "file" line with the file's source, found relative to this file:
+	const std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+	std::istringstream codeStream(code);
+	std::string source, line;
+	while (std::getline(codeStream, line))
+	{
+		const size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+		{
+			source += line + '\n';
+			continue;
+		}
+
+		const size_t open = line.find('"', start), close = line.find('"', open + 1);
+		if (open == std::string::npos || close == std::string::npos || includeDepth >= c_maxIncludeDepth)
+		{
+			std::cout << "SHADER INCLUDE ERROR (" << path << "): " << line << "\n\n";
+			continue;
+		}
+		source += readSource(directory + line.substr(open + 1, close - open - 1), includeDepth + 1);
+	}
+
+	return source;
+}
+
+GLuint Shader::setupStage(const char* path, GLuint type)
+{
+	const std::string code = readSource(path);
 	const char* shaderCode = code.c_str();
 
 	unsigned int shaderHandle;
@@ -36,11 +36,17 @@ public:
 	void setVec2(const std::string& name, float x, float y) const;
 	void setVec3(const std::string& name, glm::vec3 val) const;
 	void setVec3(const std::string& name, float x, float y, float z) const;
+	void setVec4(const std::string& name, glm::vec4 val) const;
 	void setMat3(const std::string& name, glm::mat3 val) const;
 	void setMat4(const std::string& name, glm::mat4 val) const;
 	void setPointLight(const std::string& name, PointLight light) const;
 
 private:
+	// Nested includes deeper than this are taken to be recursive:
+	static const int c_maxIncludeDepth = 8;
+
+	// The file's source, with #include "file" lines replaced by the named files' sources:
+	std::string readSource(const std::string& path, int includeDepth = 0);
 	GLuint setupStage(const char* path, GLuint type);
 	void linkShader(const char* path);
 };
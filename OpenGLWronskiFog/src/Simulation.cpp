@@ -0,0 +1,117 @@
+#include "Simulation.h"
+
+#include <chrono>
+
+#include "CPUProfiler.h"
+
+void Simulation::start(const Input& input)
+{
+	if (isThreaded())
+		return;
+
+	m_input = input;
+	m_running = true;
+	m_thread = std::thread(&Simulation::threadMain, this);
+}
+
+void Simulation::stop()
+{
+	if (!isThreaded())
+		return;
+
+	m_running = false;
+	m_thread.join();
+	m_stepsPerSecond = 0.0f;
+}
+
+void Simulation::setInput(const Input& input)
+{
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+	m_input = input;
+}
+
+const FrameState& Simulation::acquire()
+{
+	m_frames.update();
+	return m_frames.getReadBuffer();
+}
+
+const FrameState& Simulation::step(const Input& input, float dt)
+{
+	advance(input, dt, m_frames.getWriteBuffer());
+	m_frames.publish();
+	return acquire();
+}
+
+void Simulation::threadMain()
+{
+	CPUProfiler::setThreadName("Simulation");
+
+	using Clock = std::chrono::steady_clock;
+	const Clock::duration timestep = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(c_timestep));
+
+	Clock::time_point nextTick = Clock::now();
+	Clock::time_point rateStart = nextTick;
+	uint64_t rateSteps = 0;
+
+	while (m_running)
+	{
+		std::this_thread::sleep_until(nextTick);
+
+		Input input;
+		{
+			std::lock_guard<std::mutex> lock(m_inputMutex);
+			input = m_input;
+		}
+
+		// Catch up on any ticks missed, but give up rather than spiral if the simulation can't keep up:
+		int steps = 0;
+		const Clock::time_point now = Clock::now();
+		while (nextTick <= now && steps < c_maxStepsPerTick)
+		{
+			advance(input, c_timestep, m_frames.getWriteBuffer());
+			nextTick += timestep;
+			++steps;
+		}
+		if (nextTick <= now)
+			nextTick = now + timestep;
+
+		if (steps)
+			m_frames.publish();
+
+		// Measured step rate, for the GUI:
+		rateSteps += steps;
+		const double rateSeconds = std::chrono::duration<double>(now - rateStart).count();
+		if (rateSeconds >= 0.5)
+		{
+			m_stepsPerSecond.store((float)(rateSteps / rateSeconds), std::memory_order_relaxed);
+			rateStart = now;
+			rateSteps = 0;
+		}
+	}
+}
+
+void Simulation::advance(const Input& input, double dt, FrameState& state)
+{
+	PROFILE_FUNCTION();
+
+	// Start from the latest settings, then fill in what the simulation owns:
+	state = input.settings;
+
+	if (input.noiseOffsetVersion != m_noiseOffsetVersion)
+	{
+		m_noiseOffset = input.settings.noiseOffset;
+		m_noiseOffsetVersion = input.noiseOffsetVersion;
+	}
+	m_noiseOffset += input.windDirection * (float)dt;
+	state.noiseOffset = m_noiseOffset;
+
+	// Rebuild light space matrices for lights that changed:
+	m_lights.copySettings(input.settings.lights);
+	m_lights.updateMatrices();
+	state.lights = m_lights;
+
+	m_time += dt;
+	state.step = ++m_step;
+	state.time = m_time;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "FrameState.h"
+#include "TripleBuffer.h"
+
+/*
+	Per-frame scene simulation: fog animation (wind moving the noise) and light space matrix
+	rebuilds, producing one immutable FrameState per step. It makes no OpenGL calls.
+
+	Threaded, the simulation runs at a fixed timestep on its own thread, taking the latest input
+	the GL thread posted with setInput() and publishing each step's FrameState through a triple
+	buffer; the GL thread picks up the newest snapshot with acquire() and never waits on the
+	simulation (or the other way round). If a tick falls behind, it catches up with several steps
+	before publishing, up to c_maxStepsPerTick.
+
+	Synchronously, step() advances by the caller's timestep on the caller's thread instead. That's
+	used whenever frames must be repeatable (benchmarks and camera tracks), as a threaded step
+	count depends on wall clock timing.
+
+	Light matrices are kept in the simulation's own LightManager between steps, so only lights that
+	moved (or all of them, if the light view planes changed) are rebuilt each step.
+
+	Input is whatever the user, benchmark or camera track set this frame. The noise offset is also
+	advanced by the simulation, so input only replaces it when its noiseOffsetVersion changes.
+*/
+
+class Simulation
+{
+public:
+	struct Input
+	{
+		FrameState settings;				// Everything but the step count, time and light matrices.
+		glm::vec3  windDirection;
+		uint32_t   noiseOffsetVersion = 0;	// Bump to replace the simulated noise offset with settings.noiseOffset.
+	};
+
+	static constexpr double c_timestep = 1.0 / 120.0;
+	static const int		c_maxStepsPerTick = 8;
+
+	~Simulation() { stop(); }
+
+	void start(const Input& input);		// Launches the simulation thread.
+	void stop();						// Joins the simulation thread, if running.
+	bool isThreaded() const				{ return m_thread.joinable(); }
+
+	void setInput(const Input& input);	// Threaded: input for the next step.
+	const FrameState& acquire();		// Threaded: the newest published snapshot, valid until the next acquire().
+	const FrameState& step(const Input& input, float dt);	// Synchronous: advances by dt, returning the new snapshot.
+
+	float getStepsPerSecond() const		{ return m_stepsPerSecond.load(std::memory_order_relaxed); }
+
+private:
+	void threadMain();
+	void advance(const Input& input, double dt, FrameState& state);
+
+	TripleBuffer<FrameState> m_frames;
+
+	std::thread				m_thread;
+	std::atomic<bool>		m_running{ false };
+	std::mutex				m_inputMutex;
+	Input					m_input;
+	std::atomic<float>		m_stepsPerSecond{ 0.0f };
+
+	// Simulation state carried between steps (only touched by whichever thread is stepping):
+	uint64_t				m_step = 0;
+	double					m_time = 0.0;
+	glm::vec3				m_noiseOffset = glm::vec3(0.0f);
+	uint32_t				m_noiseOffsetVersion = 0;
+	LightManager			m_lights;
+};
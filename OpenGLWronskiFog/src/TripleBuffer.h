@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+
+/*
+	Lock-free single producer, single consumer triple buffer. The producer fills the write buffer
+	and publishes it; the consumer picks up the newest published buffer whenever it likes. Neither
+	side ever waits for the other: the producer always has a free buffer to write into, and the
+	consumer keeps reading the same buffer until it asks for a newer one. Published buffers the
+	consumer never picked up are simply overwritten.
+
+	The third (shared) buffer sits between the two. Publishing swaps the write buffer with it and
+	flags it as new; updating swaps the read buffer with it if the flag is set.
+*/
+
+template<typename T>
+class TripleBuffer
+{
+public:
+	// Producer side:
+	T&	 getWriteBuffer()	{ return m_buffers[m_writeIndex]; }
+	void publish()			{ m_writeIndex = m_shared.exchange(m_writeIndex | c_newBit, std::memory_order_acq_rel) & c_indexMask; }
+
+	// Consumer side. update() swaps in the newest published buffer, returning false if there isn't one:
+	bool update()
+	{
+		if (!(m_shared.load(std::memory_order_relaxed) & c_newBit))
+			return false;
+
+		m_readIndex = m_shared.exchange(m_readIndex, std::memory_order_acq_rel) & c_indexMask;
+		return true;
+	}
+	const T& getReadBuffer() const { return m_buffers[m_readIndex]; }
+
+private:
+	static const int c_indexMask = 3;
+	static const int c_newBit = 4;
+
+	T				 m_buffers[3];
+	int				 m_writeIndex = 0;
+	std::atomic<int> m_shared{ 1 };
+	int				 m_readIndex = 2;
+};
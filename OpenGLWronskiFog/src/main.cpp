@@ -1,4 +1,6 @@
 #include <iostream>
+#include <sstream>
+#include <string>
 #include "App.h"
 
 struct CallbackData
@@ -18,25 +20,108 @@ void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void mouseCallback(GLFWwindow* window, double xPos, double yPos);
 void scrollCallback(GLFWwindow* window, double xOffset, double yOffset);
 
-int main()
+static const char* const c_usage =
+	"Command line options:\n"
+	"  --benchmark <file>         Runs the scenario file unattended, then exits.\n"
+	"  --benchmark-output <dir>   Overrides the scenario file's output directory.\n"
+	"  --size <width> <height>    Render resolution (default 1920 1080).\n"
+	"  --headless                 Renders offscreen with no window, GUI or input (surfaceless EGL on Linux), then exits.\n"
+	"  --frames <n>               Headless: frames to render (default 300), unless a benchmark ends first.\n"
+	"  --timestep <seconds>       Headless: fixed timestep per frame (default 1/60).\n"
+	"  --output <prefix>          Headless: writes frames to <prefix>_00000.ppm, <prefix>_00001.ppm, ...\n"
+	"  --output-every <n>         Headless: only writes every nth frame.\n"
+	"  --camera-track <file>      Headless: plays a recorded camera track, looping.\n";
+
+// Parses a whole argument as a number above zero, leaving the value as it was otherwise:
+template<typename T>
+static bool parsePositive(const char* text, T& value)
 {
-	App app(1920, 1080);
-	if (app.init(4, 3))
+	std::istringstream stream(text);
+	T parsed = 0;
+	stream >> parsed;
+	if (stream.fail() || !(stream >> std::ws).eof() || !(parsed > 0))
+		return false;
+
+	value = parsed;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	// Command line options (see c_usage):
+	std::string benchmarkFilePath, benchmarkOutputDir;
+	int width = 1920, height = 1080;
+	bool headless = false;
+	App::HeadlessSettings headlessSettings;
+	bool validArgs = true;
+	for (int i = 1; i < argc; ++i)
 	{
-		// Get pointers to data used in GLFW callback functions:
-		g_callbackData.camPtr = app.getCameraPtr();
-		g_callbackData.winWidthPtr = app.getScreenWidthPtr();
-		g_callbackData.winHeightPtr = app.getScreenHeightPtr();
-		g_callbackData.hasRightClickedPtr = app.getHasRightClickedPtr();
+		const std::string arg = argv[i];
+		if (arg == "--benchmark" && i + 1 < argc)
+			benchmarkFilePath = argv[++i];
+		else if (arg == "--benchmark-output" && i + 1 < argc)
+			benchmarkOutputDir = argv[++i];
+		else if (arg == "--size" && i + 2 < argc)
+		{
+			validArgs = parsePositive(argv[i + 1], width) && parsePositive(argv[i + 2], height);
+			i += 2;
+		}
+		else if (arg == "--headless")
+			headless = true;
+		else if (arg == "--frames" && i + 1 < argc)
+			validArgs = parsePositive(argv[++i], headlessSettings.frames);
+		else if (arg == "--timestep" && i + 1 < argc)
+			validArgs = parsePositive(argv[++i], headlessSettings.timestep);
+		else if (arg == "--output" && i + 1 < argc)
+			headlessSettings.outputPrefix = argv[++i];
+		else if (arg == "--output-every" && i + 1 < argc)
+			validArgs = parsePositive(argv[++i], headlessSettings.outputEvery);
+		else if (arg == "--camera-track" && i + 1 < argc)
+			headlessSettings.cameraTrackPath = argv[++i];
+		else
+		{
+			std::cout << "Unknown command line argument (or missing value): " << arg << std::endl << c_usage;
+			return 1;
+		}
+
+		if (!validArgs)
+		{
+			std::cout << "Invalid value for " << arg << std::endl << c_usage;
+			return 1;
+		}
+	}
 
-		// Setup callback functions:
-		glfwSetFramebufferSizeCallback(app.getWindowPtr(), framebufferSizeCallback);
-		glfwSetCursorPosCallback(app.getWindowPtr(), mouseCallback);
-		glfwSetScrollCallback(app.getWindowPtr(), scrollCallback);
+	App app(width, height);
+	if (headless)
+		app.setHeadless(headlessSettings);
 
+	// Nothing rendered is a failure, so batch runs (CI) don't pass without output:
+	if (!app.init(4, 3))
+		return 1;
+
+	if (!benchmarkFilePath.empty() && !app.loadUnattendedBenchmark(benchmarkFilePath, benchmarkOutputDir))
+		return 1;
+
+	// Headless, there's no window to take callbacks from:
+	if (headless)
+	{
 		app.run();
+		return 0;
 	}
 
+	// Get pointers to data used in GLFW callback functions:
+	g_callbackData.camPtr = app.getCameraPtr();
+	g_callbackData.winWidthPtr = app.getScreenWidthPtr();
+	g_callbackData.winHeightPtr = app.getScreenHeightPtr();
+	g_callbackData.hasRightClickedPtr = app.getHasRightClickedPtr();
+
+	// Setup callback functions:
+	glfwSetFramebufferSizeCallback(app.getWindowPtr(), framebufferSizeCallback);
+	glfwSetCursorPosCallback(app.getWindowPtr(), mouseCallback);
+	glfwSetScrollCallback(app.getWindowPtr(), scrollCallback);
+
+	app.run();
+
 	return 0;
 }
 
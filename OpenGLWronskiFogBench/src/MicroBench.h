@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+	Minimal CPU microbenchmark runner. Each benchmark is calibrated so that one sample (a batch of
+	calls) takes at least c_minSampleNs, then timed over a number of samples. Heap allocations are
+	counted by the global operator new replacement in main.cpp, so every result reports allocations
+	and bytes per call alongside time.
+*/
+
+class MicroBench
+{
+public:
+	struct Result
+	{
+		std::string name;
+		uint64_t	calls;			// Total timed calls across all samples.
+		double		medianNs;		// Per call.
+		double		minNs;
+		double		meanNs;
+		double		allocsPerCall;
+		double		bytesPerCall;
+	};
+
+	static const uint64_t c_minSampleNs = 200000;	// 0.2ms per sample.
+
+	// Updated by the global operator new replacement:
+	inline static std::atomic<uint64_t> s_numAllocations{ 0 };
+	inline static std::atomic<uint64_t> s_allocatedBytes{ 0 };
+
+	// Stops the compiler optimising away a benchmark's result, by making it look read (and memory clobbered) where
+	// the compiler can't see what happens to it:
+	template<typename T>
+	static void doNotOptimize(const T& value)
+	{
+#ifdef _MSC_VER
+		// No inline assembly on x64, so escape the value's address and read it through a volatile:
+		static const void* volatile s_sink;
+		s_sink = &value;
+		(void)*reinterpret_cast<const volatile char*>(&value);
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	template<typename Func>
+	static Result run(const std::string& name, int numSamples, Func&& func)
+	{
+		// Calibrate the batch size (which also warms caches and the allocator):
+		uint64_t batch = 1;
+		while (timeBatch(func, batch) < c_minSampleNs && batch < (1ull << 30))
+			batch *= 2;
+
+		// Reserved up front so that the sample storage isn't counted:
+		std::vector<double> sampleNs;
+		sampleNs.reserve(numSamples);
+
+		const uint64_t allocationsBefore = s_numAllocations.load(std::memory_order_relaxed);
+		const uint64_t bytesBefore = s_allocatedBytes.load(std::memory_order_relaxed);
+
+		for (int i = 0; i < numSamples; ++i)
+			sampleNs.push_back((double)timeBatch(func, batch) / batch);
+
+		const uint64_t calls = batch * numSamples;
+		const uint64_t allocations = s_numAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+		const uint64_t bytes = s_allocatedBytes.load(std::memory_order_relaxed) - bytesBefore;
+
+		Result result;
+		result.name = name;
+		result.calls = calls;
+
+		std::sort(sampleNs.begin(), sampleNs.end());
+		result.medianNs = sampleNs[sampleNs.size() / 2];
+		result.minNs = sampleNs.front();
+		result.meanNs = 0.0;
+		for (double ns : sampleNs)
+			result.meanNs += ns / sampleNs.size();
+
+		result.allocsPerCall = (double)allocations / calls;
+		result.bytesPerCall = (double)bytes / calls;
+
+		return result;
+	}
+
+private:
+	template<typename Func>
+	static uint64_t timeBatch(Func& func, uint64_t batch)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < batch; ++i)
+			func();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+};
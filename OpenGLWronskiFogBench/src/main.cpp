@@ -0,0 +1,314 @@
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "LightManager.h"
+#include "MicroBench.h"
+#include "SceneUtils.h"
+
+/*
+	Microbenchmarks for the App's CPU-side hot paths. Runs without a window or OpenGL context, since
+	everything benchmarked lives in SceneUtils and LightManager, which make no OpenGL calls.
+
+	Command line options:
+		--filter <text>			Only runs benchmarks whose name contains <text>.
+		--samples <n>			Timed samples per benchmark (default 30).
+		--csv <file>			Writes results as CSV (can be used as a baseline later).
+		--baseline <file>		Compares against a previous CSV, failing (exit code 1) if any
+								benchmark allocates more per call, or its median time regressed by
+								more than the tolerance.
+		--tolerance <fraction>	Allowed median time regression against the baseline (default 0.1).
+*/
+
+// Count every heap allocation made by the process:
+void* operator new(size_t size)
+{
+	MicroBench::s_numAllocations.fetch_add(1, std::memory_order_relaxed);
+	MicroBench::s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+// Builds a grid mesh with positions, normals and tex coords, like a loaded OBJ:
+static aiMesh* createGridMesh(unsigned int gridDim)
+{
+	aiMesh* mesh = new aiMesh();
+	mesh->mNumVertices = gridDim * gridDim;
+	mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+	mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+	mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+	mesh->mNumUVComponents[0] = 2;
+
+	for (unsigned int y = 0; y < gridDim; ++y)
+		for (unsigned int x = 0; x < gridDim; ++x)
+		{
+			const unsigned int i = y * gridDim + x;
+			mesh->mVertices[i] = aiVector3D((float)x, 0.0f, (float)y);
+			mesh->mNormals[i] = aiVector3D(0.0f, 1.0f, 0.0f);
+			mesh->mTextureCoords[0][i] = aiVector3D((float)x / gridDim, (float)y / gridDim, 0.0f);
+		}
+
+	// Two triangles per grid cell:
+	mesh->mNumFaces = 2 * (gridDim - 1) * (gridDim - 1);
+	mesh->mFaces = new aiFace[mesh->mNumFaces];
+	unsigned int face = 0;
+	for (unsigned int y = 0; y + 1 < gridDim; ++y)
+		for (unsigned int x = 0; x + 1 < gridDim; ++x)
+		{
+			const unsigned int i = y * gridDim + x;
+			const unsigned int triangles[2][3] = { { i, i + gridDim, i + 1 }, { i + 1, i + gridDim, i + gridDim + 1 } };
+			for (const auto& triangle : triangles)
+			{
+				mesh->mFaces[face].mNumIndices = 3;
+				mesh->mFaces[face].mIndices = new unsigned int[3]{ triangle[0], triangle[1], triangle[2] };
+				++face;
+			}
+		}
+	return mesh;
+}
+
+// Builds a scene whose root has numChildren child nodes, each referencing its own small mesh:
+static aiScene* createScene(unsigned int numChildren, unsigned int gridDim)
+{
+	aiScene* scene = new aiScene();
+	scene->mNumMeshes = numChildren;
+	scene->mMeshes = new aiMesh*[numChildren];
+
+	scene->mRootNode = new aiNode();
+	scene->mRootNode->mNumChildren = numChildren;
+	scene->mRootNode->mChildren = new aiNode*[numChildren];
+
+	for (unsigned int i = 0; i < numChildren; ++i)
+	{
+		scene->mMeshes[i] = createGridMesh(gridDim);
+
+		aiNode* node = new aiNode();
+		node->mParent = scene->mRootNode;
+		node->mNumMeshes = 1;
+		node->mMeshes = new unsigned int[1]{ i };
+		scene->mRootNode->mChildren[i] = node;
+	}
+	return scene;
+}
+
+static bool loadBaseline(const std::string& filePath, std::vector<MicroBench::Result>& baseline)
+{
+	std::ifstream file(filePath);
+	if (!file)
+	{
+		std::cout << "BENCH ERROR: Couldn't open baseline " << filePath << std::endl;
+		return false;
+	}
+
+	std::string line;
+	std::getline(file, line);	// Header.
+	while (std::getline(file, line))
+	{
+		std::vector<std::string> fields;
+		std::stringstream stream(line);
+		std::string field;
+		while (std::getline(stream, field, ','))
+			fields.push_back(field);
+
+		if (fields.size() != 7)
+			continue;
+
+		MicroBench::Result result;
+		result.name = fields[0];
+		result.calls = std::stoull(fields[1]);
+		result.medianNs = std::stod(fields[2]);
+		result.minNs = std::stod(fields[3]);
+		result.meanNs = std::stod(fields[4]);
+		result.allocsPerCall = std::stod(fields[5]);
+		result.bytesPerCall = std::stod(fields[6]);
+		baseline.push_back(result);
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::string filter, csvPath, baselinePath;
+	int numSamples = 30;
+	double tolerance = 0.1;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--filter" && i + 1 < argc)
+			filter = argv[++i];
+		else if (arg == "--samples" && i + 1 < argc)
+			numSamples = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--csv" && i + 1 < argc)
+			csvPath = argv[++i];
+		else if (arg == "--baseline" && i + 1 < argc)
+			baselinePath = argv[++i];
+		else if (arg == "--tolerance" && i + 1 < argc)
+			tolerance = std::atof(argv[++i]);
+		else
+		{
+			std::cout << "Unknown command line argument: " << arg << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector<MicroBench::Result> results;
+	auto bench = [&](const std::string& name, auto&& func) {
+		if (filter.empty() || name.find(filter) != std::string::npos)
+			results.push_back(MicroBench::run(name, numSamples, func));
+	};
+
+	// Scene data matching the App's:
+	const GLuint asteroidsCount = 10000;
+	const int numLights = 4;
+	const glm::vec3 lightPositions[numLights] = { glm::vec3(0.0f, 3.0f, 10.0f), glm::vec3(0.0f, 3.0f, 50.0f),
+												  glm::vec3(50.0f, 1.0f, 10.0f), glm::vec3(-5.0f, 0.0f, -50.0f) };
+	const glm::vec2 lightPlanes = glm::vec2(0.1f, 100.0f);
+	const GLenum textureFormats[] = { GL_RGBA32F, GL_RGBA32F, GL_RGBA32F, GL_R32F, GL_RG32F, GL_RGBA16F, GL_RGB, GL_RED };
+	const std::vector<std::string> textureTypes = { "texture_diffuse", "texture_specular", "texture_diffuse" };
+
+	aiMesh* largeMesh = createGridMesh(512);	// 262144 vertices, 522242 triangles.
+	aiScene* scene = createScene(1000, 16);		// 1000 nodes with 256-vertex meshes.
+
+	// App::setupMatrices():
+	bench("Asteroid matrices (10000 asteroids)", [&] {
+		std::vector<glm::mat4> worldMatrices(asteroidsCount);
+		SceneUtils::buildAsteroidMatrices(worldMatrices.data(), asteroidsCount, 50.0f, 2.5f);
+		MicroBench::doNotOptimize(worldMatrices[asteroidsCount - 1]);
+	});
+
+	// Simulation::step() light matrices, with every light moved so all of them are rebuilt:
+	LightManager lightManager;
+	lightManager.setNumActive(numLights);
+	lightManager.setViewPlanes(lightPlanes);
+	float lightOffset = 0.0f;
+	bench("Light space matrices (4 lights)", [&] {
+		lightOffset = lightOffset == 0.0f ? 0.5f : 0.0f;
+		for (int i = 0; i < numLights; ++i)
+			lightManager.setPosition(i, lightPositions[i] + glm::vec3(lightOffset, 0.0f, 0.0f));
+		MicroBench::doNotOptimize(lightManager.updateMatrices());
+		MicroBench::doNotOptimize(lightManager.getMatrices(numLights - 1)[5]);
+	});
+
+	// App::createTexture() format resolution:
+	bench("Texture internal formats (8 textures)", [&] {
+		GLenum combined = 0;
+		for (GLenum format : textureFormats)
+			combined ^= SceneUtils::getTextureInternalFormat(format);
+		MicroBench::doNotOptimize(combined);
+	});
+
+	// Model::processMesh():
+	bench("Mesh data extraction (262144 vertices)", [&] {
+		std::vector<VAO::Vertex> vertices;
+		std::vector<GLuint> indices;
+		SceneUtils::extractMeshData(largeMesh, vertices, indices);
+		MicroBench::doNotOptimize(indices.back());
+	});
+
+	// Model::processNode() and processMesh() over a node hierarchy:
+	bench("Node traversal and extraction (1000 nodes)", [&] {
+		std::vector<const aiMesh*> meshes;
+		SceneUtils::collectNodeMeshes(scene->mRootNode, scene, meshes);
+		for (const aiMesh* mesh : meshes)
+		{
+			std::vector<VAO::Vertex> vertices;
+			std::vector<GLuint> indices;
+			SceneUtils::extractMeshData(mesh, vertices, indices);
+			MicroBench::doNotOptimize(indices.back());
+		}
+	});
+
+	// Renderer::draw() sampler names for a mesh with three textures:
+	bench("Texture uniform names (3 textures)", [&] {
+		GLuint diffuseIndex = 1, specularIndex = 1;
+		for (const std::string& type : textureTypes)
+		{
+			const std::string name = SceneUtils::getTextureUniformName(type, diffuseIndex, specularIndex);
+			MicroBench::doNotOptimize(name);
+		}
+	});
+
+	// App::update() uniform array names (point lights, then light matrices for three shaders):
+	bench("Light uniform names (4 lights)", [&] {
+		for (int i = 0; i < numLights; ++i)
+		{
+			const std::string name = SceneUtils::getArrayUniformName("u_pointLights", i);
+			MicroBench::doNotOptimize(name);
+		}
+		for (int shader = 0; shader < 3; ++shader)
+			for (int i = 0; i < 6 * numLights; ++i)
+			{
+				const std::string name = SceneUtils::getArrayUniformName("u_lightMatrices", i);
+				MicroBench::doNotOptimize(name);
+			}
+	});
+
+	delete largeMesh;
+	delete scene;
+
+	// Print results:
+	std::cout << std::left << std::setw(46) << "Benchmark" << std::right << std::setw(14) << "Median (ns)" << std::setw(14) << "Min (ns)"
+		<< std::setw(14) << "Allocs/call" << std::setw(14) << "Bytes/call" << "\n";
+	std::cout << std::fixed << std::setprecision(1);
+	for (const MicroBench::Result& result : results)
+		std::cout << std::left << std::setw(46) << result.name << std::right << std::setw(14) << result.medianNs << std::setw(14) << result.minNs
+			<< std::setw(14) << result.allocsPerCall << std::setw(14) << result.bytesPerCall << "\n";
+
+	if (!csvPath.empty())
+	{
+		std::ofstream csv(csvPath);
+		csv << std::setprecision(6) << "name,calls,medianNs,minNs,meanNs,allocsPerCall,bytesPerCall\n";
+		for (const MicroBench::Result& result : results)
+			csv << result.name << "," << result.calls << "," << result.medianNs << "," << result.minNs << "," << result.meanNs << ","
+				<< result.allocsPerCall << "," << result.bytesPerCall << "\n";
+		std::cout << "Wrote results to " << csvPath << std::endl;
+	}
+
+	// Compare against a baseline, allocation counts exactly and times within the tolerance:
+	int numRegressions = 0;
+	std::vector<MicroBench::Result> baseline;
+	if (!baselinePath.empty())
+	{
+		if (!loadBaseline(baselinePath, baseline))
+			return 1;
+
+		for (const MicroBench::Result& result : results)
+			for (const MicroBench::Result& base : baseline)
+			{
+				if (base.name != result.name)
+					continue;
+
+				if (result.allocsPerCall > base.allocsPerCall + 1e-6)
+				{
+					std::cout << "REGRESSION: " << result.name << " allocates " << result.allocsPerCall << " times per call (baseline " << base.allocsPerCall << ")\n";
+					++numRegressions;
+				}
+				if (result.medianNs > base.medianNs * (1.0 + tolerance))
+				{
+					std::cout << "REGRESSION: " << result.name << " median " << result.medianNs << "ns (baseline " << base.medianNs << "ns)\n";
+					++numRegressions;
+				}
+			}
+		std::cout << numRegressions << " regressions against " << baselinePath << std::endl;
+	}
+
+	return numRegressions ? 1 : 0;
+}